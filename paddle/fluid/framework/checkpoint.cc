@@ -0,0 +1,967 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/checkpoint.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <set>
+#include <thread>
+#include <unordered_map>
+
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/tensor_util.h"
+
+DEFINE_int32(checkpoint_threads,
+             0,
+             "The number of threads writing and reading the payloads of a "
+             "checkpoint file, or 0 for one per core.");
+
+namespace paddle {
+namespace fluid {
+namespace framework {
+
+namespace {
+
+constexpr char kMagic[8] = "PDCKPT";
+constexpr uint32_t kVersion = 1;
+// The payloads are written and read in pieces of at most this size, so
+// that the threads share the work of a large tensor.
+constexpr uint64_t kPieceBytes = 16 << 20;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_entries;
+  uint64_t index_size;
+  uint64_t file_size;
+};
+
+uint64_t Align(uint64_t offset) {
+  return (offset + kCheckpointAlignment - 1) / kCheckpointAlignment *
+         kCheckpointAlignment;
+}
+
+template <typename T>
+void Append(std::string* buf, const T& value) {
+  buf->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Reads the index, checking that it does not run past its end.
+class IndexReader {
+ public:
+  IndexReader(const char* begin, size_t size)
+      : pos_(begin), end_(begin + size) {}
+
+  template <typename T>
+  T Read() {
+    T value;
+    std::memcpy(&value, Bytes(sizeof(value)), sizeof(value));
+    return value;
+  }
+
+  const char* Bytes(size_t size) {
+    PADDLE_ENFORCE_LE(size,
+                      static_cast<size_t>(end_ - pos_),
+                      "The checkpoint index is truncated.");
+    const char* bytes = pos_;
+    pos_ += size;
+    return bytes;
+  }
+
+ private:
+  const char* pos_;
+  const char* end_;
+};
+
+void CheckHeader(const Header& header,
+                 uint64_t file_size,
+                 const std::string& path) {
+  PADDLE_ENFORCE(std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0,
+                 "%s is not a checkpoint.",
+                 path);
+  PADDLE_ENFORCE_LE(header.version,
+                    kVersion,
+                    "Only versions up to %d are supported",
+                    kVersion);
+  PADDLE_ENFORCE_EQ(
+      header.file_size, file_size, "The checkpoint %s is truncated.", path);
+  PADDLE_ENFORCE_LE(header.index_size,
+                    file_size - sizeof(Header),
+                    "The checkpoint index is truncated.");
+}
+
+std::string SerializeIndex(
+    const std::vector<std::pair<std::string, CheckpointEntry>>& entries) {
+  std::string index;
+  for (auto& item : entries) {
+    const CheckpointEntry& entry = item.second;
+    Append(&index, static_cast<uint32_t>(item.first.size()));
+    index.append(item.first);
+    Append(&index, static_cast<int32_t>(entry.type));
+    std::string desc = entry.desc.SerializeAsString();
+    Append(&index, static_cast<int32_t>(desc.size()));
+    index.append(desc);
+    Append(&index, static_cast<uint64_t>(entry.lod.size()));
+    for (auto& level : entry.lod) {
+      uint64_t size = level.size() * sizeof(LoD::value_type::value_type);
+      Append(&index, size);
+      index.append(reinterpret_cast<const char*>(level.data()), size);
+    }
+    Append(&index, entry.height);
+    Append(&index, entry.rows_offset);
+    Append(&index, entry.rows_size);
+    Append(&index, entry.offset);
+    Append(&index, entry.size);
+  }
+  return index;
+}
+
+std::map<std::string, CheckpointEntry> ParseIndex(const Header& header,
+                                                  const char* index) {
+  std::map<std::string, CheckpointEntry> entries;
+  IndexReader reader(index, header.index_size);
+  auto check_payload = [&](uint64_t offset, uint64_t size) {
+    return offset % kCheckpointAlignment == 0 && offset <= header.file_size &&
+           size <= header.file_size - offset;
+  };
+  for (uint32_t i = 0; i < header.num_entries; ++i) {
+    auto name_size = reader.Read<uint32_t>();
+    std::string name(reader.Bytes(name_size), name_size);
+    CheckpointEntry& entry = entries[name];
+    if (header.version >= 1) {
+      entry.type = static_cast<proto::VarType::Type>(reader.Read<int32_t>());
+      PADDLE_ENFORCE(entry.type == proto::VarType::LOD_TENSOR ||
+                         entry.type == proto::VarType::SELECTED_ROWS,
+                     "%s has an unsupported type %d.",
+                     name,
+                     entry.type);
+    }
+    auto desc_size = reader.Read<int32_t>();
+    PADDLE_ENFORCE(
+        entry.desc.ParseFromArray(reader.Bytes(desc_size), desc_size),
+        "Cannot parse tensor desc");
+    entry.lod.resize(reader.Read<uint64_t>());
+    for (auto& level : entry.lod) {
+      auto level_size = reader.Read<uint64_t>();
+      const char* offsets = reader.Bytes(level_size);
+      std::vector<size_t> tmp(level_size / sizeof(size_t));
+      std::memcpy(tmp.data(), offsets, tmp.size() * sizeof(size_t));
+      level = tmp;
+    }
+    if (header.version >= 1) {
+      entry.height = reader.Read<int64_t>();
+      entry.rows_offset = reader.Read<uint64_t>();
+      entry.rows_size = reader.Read<uint64_t>();
+      PADDLE_ENFORCE(check_payload(entry.rows_offset, entry.rows_size),
+                     "The rows of %s are out of the checkpoint.",
+                     name);
+    }
+    entry.offset = reader.Read<uint64_t>();
+    entry.size = reader.Read<uint64_t>();
+    PADDLE_ENFORCE(check_payload(entry.offset, entry.size),
+                   "The payload of %s is out of the checkpoint.",
+                   name);
+  }
+  return entries;
+}
+
+DDim EntryDims(const CheckpointEntry& entry) {
+  std::vector<int64_t> dims(entry.desc.dims().begin(),
+                            entry.desc.dims().end());
+  return make_ddim(dims);
+}
+
+void CheckEntrySize(const std::string& name, const CheckpointEntry& entry) {
+  PADDLE_ENFORCE_EQ(entry.size,
+                    static_cast<uint64_t>(product(EntryDims(entry))) *
+                        SizeOfType(ToTypeIndex(entry.desc.data_type())),
+                    "The size of %s does not match its dims.",
+                    name);
+  PADDLE_ENFORCE_EQ(entry.rows_size % sizeof(int64_t),
+                    0UL,
+                    "The rows of %s are truncated.",
+                    name);
+}
+
+// Calls fn(i) for each i in [0, n) on FLAGS_checkpoint_threads threads,
+// and rethrows the first error.
+void ParallelFor(size_t n, const std::function<void(size_t)>& fn) {
+  size_t threads = FLAGS_checkpoint_threads > 0
+                       ? static_cast<size_t>(FLAGS_checkpoint_threads)
+                       : std::thread::hardware_concurrency();
+  threads = std::max<size_t>(1, std::min(threads, n));
+  std::atomic<size_t> next(0);
+  std::mutex mutex;
+  std::exception_ptr error;
+  auto work = [&] {
+    for (size_t i = next++; i < n; i = next++) {
+      try {
+        fn(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error) error = std::current_exception();
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < threads; ++t) workers.emplace_back(work);
+  work();
+  for (auto& worker : workers) worker.join();
+  if (error) std::rethrow_exception(error);
+}
+
+// A range of a payload and where it is in the file.
+struct Piece {
+  char* data;
+  uint64_t size;
+  uint64_t offset;
+};
+
+void AppendPieces(char* data,
+                  uint64_t size,
+                  uint64_t offset,
+                  std::vector<Piece>* pieces) {
+  for (uint64_t begin = 0; begin < size; begin += kPieceBytes) {
+    pieces->push_back(Piece{
+        data + begin, std::min(kPieceBytes, size - begin), offset + begin});
+  }
+}
+
+void WriteAt(int fd, const void* data, size_t size, uint64_t offset) {
+  auto* bytes = static_cast<const char*>(data);
+  while (size > 0) {
+    ssize_t written = pwrite(fd, bytes, size, static_cast<off_t>(offset));
+    if (written < 0 && errno == EINTR) continue;
+    PADDLE_ENFORCE_GT(
+        written, 0, "Cannot write the checkpoint: %s", std::strerror(errno));
+    bytes += written;
+    size -= static_cast<size_t>(written);
+    offset += static_cast<uint64_t>(written);
+  }
+}
+
+void ReadAt(int fd, void* data, size_t size, uint64_t offset) {
+  auto* bytes = static_cast<char*>(data);
+  while (size > 0) {
+    ssize_t read = pread(fd, bytes, size, static_cast<off_t>(offset));
+    if (read < 0 && errno == EINTR) continue;
+    PADDLE_ENFORCE_GT(
+        read, 0, "Cannot read the checkpoint: %s", std::strerror(errno));
+    bytes += read;
+    size -= static_cast<size_t>(read);
+    offset += static_cast<uint64_t>(read);
+  }
+}
+
+// Closes the file if an error is thrown before it is closed.
+struct FileCloser {
+  explicit FileCloser(int fd) : fd(fd) {}
+  ~FileCloser() {
+    if (fd >= 0) close(fd);
+  }
+
+  int fd;
+};
+
+// Removes a partly written file unless released.
+struct FileRemover {
+  explicit FileRemover(const std::string& path) : path(path) {}
+  ~FileRemover() {
+    if (!path.empty()) unlink(path.c_str());
+  }
+
+  std::string path;
+};
+
+double SecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// A variable to save.
+struct SaveItem {
+  std::string name;
+  CheckpointEntry entry;
+  Tensor value;
+  const Vector<int64_t>* rows = nullptr;  // of a SelectedRows
+};
+
+SaveItem MakeSaveItem(const std::string& name,
+                      proto::VarType::Type type,
+                      const Tensor& value,
+                      const LoD& lod) {
+  PADDLE_ENFORCE(value.IsInitialized(), "%s is not initialized.", name);
+  SaveItem item;
+  item.name = name;
+  item.entry.type = type;
+  item.entry.desc.set_data_type(ToDataType(value.type()));
+  for (auto dim : vectorize(value.dims())) item.entry.desc.add_dims(dim);
+  QuantizationToDesc(value, &item.entry.desc);
+  item.entry.lod = lod;
+  item.entry.size = value.numel() * SizeOfType(value.type());
+  item.value = value;
+  return item;
+}
+
+// Flushes the entry of path in its directory to disk.
+void SyncDirectory(const std::string& path) {
+  size_t slash = path.rfind('/');
+  std::string dir =
+      slash == std::string::npos ? "." : path.substr(0, slash + 1);
+  int fd = open(dir.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_GE(fd, 0, "Cannot open %s: %s", dir, std::strerror(errno));
+  FileCloser closer(fd);
+  PADDLE_ENFORCE_EQ(
+      fsync(fd), 0, "Cannot sync %s: %s", dir, std::strerror(errno));
+}
+
+// Writes the items into a file beside path, and flushes it to disk before
+// it replaces path, so that a crash leaves either checkpoint whole.
+CheckpointStats WriteCheckpoint(const std::string& path,
+                                std::vector<SaveItem>* items) {
+  auto start = std::chrono::steady_clock::now();
+  std::sort(
+      items->begin(), items->end(), [](const SaveItem& a, const SaveItem& b) {
+        return a.name < b.name;
+      });
+
+  // Make the payloads dense and bring them to the host.
+  ParallelFor(items->size(), [&](size_t i) {
+    Tensor& value = (*items)[i].value;
+    value = value.Contiguous();
+    if (!platform::is_cpu_place(value.place())) {
+      Tensor cpu;
+      TensorCopySync(value, platform::CPUPlace(), &cpu);
+      value = cpu;
+    }
+  });
+
+  // The size of the index does not depend on the offsets it holds, so
+  // they are laid out after a first pass with zeros.
+  std::vector<std::pair<std::string, CheckpointEntry>> entries;
+  for (auto& item : *items) entries.emplace_back(item.name, item.entry);
+  uint64_t file_size = Align(sizeof(Header) + SerializeIndex(entries).size());
+  for (auto& item : entries) {
+    CheckpointEntry& entry = item.second;
+    entry.offset = file_size;
+    file_size = Align(file_size + entry.size);
+    if (entry.type == proto::VarType::SELECTED_ROWS) {
+      entry.rows_offset = file_size;
+      file_size = Align(file_size + entry.rows_size);
+    }
+  }
+  std::string index = SerializeIndex(entries);
+
+  Header header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.num_entries = static_cast<uint32_t>(entries.size());
+  header.index_size = index.size();
+  header.file_size = file_size;
+
+  std::vector<Piece> pieces;
+  for (size_t i = 0; i < items->size(); ++i) {
+    SaveItem& item = (*items)[i];
+    const CheckpointEntry& entry = entries[i].second;
+    if (entry.size > 0) {
+      auto* data = const_cast<void*>(
+          static_cast<const Tensor&>(item.value).data<void>());
+      AppendPieces(
+          static_cast<char*>(data), entry.size, entry.offset, &pieces);
+    }
+    if (entry.rows_size > 0) {
+      auto* rows = const_cast<int64_t*>(item.rows->data());
+      AppendPieces(reinterpret_cast<char*>(rows),
+                   entry.rows_size,
+                   entry.rows_offset,
+                   &pieces);
+    }
+  }
+
+  std::string tmp_path = path + ".tmp";
+  int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  PADDLE_ENFORCE_GE(
+      fd, 0, "Cannot open %s: %s", tmp_path, std::strerror(errno));
+  FileRemover remover(tmp_path);
+  FileCloser closer(fd);
+  // Sized up front, with the padding after the last payload, so that the
+  // pieces can be written in any order.
+  PADDLE_ENFORCE_EQ(ftruncate(fd, static_cast<off_t>(file_size)),
+                    0,
+                    "Cannot write the checkpoint: %s",
+                    std::strerror(errno));
+  WriteAt(fd, &header, sizeof(header), 0);
+  WriteAt(fd, index.data(), index.size(), sizeof(header));
+  ParallelFor(pieces.size(), [&](size_t i) {
+    WriteAt(fd, pieces[i].data, pieces[i].size, pieces[i].offset);
+  });
+  PADDLE_ENFORCE_EQ(
+      fsync(fd), 0, "Cannot sync %s: %s", tmp_path, std::strerror(errno));
+  closer.fd = -1;
+  PADDLE_ENFORCE_EQ(close(fd), 0, "Cannot close %s", tmp_path);
+  PADDLE_ENFORCE_EQ(std::rename(tmp_path.c_str(), path.c_str()),
+                    0,
+                    "Cannot rename %s to %s: %s",
+                    tmp_path,
+                    path,
+                    std::strerror(errno));
+  remover.path.clear();
+  SyncDirectory(path);
+
+  CheckpointStats stats;
+  for (auto& item : entries) {
+    stats.bytes += item.second.size + item.second.rows_size;
+  }
+  stats.seconds = SecondsSince(start);
+  return stats;
+}
+
+// Adds a variable of the scope to the items to save, whole.
+void AddSaveItem(const Scope& scope,
+                 const std::string& name,
+                 std::vector<SaveItem>* items) {
+  Variable* var = scope.FindVar(name);
+  PADDLE_ENFORCE_NOT_NULL(var, "Cannot find variable %s", name);
+  if (var->IsType<LoDTensor>()) {
+    auto& tensor = var->Get<LoDTensor>();
+    items->push_back(
+        MakeSaveItem(name, proto::VarType::LOD_TENSOR, tensor, tensor.lod()));
+  } else if (var->IsType<SelectedRows>()) {
+    auto& selected_rows = var->Get<SelectedRows>();
+    items->push_back(MakeSaveItem(
+        name, proto::VarType::SELECTED_ROWS, selected_rows.value(), LoD()));
+    items->back().entry.height = selected_rows.height();
+    items->back().entry.rows_size =
+        selected_rows.rows().size() * sizeof(int64_t);
+    items->back().rows = &selected_rows.rows();
+  } else {
+    PADDLE_THROW("%s is neither a LoDTensor nor a SelectedRows.", name);
+  }
+}
+
+uint64_t RowBytes(const Tensor& value) {
+  const DDim& dims = value.dims();
+  return static_cast<uint64_t>(product(slice_ddim(dims, 1, dims.size()))) *
+         SizeOfType(value.type());
+}
+
+// Copies the rows at indices of value into a tensor on the host.
+Tensor GatherRows(const Tensor& value, const std::vector<int64_t>& indices) {
+  PADDLE_ENFORCE(value.quantization() == nullptr,
+                 "Deltas of quantized tables are not supported.");
+  DDim dims = value.dims();
+  dims[0] = static_cast<int64_t>(indices.size());
+  Tensor gathered;
+  gathered.Resize(dims);
+  auto* dst = static_cast<char*>(
+      gathered.mutable_data(platform::CPUPlace(), value.type()));
+  uint64_t row_bytes = RowBytes(value);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    Tensor row = value.Slice(indices[i], indices[i] + 1);
+    if (!platform::is_cpu_place(row.place())) {
+      Tensor cpu;
+      TensorCopySync(row, platform::CPUPlace(), &cpu);
+      row = cpu;
+    }
+    std::memcpy(dst + i * row_bytes,
+                static_cast<const Tensor&>(row).data<void>(),
+                row_bytes);
+  }
+  return gathered;
+}
+
+// Writes the rows of delta into table, by key, on the host.
+void MergeRows(const SelectedRows& delta, SelectedRows* table) {
+  const Tensor& src = delta.value();
+  Tensor* dst = table->mutable_value();
+  uint64_t row_bytes = RowBytes(src);
+  if (dst->IsInitialized()) {
+    PADDLE_ENFORCE(dst->type() == src.type(),
+                   "The delta has another type than the table.");
+    PADDLE_ENFORCE_EQ(row_bytes,
+                      RowBytes(*dst),
+                      "The delta has other rows than the table.");
+  }
+
+  auto* rows = table->mutable_rows();
+  std::unordered_map<int64_t, size_t> indices;
+  for (size_t i = 0; i < rows->size(); ++i) indices.emplace((*rows)[i], i);
+  std::vector<size_t> targets;
+  for (int64_t key : delta.rows()) {
+    auto it = indices.emplace(key, rows->size()).first;
+    if (it->second == rows->size()) rows->push_back(key);
+    targets.push_back(it->second);
+  }
+
+  int64_t capacity = dst->IsInitialized() ? dst->dims()[0] : 0;
+  if (static_cast<int64_t>(rows->size()) > capacity) {
+    DDim dims = src.dims();
+    dims[0] = static_cast<int64_t>(rows->size());
+    Tensor grown;
+    grown.Resize(dims);
+    void* data = grown.mutable_data(platform::CPUPlace(), src.type());
+    if (capacity > 0) {
+      std::memcpy(data,
+                  static_cast<const Tensor&>(*dst).data<void>(),
+                  capacity * row_bytes);
+    }
+    *dst = grown;
+  }
+  auto* dst_data =
+      static_cast<char*>(dst->mutable_data(platform::CPUPlace(), src.type()));
+  auto* src_data = static_cast<const char*>(src.data<void>());
+  for (size_t i = 0; i < targets.size(); ++i) {
+    std::memcpy(
+        dst_data + targets[i] * row_bytes, src_data + i * row_bytes, row_bytes);
+  }
+  table->set_height(delta.height());
+}
+
+// Hands the live tensor a copy-on-write copy of its memory block, and
+// returns a tensor holding the block, which is not written any more through
+// the live tensor.  Tensors sharing the block with it are not affected.
+Tensor Freeze(Tensor* live) {
+  Tensor frozen;
+  frozen.ShareDataWith(*live);
+  live->CopyOnWriteFrom(frozen);
+  return frozen;
+}
+
+// The dirty rows a snapshot took from a SelectedRows.
+struct TakenRows {
+  SelectedRows* selected_rows;
+  std::vector<int64_t> indices;
+};
+
+std::vector<TakenRows> TakeDirtyRows(const Scope& scope,
+                                     const std::vector<std::string>& names) {
+  std::vector<TakenRows> taken;
+  for (auto& name : names) {
+    Variable* var = scope.FindVar(name);
+    if (var != nullptr && var->IsType<SelectedRows>()) {
+      auto* selected_rows = var->GetMutable<SelectedRows>();
+      taken.push_back({selected_rows, selected_rows->TakeDirtyRows()});
+    }
+  }
+  return taken;
+}
+
+void RestoreDirtyRows(const std::vector<TakenRows>& taken) {
+  for (auto& item : taken) {
+    for (int64_t index : item.indices) item.selected_rows->MarkDirty(index);
+  }
+}
+
+// Writes a snapshot, and marks the rows it took dirty again if it fails.
+CheckpointStats WriteSnapshot(const std::string& path,
+                              std::vector<SaveItem>* items,
+                              const std::vector<TakenRows>& taken) {
+  try {
+    return WriteCheckpoint(path, items);
+  } catch (...) {
+    RestoreDirtyRows(taken);
+    throw;
+  }
+}
+
+}  // namespace
+
+void SaveCheckpoint(const std::string& path,
+                    const std::map<std::string, LoDTensor>& tensors) {
+  std::vector<SaveItem> items;
+  for (auto& item : tensors) {
+    items.push_back(MakeSaveItem(item.first,
+                                 proto::VarType::LOD_TENSOR,
+                                 item.second,
+                                 item.second.lod()));
+  }
+  WriteCheckpoint(path, &items);
+}
+
+CheckpointStats SaveScope(const std::string& path,
+                          const Scope& scope,
+                          const std::vector<std::string>& names) {
+  std::vector<SaveItem> items;
+  for (auto& name : names) AddSaveItem(scope, name, &items);
+  CheckpointStats stats =
+      WriteSnapshot(path, &items, TakeDirtyRows(scope, names));
+  VLOG(1) << "Saved " << names.size() << " variables into " << path << " at "
+          << stats.MBPerSecond() << " MB/s";
+  return stats;
+}
+
+CheckpointStats SaveScopeDelta(const std::string& path,
+                               const Scope& scope,
+                               const std::vector<std::string>& names) {
+  std::vector<SaveItem> items;
+  // The keys of the dirty rows, pointed to by the items.
+  std::vector<std::unique_ptr<Vector<int64_t>>> keys;
+  std::vector<TakenRows> taken;
+  size_t dirty = 0;
+  CheckpointStats stats;
+  // The items are built from the rows taken, so the rows taken so far are
+  // marked again whatever fails.
+  try {
+    for (auto& name : names) {
+      Variable* var = scope.FindVar(name);
+      if (var == nullptr || !var->IsType<SelectedRows>()) {
+        AddSaveItem(scope, name, &items);
+        continue;
+      }
+      auto* selected_rows = var->GetMutable<SelectedRows>();
+      auto& rows = selected_rows->rows();
+      taken.push_back({selected_rows, selected_rows->TakeDirtyRows()});
+      std::vector<int64_t> indices = taken.back().indices;
+      // The value may hold more rows than there are keys.
+      indices.erase(std::lower_bound(indices.begin(),
+                                     indices.end(),
+                                     static_cast<int64_t>(rows.size())),
+                    indices.end());
+      std::vector<int64_t> dirty_keys;
+      for (int64_t index : indices) dirty_keys.push_back(rows[index]);
+      keys.emplace_back(new Vector<int64_t>(dirty_keys));
+      dirty += indices.size();
+
+      items.push_back(MakeSaveItem(name,
+                                   proto::VarType::SELECTED_ROWS,
+                                   GatherRows(selected_rows->value(), indices),
+                                   LoD()));
+      items.back().entry.height = selected_rows->height();
+      items.back().entry.rows_size = indices.size() * sizeof(int64_t);
+      items.back().rows = keys.back().get();
+    }
+    stats = WriteCheckpoint(path, &items);
+  } catch (...) {
+    RestoreDirtyRows(taken);
+    throw;
+  }
+  VLOG(1) << "Saved a delta of " << dirty << " rows into " << path << " at "
+          << stats.MBPerSecond() << " MB/s";
+  return stats;
+}
+
+CheckpointStats LoadScope(const std::string& path,
+                          const std::vector<std::string>& names,
+                          const platform::Place& place,
+                          Scope* scope) {
+  auto start = std::chrono::steady_clock::now();
+  int fd = open(path.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_GE(fd, 0, "Cannot open %s: %s", path, std::strerror(errno));
+  FileCloser closer(fd);
+  struct stat st;
+  PADDLE_ENFORCE_EQ(
+      fstat(fd, &st), 0, "Cannot stat %s: %s", path, std::strerror(errno));
+  uint64_t file_size = static_cast<uint64_t>(st.st_size);
+  PADDLE_ENFORCE_GE(file_size, sizeof(Header), "%s is not a checkpoint.", path);
+  Header header;
+  ReadAt(fd, &header, sizeof(header), 0);
+  CheckHeader(header, file_size, path);
+  std::string index(header.index_size, '\0');
+  ReadAt(fd, &index[0], index.size(), sizeof(header));
+  auto entries = ParseIndex(header, index.data());
+
+  // Allocate the variables on the host, then fill them in pieces.
+  std::vector<Piece> pieces;
+  // The host tensors to be copied to place, and their destinations.
+  std::vector<std::pair<std::unique_ptr<Tensor>, Tensor*>> copies;
+  CheckpointStats stats;
+  for (auto& name : names) {
+    auto it = entries.find(name);
+    PADDLE_ENFORCE(it != entries.end(), "%s is not in the checkpoint.", name);
+    const CheckpointEntry& entry = it->second;
+    CheckEntrySize(name, entry);
+    Variable* var = scope->Var(name);
+    Tensor* value;
+    if (entry.type == proto::VarType::SELECTED_ROWS) {
+      auto* selected_rows = var->GetMutable<SelectedRows>();
+      selected_rows->set_height(entry.height);
+      auto* rows = selected_rows->mutable_rows();
+      rows->resize(entry.rows_size / sizeof(int64_t));
+      AppendPieces(reinterpret_cast<char*>(rows->data()),
+                   entry.rows_size,
+                   entry.rows_offset,
+                   &pieces);
+      value = selected_rows->mutable_value();
+    } else {
+      auto* tensor = var->GetMutable<LoDTensor>();
+      tensor->set_lod(entry.lod);
+      value = tensor;
+    }
+    Tensor* host = value;
+    if (!platform::is_cpu_place(place)) {
+      copies.emplace_back(std::unique_ptr<Tensor>(new Tensor), value);
+      host = copies.back().first.get();
+    }
+    host->Resize(EntryDims(entry));
+    void* data = host->mutable_data(platform::CPUPlace(),
+                                    ToTypeIndex(entry.desc.data_type()));
+    QuantizationFromDesc(entry.desc, host);
+    AppendPieces(static_cast<char*>(data), entry.size, entry.offset, &pieces);
+    stats.bytes += entry.size + entry.rows_size;
+  }
+  ParallelFor(pieces.size(), [&](size_t i) {
+    ReadAt(fd, pieces[i].data, pieces[i].size, pieces[i].offset);
+  });
+  ParallelFor(copies.size(), [&](size_t i) {
+    TensorCopySync(*copies[i].first, place, copies[i].second);
+  });
+
+  stats.seconds = SecondsSince(start);
+  VLOG(1) << "Loaded " << names.size() << " variables from " << path << " at "
+          << stats.MBPerSecond() << " MB/s";
+  return stats;
+}
+
+CheckpointStats CompactCheckpoint(const std::string& base,
+                                  const std::vector<std::string>& deltas,
+                                  const std::string& path) {
+  auto start = std::chrono::steady_clock::now();
+  Scope scope;
+  std::vector<std::string> base_names = MappedCheckpoint(base).Names();
+  LoadScope(base, base_names, platform::CPUPlace(), &scope);
+  std::set<std::string> names(base_names.begin(), base_names.end());
+  for (auto& delta : deltas) {
+    std::vector<std::string> delta_names = MappedCheckpoint(delta).Names();
+    Scope delta_scope;
+    LoadScope(delta, delta_names, platform::CPUPlace(), &delta_scope);
+    for (auto& name : delta_names) {
+      Variable* src = delta_scope.FindVar(name);
+      Variable* dst = scope.Var(name);
+      if (src->IsType<SelectedRows>()) {
+        PADDLE_ENFORCE(!names.count(name) || dst->IsType<SelectedRows>(),
+                       "%s is saved as another type.",
+                       name);
+        MergeRows(src->Get<SelectedRows>(), dst->GetMutable<SelectedRows>());
+      } else {
+        *dst->GetMutable<LoDTensor>() = src->Get<LoDTensor>();
+      }
+      names.insert(name);
+    }
+  }
+  CheckpointStats stats = SaveScope(
+      path, scope, std::vector<std::string>(names.begin(), names.end()));
+  stats.seconds = SecondsSince(start);
+  VLOG(1) << "Compacted " << deltas.size() << " deltas into " << path;
+  return stats;
+}
+
+struct AsyncCheckpointer::Job {
+  std::string path;
+  std::vector<SaveItem> items;
+  // The rows of the SelectedRows, pointed to by the items.
+  std::vector<std::unique_ptr<Vector<int64_t>>> rows;
+  // The dirty rows taken by the snapshot, marked again if it fails.
+  std::vector<TakenRows> taken;
+  std::chrono::steady_clock::time_point start;
+  CheckpointStats stats;
+  std::exception_ptr error;
+};
+
+AsyncCheckpointer::AsyncCheckpointer() {}
+
+AsyncCheckpointer::~AsyncCheckpointer() {
+  if (writer_.joinable()) writer_.join();
+  if (job_ != nullptr && job_->error) {
+    try {
+      std::rethrow_exception(job_->error);
+    } catch (std::exception& e) {
+      LOG(ERROR) << "Cannot write " << job_->path << ": " << e.what();
+    }
+  }
+}
+
+void AsyncCheckpointer::Save(const std::string& path,
+                             const Scope& scope,
+                             const std::vector<std::string>& names) {
+  auto start = std::chrono::steady_clock::now();
+  if (job_ != nullptr) Wait();
+
+  std::unique_ptr<Job> job(new Job);
+  job->path = path;
+  job->start = start;
+  // A variable failing the snapshot gives back the rows taken before it.
+  try {
+    for (auto& name : names) {
+      Variable* var = scope.FindVar(name);
+      PADDLE_ENFORCE_NOT_NULL(var, "Cannot find variable %s", name);
+      if (var->IsType<LoDTensor>()) {
+        auto* tensor = var->GetMutable<LoDTensor>();
+        job->items.push_back(MakeSaveItem(
+            name, proto::VarType::LOD_TENSOR, *tensor, tensor->lod()));
+        job->items.back().value = Freeze(tensor);
+      } else if (var->IsType<SelectedRows>()) {
+        auto* selected_rows = var->GetMutable<SelectedRows>();
+        job->items.push_back(MakeSaveItem(name,
+                                          proto::VarType::SELECTED_ROWS,
+                                          selected_rows->value(),
+                                          LoD()));
+        SaveItem& item = job->items.back();
+        item.value = Freeze(selected_rows->mutable_value());
+        item.entry.height = selected_rows->height();
+        job->rows.emplace_back(new Vector<int64_t>(selected_rows->rows()));
+        item.entry.rows_size = job->rows.back()->size() * sizeof(int64_t);
+        item.rows = job->rows.back().get();
+        job->taken.push_back({selected_rows, selected_rows->TakeDirtyRows()});
+      } else {
+        PADDLE_THROW("%s is neither a LoDTensor nor a SelectedRows.", name);
+      }
+    }
+  } catch (...) {
+    RestoreDirtyRows(job->taken);
+    throw;
+  }
+  job->stats.stall_seconds = SecondsSince(start);
+
+  job_ = std::move(job);
+  Job* pending = job_.get();
+  writer_ = std::thread([pending] {
+    try {
+      pending->stats.bytes =
+          WriteCheckpoint(pending->path, &pending->items).bytes;
+      pending->stats.seconds = SecondsSince(pending->start);
+    } catch (...) {
+      pending->error = std::current_exception();
+    }
+    // Release the frozen blocks as soon as they are written.
+    pending->items.clear();
+    pending->rows.clear();
+  });
+}
+
+CheckpointStats AsyncCheckpointer::Wait() {
+  PADDLE_ENFORCE_NOT_NULL(job_, "No checkpoint is being saved.");
+  auto start = std::chrono::steady_clock::now();
+  if (writer_.joinable()) writer_.join();
+  std::unique_ptr<Job> job = std::move(job_);
+  if (job->error) {
+    RestoreDirtyRows(job->taken);
+    std::rethrow_exception(job->error);
+  }
+  job->stats.stall_seconds += SecondsSince(start);
+  VLOG(1) << "Saved " << job->path << " at " << job->stats.MBPerSecond()
+          << " MB/s, blocking for " << job->stats.stall_seconds << " s";
+  return job->stats;
+}
+
+struct MappedCheckpoint::Mapping {
+  Mapping(void* ptr, size_t size) : ptr(ptr), size(size) {}
+  ~Mapping() {
+    if (size > 0) munmap(ptr, size);
+  }
+
+  void* ptr;
+  size_t size;
+};
+
+MappedCheckpoint::MappedCheckpoint(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_GE(fd, 0, "Cannot open %s: %s", path, std::strerror(errno));
+  // The mapping keeps the file open once the descriptor is closed.
+  FileCloser closer(fd);
+  struct stat st;
+  PADDLE_ENFORCE_EQ(
+      fstat(fd, &st), 0, "Cannot stat %s: %s", path, std::strerror(errno));
+  size_t size = static_cast<size_t>(st.st_size);
+  PADDLE_ENFORCE_GE(size, sizeof(Header), "%s is not a checkpoint.", path);
+  void* ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  PADDLE_ENFORCE(
+      ptr != MAP_FAILED, "Cannot mmap %s: %s", path, std::strerror(errno));
+  mapping_.reset(new Mapping(ptr, size));
+
+  const char* base = static_cast<const char*>(ptr);
+  Header header;
+  std::memcpy(&header, base, sizeof(header));
+  CheckHeader(header, size, path);
+  entries_ = ParseIndex(header, base + sizeof(Header));
+}
+
+std::vector<std::string> MappedCheckpoint::Names() const {
+  std::vector<std::string> names;
+  for (auto& item : entries_) names.push_back(item.first);
+  return names;
+}
+
+bool MappedCheckpoint::Has(const std::string& name) const {
+  return entries_.count(name) != 0;
+}
+
+const CheckpointEntry& MappedCheckpoint::Find(
+    const std::string& name, proto::VarType::Type type) const {
+  auto it = entries_.find(name);
+  PADDLE_ENFORCE(it != entries_.end(), "%s is not in the checkpoint.", name);
+  PADDLE_ENFORCE_EQ(
+      it->second.type, type, "%s is saved as another type.", name);
+  CheckEntrySize(name, it->second);
+  return it->second;
+}
+
+void MappedCheckpoint::LoadTensor(const CheckpointEntry& entry,
+                                  const platform::Place& place,
+                                  Tensor* tensor) const {
+  Tensor mapped;
+  mapped.Resize(EntryDims(entry));
+  auto mapping = mapping_;
+  mapped.ShareExternalData(static_cast<char*>(mapping->ptr) + entry.offset,
+                           entry.size,
+                           platform::CPUPlace(),
+                           ToTypeIndex(entry.desc.data_type()),
+                           [mapping](void*) {});
+  QuantizationFromDesc(entry.desc, &mapped);
+  if (platform::is_cpu_place(place)) {
+    tensor->CopyOnWriteFrom(mapped);
+  } else {
+    TensorCopySync(mapped, place, tensor);
+  }
+}
+
+void MappedCheckpoint::Load(const std::string& name,
+                            const platform::Place& place,
+                            LoDTensor* tensor) const {
+  const CheckpointEntry& entry = Find(name, proto::VarType::LOD_TENSOR);
+  LoadTensor(entry, place, tensor);
+  tensor->set_lod(entry.lod);
+}
+
+void MappedCheckpoint::Load(const std::string& name,
+                            const platform::Place& place,
+                            SelectedRows* selected_rows) const {
+  const CheckpointEntry& entry = Find(name, proto::VarType::SELECTED_ROWS);
+  LoadTensor(entry, place, selected_rows->mutable_value());
+  auto* rows = reinterpret_cast<const int64_t*>(
+      static_cast<const char*>(mapping_->ptr) + entry.rows_offset);
+  selected_rows->set_rows(Vector<int64_t>(
+      std::vector<int64_t>(rows, rows + entry.rows_size / sizeof(int64_t))));
+  selected_rows->set_height(entry.height);
+}
+
+size_t MappedCheckpoint::size() const { return mapping_->size; }
+
+}  // namespace framework
+}  // namespace fluid
+}  // namespace paddle
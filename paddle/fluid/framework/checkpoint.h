@@ -0,0 +1,248 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "paddle/fluid/framework/framework.pb.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/platform/macros.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace fluid {
+namespace framework {
+
+/*
+ * A checkpoint file holds named LoDTensors and SelectedRows so that they
+ * can be mapped into memory, or read and written in parallel:
+ *
+ *   header    magic "PDCKPT", uint32_t version, uint32_t number of entries,
+ *             uint64_t size of the index, uint64_t size of the file
+ *   index     for each entry, in the order of the names:
+ *               uint32_t size of the name, the name,
+ *               int32_t proto::VarType::Type of the variable (version 1),
+ *               int32_t size of the TensorDesc, the TensorDesc,
+ *               uint64_t LoD levels, and for each the uint64_t size in
+ *               bytes and the offsets,
+ *               int64_t height, uint64_t offset and uint64_t size of the
+ *               rows of a SelectedRows (version 1),
+ *               uint64_t offset and uint64_t size of the payload
+ *   payloads  the elements of each tensor and the rows of each
+ *             SelectedRows, at offsets aligned to kCheckpointAlignment
+ */
+constexpr size_t kCheckpointAlignment = 64;
+
+/*! An entry of the index of a checkpoint file. */
+struct CheckpointEntry {
+  proto::VarType::Type type = proto::VarType::LOD_TENSOR;
+  proto::VarType::TensorDesc desc;
+  LoD lod;
+  int64_t height = 0;
+  uint64_t rows_offset = 0;
+  uint64_t rows_size = 0;
+  uint64_t offset = 0;
+  uint64_t size = 0;
+};
+
+/**
+ * @brief   The bytes of variables moved by a checkpoint operation, and the
+ *          time it took.
+ *
+ * @note    bytes counts the payloads, i.e., the data and the rows of the
+ *          variables, but not the header, the index or the padding of the
+ *          file, so a save and a load of the same variables agree.
+ */
+struct CheckpointStats {
+  uint64_t bytes = 0;
+  double seconds = 0;
+  // The part of seconds an asynchronous save blocked its caller.
+  double stall_seconds = 0;
+
+  double MBPerSecond() const {
+    return seconds > 0 ? bytes / seconds / (1 << 20) : 0;
+  }
+};
+
+/**
+ * @brief   Write tensors on any place into a checkpoint file.
+ *
+ * @note    The file is written beside path, flushed to disk and renamed
+ *          over it, so that a crash leaves either checkpoint whole, and the
+ *          processes mapping an older checkpoint at path keep it.
+ */
+void SaveCheckpoint(const std::string& path,
+                    const std::map<std::string, LoDTensor>& tensors);
+
+/**
+ * @brief   Write the LoDTensors and SelectedRows of a scope into a
+ *          checkpoint file, and clear the dirty rows of the SelectedRows.
+ *
+ * @note    The payloads are copied to the host and written in pieces by
+ *          FLAGS_checkpoint_threads threads, each at its own offset of
+ *          the file, so that a large model is written at the bandwidth
+ *          of the disk rather than of one core.  As with SaveCheckpoint,
+ *          the file replaces path only once it is on disk.
+ */
+CheckpointStats SaveScope(const std::string& path,
+                          const Scope& scope,
+                          const std::vector<std::string>& names);
+
+/**
+ * @brief   Write a delta checkpoint: the LoDTensors whole, but of each
+ *          SelectedRows only the rows dirty since the last SaveScope or
+ *          SaveScopeDelta, whose dirty rows are then cleared.
+ *
+ * @note    A delta is an ordinary checkpoint file, so its size follows
+ *          the rows updated rather than the size of the tables.  Rows
+ *          written through mutable_value must be marked with MarkDirty,
+ *          and rows removed from a table are not tracked.  The dirty rows
+ *          are taken as the snapshot is made, so rows marked while it is
+ *          written go into the next delta, and are marked again if the
+ *          write fails.
+ */
+CheckpointStats SaveScopeDelta(const std::string& path,
+                               const Scope& scope,
+                               const std::vector<std::string>& names);
+
+/**
+ * @brief   Read variables of a checkpoint file into a scope, in pieces by
+ *          FLAGS_checkpoint_threads threads, and copy them to place.
+ *
+ * @note    Unlike MappedCheckpoint, the variables are read eagerly into
+ *          memory of their own, which suits training.
+ */
+CheckpointStats LoadScope(const std::string& path,
+                          const std::vector<std::string>& names,
+                          const platform::Place& place,
+                          Scope* scope);
+
+/**
+ * @brief   Merge a base checkpoint and its deltas, oldest first, into a
+ *          checkpoint at path.
+ *
+ * @note    The rows of a SelectedRows in a delta overwrite the rows of the
+ *          same keys and append the new keys; the other variables of a
+ *          delta replace those before it.
+ */
+CheckpointStats CompactCheckpoint(const std::string& base,
+                                  const std::vector<std::string>& deltas,
+                                  const std::string& path);
+
+/**
+ * @brief   AsyncCheckpointer writes checkpoint files of a scope in the
+ *          background while training goes on.
+ *
+ * @note    Save takes a snapshot by handing the variables copy-on-write
+ *          copies of their memory blocks, and keeps the blocks for the
+ *          writer thread, which writes and fsyncs the file.  A variable
+ *          written before the file is done copies its block first, so the
+ *          training loop pays for the variables it updates, not for the
+ *          disk.  As with Tensor::CopyOnWriteFrom, pointers to the data of
+ *          the variables taken before Save must not be written through
+ *          afterwards.  Only the variables themselves are protected: other
+ *          tensors sharing their blocks through ShareDataWith still write
+ *          into the snapshot, so they must not be written until Wait.
+ *          The dirty rows of the SelectedRows are taken by Save, and
+ *          marked again by Wait if the file cannot be written.
+ */
+class AsyncCheckpointer {
+ public:
+  AsyncCheckpointer();
+  ~AsyncCheckpointer();
+
+  /**
+   * @brief   Snapshot variables of a scope and write them to path in the
+   *          background, like SaveScope.
+   *
+   * @note    Waits for the previous save, and rethrows its error.
+   */
+  void Save(const std::string& path,
+            const Scope& scope,
+            const std::vector<std::string>& names);
+
+  /**
+   * @brief   Wait for the last save, rethrow its error or return its stats,
+   *          whose seconds run from the call to Save to the fsync.
+   */
+  CheckpointStats Wait();
+
+ private:
+  struct Job;
+
+  std::unique_ptr<Job> job_;
+  std::thread writer_;
+
+  DISABLE_COPY_AND_ASSIGN(AsyncCheckpointer);
+};
+
+/**
+ * @brief   MappedCheckpoint maps a checkpoint file into memory and hands
+ *          out tensors pointing into the mapping.
+ *
+ * @note    Only the pages of the tensors touched are read from disk.  The
+ *          tensors are copy-on-write: writing one copies its block first,
+ *          so the mapping stays read-only.  They keep the mapping alive,
+ *          and may outlive the MappedCheckpoint.
+ */
+class MappedCheckpoint {
+ public:
+  explicit MappedCheckpoint(const std::string& path);
+
+  /*! The names of the tensors, sorted. */
+  std::vector<std::string> Names() const;
+
+  bool Has(const std::string& name) const;
+
+  /**
+   * @brief   Get a tensor without copying it on CPU, or copy it to place.
+   */
+  void Load(const std::string& name,
+            const platform::Place& place,
+            LoDTensor* tensor) const;
+
+  /*! Get a SelectedRows, whose rows are copied but not its value on CPU. */
+  void Load(const std::string& name,
+            const platform::Place& place,
+            SelectedRows* selected_rows) const;
+
+  /*! The size of the file in bytes. */
+  size_t size() const;
+
+ private:
+  struct Mapping;
+
+  const CheckpointEntry& Find(const std::string& name,
+                              proto::VarType::Type type) const;
+  void LoadTensor(const CheckpointEntry& entry,
+                  const platform::Place& place,
+                  Tensor* tensor) const;
+
+  std::shared_ptr<const Mapping> mapping_;
+  std::map<std::string, CheckpointEntry> entries_;
+
+  DISABLE_COPY_AND_ASSIGN(MappedCheckpoint);
+};
+
+}  // namespace framework
+}  // namespace fluid
+}  // namespace paddle
@@ -0,0 +1,48 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Merges a base checkpoint and its delta checkpoints, oldest first, e.g.,
+//
+//   checkpoint_compact --base=model.ckpt --deltas=model.1,model.2
+//       --output=model.new.ckpt
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/framework/checkpoint.h"
+
+DEFINE_string(base, "", "The base checkpoint.");
+DEFINE_string(deltas, "", "The delta checkpoints, separated by commas.");
+DEFINE_string(output, "", "The compacted checkpoint to write.");
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_base.empty() || FLAGS_output.empty()) {
+    std::cerr << "--base and --output are required." << std::endl;
+    return 1;
+  }
+  std::vector<std::string> deltas;
+  std::istringstream is(FLAGS_deltas);
+  for (std::string delta; std::getline(is, delta, ',');) {
+    if (!delta.empty()) deltas.push_back(delta);
+  }
+  auto stats = paddle::fluid::framework::CompactCheckpoint(
+      FLAGS_base, deltas, FLAGS_output);
+  std::cout << "Wrote " << stats.bytes << " bytes of variables into "
+            << FLAGS_output << " in " << stats.seconds << " s" << std::endl;
+  return 0;
+}
@@ -0,0 +1,364 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/checkpoint.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/quantization.h"
+
+namespace framework = paddle::fluid::framework;
+namespace platform = paddle::fluid::platform;
+
+TEST(Checkpoint, SaveAndMap) {
+  const std::string path = "checkpoint_test.ckpt";
+  std::map<std::string, framework::LoDTensor> tensors;
+  {
+    auto& w = tensors["w"];
+    float* data = w.mutable_data<float>(framework::make_ddim({3, 5}),
+                                        platform::CPUPlace());
+    for (int i = 0; i < 15; ++i) data[i] = i * 0.5f;
+    w.set_lod({{0, 1, 3}});
+
+    auto& ids = tensors["ids"];
+    int64_t* ids_data = ids.mutable_data<int64_t>(framework::make_ddim({7}),
+                                                  platform::CPUPlace());
+    for (int i = 0; i < 7; ++i) ids_data[i] = -i;
+
+    // A view is saved densely.
+    framework::LoDTensor column;
+    column.ShareDataWith(w.Slice(2, 3, 1));
+    tensors["column"] = column;
+  }
+  framework::SaveCheckpoint(path, tensors);
+
+  framework::LoDTensor w, ids, column;
+  {
+    framework::MappedCheckpoint checkpoint(path);
+    EXPECT_EQ(checkpoint.Names(),
+              std::vector<std::string>({"column", "ids", "w"}));
+    EXPECT_FALSE(checkpoint.Has("b"));
+    EXPECT_EQ(checkpoint.size() % framework::kCheckpointAlignment, 0UL);
+    checkpoint.Load("w", platform::CPUPlace(), &w);
+    checkpoint.Load("ids", platform::CPUPlace(), &ids);
+    checkpoint.Load("column", platform::CPUPlace(), &column);
+  }
+
+  // The tensors keep the mapping after the checkpoint is destroyed.
+  const auto& const_w = w;
+  const float* mapped = const_w.data<float>();
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(mapped) %
+                framework::kCheckpointAlignment,
+            0UL);
+  EXPECT_EQ(w.dims(), framework::make_ddim({3, 5}));
+  EXPECT_EQ(w.lod(), framework::LoD({{0, 1, 3}}));
+  for (int i = 0; i < 15; ++i) EXPECT_EQ(mapped[i], i * 0.5f);
+  EXPECT_EQ(ids.type(), typeid(int64_t));
+  const auto& const_ids = ids;
+  for (int i = 0; i < 7; ++i) EXPECT_EQ(const_ids.data<int64_t>()[i], -i);
+  EXPECT_EQ(column.dims(), framework::make_ddim({3, 1}));
+  const auto& const_column = column;
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(const_column.data<float>()[i], (i * 5 + 2) * 0.5f);
+  }
+
+  // Writing copies the tensor out of the read-only mapping.
+  float* written = w.mutable_data<float>(platform::CPUPlace());
+  EXPECT_NE(written, mapped);
+  written[0] = 42.f;
+  framework::LoDTensor reloaded;
+  framework::MappedCheckpoint(path).Load(
+      "w", platform::CPUPlace(), &reloaded);
+  EXPECT_EQ(static_cast<const framework::LoDTensor&>(reloaded).data<float>()[0],
+            0.f);
+
+  std::remove(path.c_str());
+}
+
+TEST(Checkpoint, Corrupted) {
+  const std::string path = "checkpoint_test_corrupted.ckpt";
+  std::map<std::string, framework::LoDTensor> tensors;
+  tensors["x"].mutable_data<float>(framework::make_ddim({100}),
+                                   platform::CPUPlace());
+  framework::SaveCheckpoint(path, tensors);
+  {
+    // Truncate the file.
+    std::ifstream in(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)),
+                      std::istreambuf_iterator<char>());
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), bytes.size() - 64);
+  }
+  EXPECT_THROW(framework::MappedCheckpoint checkpoint(path),
+               paddle::fluid::platform::EnforceNotMet);
+  EXPECT_THROW(framework::MappedCheckpoint checkpoint("no_such_checkpoint"),
+               paddle::fluid::platform::EnforceNotMet);
+  std::remove(path.c_str());
+
+  // A failed save leaves no partial file behind.
+  ASSERT_EQ(mkdir(path.c_str(), 0755), 0);
+  EXPECT_THROW(framework::SaveCheckpoint(path, tensors),
+               paddle::fluid::platform::EnforceNotMet);
+  EXPECT_NE(access((path + ".tmp").c_str(), F_OK), 0);
+  rmdir(path.c_str());
+}
+
+TEST(Checkpoint, SaveAndLoadScope) {
+  const std::string path = "checkpoint_test_scope.ckpt";
+  framework::Scope scope;
+  // Larger than a piece written by a thread, with a tail.
+  const int64_t large = (16 << 20) / sizeof(float) + 3;
+  auto* w = scope.Var("w")->GetMutable<framework::LoDTensor>();
+  float* w_data = w->mutable_data<float>(framework::make_ddim({large}),
+                                         platform::CPUPlace());
+  for (int64_t i = 0; i < large; ++i) w_data[i] = static_cast<float>(i % 1000);
+  w->set_lod({{0, 5, static_cast<size_t>(large)}});
+
+  auto* table = scope.Var("table")->GetMutable<framework::SelectedRows>();
+  table->set_height(100);
+  table->set_rows({7, 3, 42});
+  float* table_data = table->mutable_value()->mutable_data<float>(
+      framework::make_ddim({3, 4}), platform::CPUPlace());
+  for (int i = 0; i < 12; ++i) table_data[i] = i;
+
+  auto saved = framework::SaveScope(path, scope, {"w", "table"});
+  EXPECT_EQ(saved.bytes, large * sizeof(float) + 12 * sizeof(float) + 24);
+
+  framework::Scope loaded;
+  auto stats = framework::LoadScope(
+      path, {"table", "w"}, platform::CPUPlace(), &loaded);
+  EXPECT_EQ(stats.bytes, large * sizeof(float) + 12 * sizeof(float) + 24);
+  auto& w_loaded = loaded.FindVar("w")->Get<framework::LoDTensor>();
+  EXPECT_EQ(w_loaded.lod(), w->lod());
+  ASSERT_EQ(w_loaded.numel(), large);
+  for (int64_t i = 0; i < large; ++i) {
+    ASSERT_EQ(w_loaded.data<float>()[i], w_data[i]);
+  }
+  auto& table_loaded = loaded.FindVar("table")->Get<framework::SelectedRows>();
+  EXPECT_EQ(table_loaded.height(), 100);
+  EXPECT_EQ(std::vector<int64_t>(table_loaded.rows()),
+            std::vector<int64_t>({7, 3, 42}));
+  EXPECT_EQ(table_loaded.value().dims(), framework::make_ddim({3, 4}));
+  EXPECT_EQ(table_loaded.value().data<float>()[11], 11.f);
+
+  // The mapped checkpoint reads the same file.
+  framework::MappedCheckpoint checkpoint(path);
+  framework::SelectedRows mapped_table;
+  checkpoint.Load("table", platform::CPUPlace(), &mapped_table);
+  EXPECT_EQ(mapped_table.rows().size(), 3UL);
+  EXPECT_EQ(mapped_table.value().data<float>()[5], 5.f);
+  framework::LoDTensor as_tensor;
+  EXPECT_THROW(checkpoint.Load("table", platform::CPUPlace(), &as_tensor),
+               paddle::fluid::platform::EnforceNotMet);
+
+  std::remove(path.c_str());
+}
+
+TEST(Checkpoint, Quantized) {
+  const std::string path = "checkpoint_test_quantized.ckpt";
+  framework::Scope scope;
+  auto* q = scope.Var("q")->GetMutable<framework::LoDTensor>();
+  int8_t* q_data = q->mutable_data<int8_t>(framework::make_ddim({2, 3}),
+                                           platform::CPUPlace());
+  for (int i = 0; i < 6; ++i) q_data[i] = i;
+  auto params = std::make_shared<framework::QuantizationParams>();
+  params->axis = 0;
+  params->scales = {0.5f, 0.25f};
+  params->zero_points = {1, -1};
+  q->set_quantization(params);
+  framework::SaveScope(path, scope, {"q"});
+
+  framework::Scope loaded;
+  framework::LoadScope(path, {"q"}, platform::CPUPlace(), &loaded);
+  auto& q_loaded = loaded.FindVar("q")->Get<framework::LoDTensor>();
+  ASSERT_NE(q_loaded.quantization(), nullptr);
+  EXPECT_EQ(q_loaded.quantization()->axis, 0);
+  EXPECT_EQ(q_loaded.quantization()->scales, params->scales);
+  EXPECT_EQ(q_loaded.quantization()->zero_points, params->zero_points);
+
+  framework::LoDTensor mapped;
+  framework::MappedCheckpoint(path).Load("q", platform::CPUPlace(), &mapped);
+  ASSERT_NE(mapped.quantization(), nullptr);
+  EXPECT_EQ(mapped.quantization()->scales, params->scales);
+  EXPECT_EQ(mapped.data<int8_t>()[5], 5);
+
+  std::remove(path.c_str());
+}
+
+TEST(Checkpoint, DeltaAndCompact) {
+  const std::string base = "checkpoint_test_base.ckpt";
+  const std::string delta1 = "checkpoint_test_delta1.ckpt";
+  const std::string delta2 = "checkpoint_test_delta2.ckpt";
+  const std::string compacted = "checkpoint_test_compacted.ckpt";
+  platform::CPUPlace cpu;
+  framework::Scope scope;
+  const int64_t num_rows = 1000, width = 16;
+  auto* table = scope.Var("table")->GetMutable<framework::SelectedRows>();
+  table->set_height(1 << 20);
+  std::vector<int64_t> keys;
+  for (int64_t i = 0; i < num_rows; ++i) keys.push_back(i * 3);
+  table->set_rows(keys);
+  float* data = table->mutable_value()->mutable_data<float>(
+      framework::make_ddim({num_rows, width}), cpu);
+  for (int64_t i = 0; i < num_rows * width; ++i) data[i] = i;
+  auto* step = scope.Var("step")->GetMutable<framework::LoDTensor>();
+  step->mutable_data<int64_t>(framework::make_ddim({1}), cpu)[0] = 0;
+  // Rows written before the base are in it.
+  table->MarkDirty(5);
+
+  auto base_stats = framework::SaveScope(base, scope, {"step", "table"});
+  EXPECT_TRUE(table->DirtyRows().empty());
+
+  framework::Tensor row;
+  float* row_data =
+      row.mutable_data<float>(framework::make_ddim({1, width}), cpu);
+  for (int64_t i = 0; i < width; ++i) row_data[i] = -1;
+  table->Set(30, row);  // overwrites the row of key 30
+  table->Set(1, row);   // adds a key
+  step->data<int64_t>()[0] = 1;
+  auto delta_stats =
+      framework::SaveScopeDelta(delta1, scope, {"step", "table"});
+  EXPECT_LT(delta_stats.bytes * 10, base_stats.bytes);
+  EXPECT_TRUE(table->DirtyRows().empty());
+
+  for (int64_t i = 0; i < width; ++i) row_data[i] = -2;
+  table->Set(1, row);
+  table->Set(2, row);
+  step->data<int64_t>()[0] = 2;
+  framework::SaveScopeDelta(delta2, scope, {"step", "table"});
+
+  {
+    framework::MappedCheckpoint checkpoint(delta2);
+    framework::SelectedRows rows;
+    checkpoint.Load("table", cpu, &rows);
+    EXPECT_EQ(std::vector<int64_t>(rows.rows()),
+              std::vector<int64_t>({1, 2}));
+    EXPECT_EQ(rows.height(), 1 << 20);
+  }
+
+  framework::CompactCheckpoint(base, {delta1, delta2}, compacted);
+  framework::Scope loaded;
+  framework::LoadScope(compacted, {"step", "table"}, cpu, &loaded);
+  auto& loaded_step = loaded.FindVar("step")->Get<framework::LoDTensor>();
+  EXPECT_EQ(loaded_step.data<int64_t>()[0], 2);
+  auto& merged = loaded.FindVar("table")->Get<framework::SelectedRows>();
+  EXPECT_EQ(merged.height(), table->height());
+  ASSERT_EQ(std::vector<int64_t>(merged.rows()),
+            std::vector<int64_t>(table->rows()));
+  for (size_t i = 0; i < merged.rows().size(); ++i) {
+    for (int64_t j = 0; j < width; ++j) {
+      ASSERT_EQ(merged.value().data<float>()[i * width + j],
+                table->value().data<float>()[i * width + j]);
+    }
+  }
+
+  for (auto& path : {base, delta1, delta2, compacted}) {
+    std::remove(path.c_str());
+  }
+}
+
+TEST(Checkpoint, FailedSaveKeepsDirtyRows) {
+  const std::string path = "checkpoint_test_failed.ckpt";
+  platform::CPUPlace cpu;
+  framework::Scope scope;
+  auto* table = scope.Var("table")->GetMutable<framework::SelectedRows>();
+  table->set_height(10);
+  table->set_rows({4, 2});
+  table->mutable_value()->mutable_data<float>(framework::make_ddim({2, 3}),
+                                              cpu);
+  table->MarkDirty(1);
+
+  // A missing variable after the table fails the save before the write.
+  EXPECT_THROW(framework::SaveScopeDelta(path, scope, {"table", "missing"}),
+               paddle::fluid::platform::EnforceNotMet);
+  EXPECT_EQ(table->DirtyRows(), std::vector<int64_t>({1}));
+  {
+    framework::AsyncCheckpointer checkpointer;
+    EXPECT_THROW(checkpointer.Save(path, scope, {"table", "missing"}),
+                 paddle::fluid::platform::EnforceNotMet);
+    EXPECT_EQ(table->DirtyRows(), std::vector<int64_t>({1}));
+  }
+
+  // A directory at path fails the rename.
+  ASSERT_EQ(mkdir(path.c_str(), 0755), 0);
+  EXPECT_THROW(framework::SaveScope(path, scope, {"table"}),
+               paddle::fluid::platform::EnforceNotMet);
+  EXPECT_EQ(table->DirtyRows(), std::vector<int64_t>({1}));
+  EXPECT_THROW(framework::SaveScopeDelta(path, scope, {"table"}),
+               paddle::fluid::platform::EnforceNotMet);
+  EXPECT_EQ(table->DirtyRows(), std::vector<int64_t>({1}));
+  framework::AsyncCheckpointer checkpointer;
+  checkpointer.Save(path, scope, {"table"});
+  table->MarkDirty(0);
+  EXPECT_THROW(checkpointer.Wait(), paddle::fluid::platform::EnforceNotMet);
+  EXPECT_EQ(table->DirtyRows(), std::vector<int64_t>({0, 1}));
+  rmdir(path.c_str());
+
+  framework::SaveScopeDelta(path, scope, {"table"});
+  EXPECT_TRUE(table->DirtyRows().empty());
+  std::remove(path.c_str());
+}
+
+TEST(Checkpoint, AsyncSave) {
+  const std::string path = "checkpoint_test_async.ckpt";
+  platform::CPUPlace cpu;
+  framework::Scope scope;
+  const int64_t n = 1 << 20;
+  auto* w = scope.Var("w")->GetMutable<framework::LoDTensor>();
+  float* w_data = w->mutable_data<float>(framework::make_ddim({n}), cpu);
+  for (int64_t i = 0; i < n; ++i) w_data[i] = 1.f;
+  auto* table = scope.Var("table")->GetMutable<framework::SelectedRows>();
+  table->set_height(10);
+  table->set_rows({4, 2});
+  table->mutable_value()->mutable_data<float>(framework::make_ddim({2, 3}),
+                                              cpu)[0] = 1.f;
+  table->MarkDirty(0);
+
+  framework::AsyncCheckpointer checkpointer;
+  checkpointer.Save(path, scope, {"w", "table"});
+  EXPECT_TRUE(table->DirtyRows().empty());
+  // The training loop goes on while the snapshot is written.
+  w_data = w->mutable_data<float>(cpu);
+  for (int64_t i = 0; i < n; ++i) w_data[i] = 2.f;
+  table->mutable_rows()->push_back(7);
+  table->mutable_value()->mutable_data<float>(cpu)[0] = 2.f;
+  auto stats = checkpointer.Wait();
+  EXPECT_GE(stats.bytes, n * sizeof(float));
+  EXPECT_LE(stats.stall_seconds, stats.seconds);
+  EXPECT_THROW(checkpointer.Wait(), paddle::fluid::platform::EnforceNotMet);
+
+  framework::Scope loaded;
+  framework::LoadScope(path, {"w", "table"}, cpu, &loaded);
+  auto& w_loaded = loaded.FindVar("w")->Get<framework::LoDTensor>();
+  for (int64_t i = 0; i < n; ++i) ASSERT_EQ(w_loaded.data<float>()[i], 1.f);
+  auto& table_loaded = loaded.FindVar("table")->Get<framework::SelectedRows>();
+  EXPECT_EQ(std::vector<int64_t>(table_loaded.rows()),
+            std::vector<int64_t>({4, 2}));
+  EXPECT_EQ(table_loaded.value().data<float>()[0], 1.f);
+  EXPECT_EQ(static_cast<const framework::LoDTensor*>(w)->data<float>()[0],
+            2.f);
+
+  // A second save writes over the first.
+  checkpointer.Save(path, scope, {"w"});
+  checkpointer.Wait();
+  framework::LoadScope(path, {"w"}, cpu, &loaded);
+  EXPECT_EQ(w_loaded.data<float>()[n - 1], 2.f);
+  std::remove(path.c_str());
+}
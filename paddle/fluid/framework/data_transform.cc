@@ -57,6 +57,25 @@ void DataTransform(const OpKernelType& expected_kernel_type,
     PassTensorData(&out, &in);
   }
 
+  bool moved = false;
+  auto device_transform = [&] {
+    if (!moved && !platform::is_same_place(kernel_type_for_var.place_,
+                                           expected_kernel_type.place_)) {
+      TransDataDevice(in, expected_kernel_type.place_, &out);
+      transformed = true;
+      moved = true;
+      PassTensorData(&out, &in);
+    }
+  };
+
+  // INT8 quantization only runs on CPU, so the tensor is moved to a CPU
+  // kernel before the data type transform.
+  bool int8 = expected_kernel_type.data_type_ == proto::VarType::INT8 ||
+              kernel_type_for_var.data_type_ == proto::VarType::INT8;
+  if (int8 && platform::is_cpu_place(expected_kernel_type.place_)) {
+    device_transform();
+  }
+
   // do data type transform
   if (expected_kernel_type.data_type_ != kernel_type_for_var.data_type_) {
     TransDataType(kernel_type_for_var, expected_kernel_type, in, &out);
@@ -65,12 +84,7 @@ void DataTransform(const OpKernelType& expected_kernel_type,
   }
 
   // do device transform
-  if (!platform::is_same_place(kernel_type_for_var.place_,
-                               expected_kernel_type.place_)) {
-    TransDataDevice(in, expected_kernel_type.place_, &out);
-    transformed = true;
-    PassTensorData(&out, &in);
-  }
+  device_transform();
 
   PADDLE_ENFORCE(transformed, "No transform is applied, please check!");
   // get output data
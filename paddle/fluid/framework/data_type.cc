@@ -62,6 +62,9 @@ static DataTypeMap* InitDataTypeMap() {
   RegType(size_t, proto::VarType::SIZE_T);
   RegType(int16_t, proto::VarType::INT16);
   RegType(uint8_t, proto::VarType::UINT8);
+  RegType(int8_t, proto::VarType::INT8);
+  RegType(platform::float16, proto::VarType::FP16);
+  RegType(platform::bfloat16, proto::VarType::BF16);
 
 #undef RegType
   return retv;
@@ -17,6 +17,7 @@ limitations under the License. */
 #include <typeindex>
 #include "paddle/fluid/framework/framework.pb.h"
 #include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/float16.h"
 
 namespace paddle {
 namespace fluid {
@@ -49,6 +50,15 @@ inline void VisitDataType(proto::VarType::Type type, Visitor visitor) {
     case proto::VarType::INT16:
       visitor.template operator()<int16_t>();
       break;
+    case proto::VarType::INT8:
+      visitor.template operator()<int8_t>();
+      break;
+    case proto::VarType::FP16:
+      visitor.template operator()<platform::float16>();
+      break;
+    case proto::VarType::BF16:
+      visitor.template operator()<platform::bfloat16>();
+      break;
     default:
       PADDLE_THROW("Not supported %d", type);
   }
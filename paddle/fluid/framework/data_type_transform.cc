@@ -15,9 +15,11 @@ limitations under the License. */
 #include "paddle/fluid/framework/data_type_transform.h"
 
 #include "paddle/fluid/framework/op_kernel_type.h"
+#include "paddle/fluid/framework/quantization.h"
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/framework/variable.h"
 #include "paddle/fluid/platform/device_context.h"
+#include "paddle/fluid/platform/float16.h"
 #include "paddle/fluid/platform/transform.h"
 
 namespace paddle {
@@ -31,6 +33,33 @@ struct CastDataTypeFunctor {
   }
 };
 
+// The conversions of float to and from the 16-bit types are bit
+// manipulations compilers do not vectorize, so they have CPU kernels.
+template <typename InType, typename OutType>
+inline bool CastOnCPU(const InType* in, OutType* out, size_t n) {
+  return false;
+}
+
+inline bool CastOnCPU(const float* in, platform::float16* out, size_t n) {
+  platform::FloatToHalf(in, out, n);
+  return true;
+}
+
+inline bool CastOnCPU(const platform::float16* in, float* out, size_t n) {
+  platform::HalfToFloat(in, out, n);
+  return true;
+}
+
+inline bool CastOnCPU(const float* in, platform::bfloat16* out, size_t n) {
+  platform::FloatToBFloat16(in, out, n);
+  return true;
+}
+
+inline bool CastOnCPU(const platform::bfloat16* in, float* out, size_t n) {
+  platform::BFloat16ToFloat(in, out, n);
+  return true;
+}
+
 template <typename InType>
 struct CastDataType {
   CastDataType(const framework::Tensor& in,
@@ -48,6 +77,7 @@ struct CastDataType {
     auto* out_begin = out_->mutable_data<OutType>(in_.place());
 
     if (platform::is_cpu_place(in_.place())) {
+      if (CastOnCPU(in_begin, out_begin, in_.numel())) return;
       platform::Transform<platform::CPUDeviceContext> trans;
       auto* context = static_cast<const platform::CPUDeviceContext*>(ctx_);
       trans(*context,
@@ -72,15 +102,13 @@ struct CastDataType {
   }
 };
 
-void TransDataType(const OpKernelType& kernel_type_for_var,
-                   const OpKernelType& expected_kernel_type,
-                   const Tensor& in,
-                   Tensor* out) {
+static void CastTensor(proto::VarType::Type src_type,
+                       proto::VarType::Type dst_type,
+                       const Tensor& in,
+                       Tensor* out) {
   platform::DeviceContextPool& pool = platform::DeviceContextPool::Instance();
 
   out->Resize(in.dims());
-  auto src_type = kernel_type_for_var.data_type_;
-  auto dst_type = expected_kernel_type.data_type_;
   auto ctx = pool.Get(in.place());
 
   switch (src_type) {
@@ -100,16 +128,64 @@ void TransDataType(const OpKernelType& kernel_type_for_var,
       framework::VisitDataType(dst_type, CastDataType<bool>(in, out, ctx));
       break;
     case proto::VarType::INT16:
-      framework::VisitDataType(dst_type, CastDataType<bool>(in, out, ctx));
+      framework::VisitDataType(dst_type, CastDataType<int16_t>(in, out, ctx));
       break;
     case proto::VarType::UINT8:
-      framework::VisitDataType(dst_type, CastDataType<bool>(in, out, ctx));
+      framework::VisitDataType(dst_type, CastDataType<uint8_t>(in, out, ctx));
+      break;
+    case proto::VarType::INT8:
+      framework::VisitDataType(dst_type, CastDataType<int8_t>(in, out, ctx));
+      break;
+    case proto::VarType::FP16:
+      framework::VisitDataType(dst_type,
+                               CastDataType<platform::float16>(in, out, ctx));
+      break;
+    case proto::VarType::BF16:
+      framework::VisitDataType(dst_type,
+                               CastDataType<platform::bfloat16>(in, out, ctx));
       break;
     default:
       PADDLE_THROW("Not support type %d", src_type);
   }
 }
 
+static bool IsFloatingPoint(proto::VarType::Type type) {
+  return type == proto::VarType::FP32 || type == proto::VarType::FP64 ||
+         type == proto::VarType::FP16 || type == proto::VarType::BF16;
+}
+
+void TransDataType(const OpKernelType& kernel_type_for_var,
+                   const OpKernelType& expected_kernel_type,
+                   const Tensor& in,
+                   Tensor* out) {
+  auto src_type = kernel_type_for_var.data_type_;
+  auto dst_type = expected_kernel_type.data_type_;
+
+  // Floating point tensors are quantized to INT8 with a per-tensor
+  // mapping fit to their range, and quantized tensors are dequantized.
+  // Other INT8 tensors are cast as integers.
+  if (dst_type == proto::VarType::INT8 && IsFloatingPoint(src_type)) {
+    Tensor fp32 = in;
+    if (src_type != proto::VarType::FP32) {
+      fp32 = Tensor();
+      CastTensor(src_type, proto::VarType::FP32, in, &fp32);
+    }
+    Quantize(fp32, ChooseQuantizationParams(fp32), out);
+    return;
+  }
+  if (src_type == proto::VarType::INT8 && in.quantization() != nullptr) {
+    if (dst_type == proto::VarType::FP32) {
+      Dequantize(in, out);
+    } else {
+      Tensor fp32;
+      Dequantize(in, &fp32);
+      CastTensor(proto::VarType::FP32, dst_type, fp32, out);
+    }
+    return;
+  }
+  CastTensor(src_type, dst_type, in, out);
+}
+
 }  // namespace framework
 }  // namespace fluid
 }  // namespace paddle
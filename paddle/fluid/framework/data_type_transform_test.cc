@@ -15,6 +15,7 @@ limitations under the License. */
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/op_kernel_type.h"
+#include "paddle/fluid/framework/quantization.h"
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/framework/tensor_data_layout.h"
 #include "paddle/fluid/framework/variable.h"
@@ -87,3 +88,107 @@ TEST(DataTypeTransform, CPUTransform) {
     }
   }
 }
+
+TEST(DataTypeTransform, CPUTransform16Bit) {
+  namespace framework = paddle::fluid::framework;
+  namespace platform = paddle::fluid::platform;
+  auto place = platform::CPUPlace();
+  auto kernel = [&](framework::proto::VarType::Type type) {
+    return framework::OpKernelType(type,
+                                   place,
+                                   framework::TensorDataLayout::kAnyLayout,
+                                   framework::Accelerator::kPlain);
+  };
+
+  framework::Tensor in;
+  float* ptr = in.mutable_data<float>(framework::make_ddim({3, 7}), place);
+  for (int i = 0; i < in.numel(); ++i) {
+    ptr[i] = (i - 10) * 0.25f;
+  }
+
+  for (auto type : {framework::proto::VarType::FP16,
+                    framework::proto::VarType::BF16}) {
+    framework::Tensor half;
+    framework::TransDataType(
+        kernel(framework::proto::VarType::FP32), kernel(type), in, &half);
+    EXPECT_EQ(half.type(), framework::ToTypeIndex(type));
+    EXPECT_EQ(half.memory_size(), in.memory_size() / 2);
+
+    // The values are exact in both types.
+    framework::Tensor back;
+    framework::TransDataType(
+        kernel(type), kernel(framework::proto::VarType::FP32), half, &back);
+    for (int i = 0; i < in.numel(); ++i) {
+      EXPECT_EQ(back.data<float>()[i], (i - 10) * 0.25f);
+    }
+
+    framework::Tensor ints;
+    framework::TransDataType(
+        kernel(type), kernel(framework::proto::VarType::INT16), half, &ints);
+    for (int i = 0; i < in.numel(); ++i) {
+      EXPECT_EQ(ints.data<int16_t>()[i],
+                static_cast<int16_t>((i - 10) * 0.25f));
+    }
+  }
+
+  framework::Tensor bytes;
+  uint8_t* byte_ptr =
+      bytes.mutable_data<uint8_t>(framework::make_ddim({4}), place);
+  for (int i = 0; i < 4; ++i) byte_ptr[i] = 60 * i;
+  framework::Tensor ints;
+  framework::TransDataType(kernel(framework::proto::VarType::UINT8),
+                           kernel(framework::proto::VarType::INT32),
+                           bytes,
+                           &ints);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(ints.data<int>()[i], 60 * i);
+  }
+}
+
+TEST(DataTypeTransform, CPUTransformInt8) {
+  namespace framework = paddle::fluid::framework;
+  namespace platform = paddle::fluid::platform;
+  auto place = platform::CPUPlace();
+  auto kernel = [&](framework::proto::VarType::Type type) {
+    return framework::OpKernelType(type,
+                                   place,
+                                   framework::TensorDataLayout::kAnyLayout,
+                                   framework::Accelerator::kPlain);
+  };
+
+  framework::Tensor in;
+  double* ptr = in.mutable_data<double>(framework::make_ddim({50}), place);
+  for (int i = 0; i < 50; ++i) ptr[i] = (i - 20) * 0.1;
+
+  // Floating point tensors are quantized to fit their range.
+  framework::Tensor q;
+  framework::TransDataType(kernel(framework::proto::VarType::FP64),
+                           kernel(framework::proto::VarType::INT8),
+                           in,
+                           &q);
+  EXPECT_EQ(q.type(), typeid(int8_t));
+  ASSERT_NE(q.quantization(), nullptr);
+  float scale = q.quantization()->scales[0];
+  EXPECT_FLOAT_EQ(scale, 4.9f / 255);
+  EXPECT_EQ(q.data<int8_t>()[0], -128);
+  EXPECT_EQ(q.data<int8_t>()[49], 127);
+
+  framework::Tensor back;
+  framework::TransDataType(kernel(framework::proto::VarType::INT8),
+                           kernel(framework::proto::VarType::FP64),
+                           q,
+                           &back);
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_NEAR(back.data<double>()[i], ptr[i], scale / 2 + 1e-6);
+  }
+
+  // Without params, INT8 is an integer type.
+  q.set_quantization(nullptr);
+  framework::Tensor ints;
+  framework::TransDataType(kernel(framework::proto::VarType::INT8),
+                           kernel(framework::proto::VarType::INT32),
+                           q,
+                           &ints);
+  EXPECT_EQ(ints.data<int>()[0], -128);
+  EXPECT_EQ(ints.data<int>()[49], 127);
+}
@@ -15,6 +15,7 @@ limitations under the License. */
 #pragma once
 
 #include <initializer_list>
+#include <limits>
 #include <stdexcept>
 #include <vector>
 #include "paddle/fluid/framework/dim.h"
@@ -28,65 +29,103 @@ namespace framework {
 /**
  * \brief A dynamically sized dimension.
  *
- * The number of dimensions must be between [1, 9].
+ * The number of dimensions must be between [0, 9].  The dimensions are
+ * held inline in a fixed array along with their product, so DDim is
+ * trivially copyable and shape arithmetic needs no dispatch on the rank.
+ * Dim<D> converts to and from DDim for code needing a static rank.
  */
-struct DDim {
-  typedef boost::variant<Dim<0>,
-                         Dim<1>,
-                         Dim<2>,
-                         Dim<3>,
-                         Dim<4>,
-                         Dim<5>,
-                         Dim<6>,
-                         Dim<7>,
-                         Dim<8>,
-                         Dim<9>>
-      DDimVar;
-  DDimVar var;
-
-  DDim() : var(Dim<1>()) {}
+class DDim {
+ public:
+  static constexpr int kMaxRank = 9;
+
+  DDim() : rank_(1), numel_(0) { dims_[0] = 0; }
 
   template <int D>
-  explicit DDim(const Dim<D>& in) : var(in) {}
+  explicit DDim(const Dim<D>& in) {
+    *this = in;
+  }
 
   /*implicit*/ DDim(std::initializer_list<int64_t> init_list);
 
+  DDim(const int64_t* dims, int rank);
+
   template <int D>
   DDim& operator=(const Dim<D>& in) {
-    var = in;
+    static_assert(D <= kMaxRank, "DDim has at most 9 dimensions.");
+    rank_ = D;
+    for (int i = 0; i < D; ++i) dims_[i] = in[i];
+    UpdateNumel();
     return *this;
   }
 
-  int64_t& operator[](int idx);
-  int64_t operator[](int idx) const;
+  /**
+   * \note The product of the dimensions is recomputed on each call to
+   *       product() after a dimension is changed through the reference.
+   */
+  int64_t& operator[](int idx) {
+    PADDLE_ENFORCE(idx >= 0 && idx < rank_,
+                   "Invalid dimension to be accessed: %d.",
+                   idx);
+    numel_ = kStaleNumel;
+    return dims_[idx];
+  }
 
-  template <typename Visitor>
-  typename Visitor::result_type apply_visitor(Visitor& visitor) {
-    return var.apply_visitor(visitor);
+  int64_t operator[](int idx) const {
+    PADDLE_ENFORCE(idx >= 0 && idx < rank_,
+                   "Invalid dimension to be accessed: %d.",
+                   idx);
+    return dims_[idx];
   }
 
-  template <typename Visitor>
-  typename Visitor::result_type apply_visitor(Visitor& visitor) const {
-    return var.apply_visitor(visitor);
+  /*! Convert to a Dim of a static rank, which must equal the rank. */
+  template <int D>
+  Dim<D> ToDim() const {
+    PADDLE_ENFORCE_EQ(rank_, D, "The rank of DDim is not %d.", D);
+    Dim<D> dim;
+    for (int i = 0; i < D; ++i) dim[i] = dims_[i];
+    return dim;
   }
 
-  DDimVar getVar() { return var; }
+  /*! Call visitor with the dims converted to Dim<rank>. */
+  template <typename Visitor>
+  typename Visitor::result_type apply_visitor(Visitor& visitor) const;
+
+  bool operator==(const DDim& d) const;
+
+  bool operator!=(const DDim& d) const { return !(*this == d); }
 
-  bool operator==(DDim d) const;
+  DDim operator+(const DDim& d) const;
 
-  bool operator!=(DDim d) const;
+  DDim operator*(const DDim& d) const;
 
-  DDim operator+(DDim d) const;
+  int size() const { return rank_; }
 
-  DDim operator*(DDim d) const;
+  const int64_t* data() const { return dims_; }
 
-  int size() const;
+  int64_t numel() const {
+    return numel_ != kStaleNumel ? numel_ : ComputeNumel();
+  }
+
+ private:
+  static constexpr int64_t kStaleNumel = std::numeric_limits<int64_t>::min();
+
+  int64_t ComputeNumel() const {
+    int64_t numel = 1;
+    for (int i = 0; i < rank_; ++i) numel *= dims_[i];
+    return numel;
+  }
+
+  void UpdateNumel() { numel_ = ComputeNumel(); }
+
+  int rank_;
+  int64_t dims_[kMaxRank];
+  int64_t numel_;
 };
 
 /**
  * \brief Make a DDim from std::vector<int64_t>
  *
- * \param dims An vector of ints. Must be sized between [1, 9]
+ * \param dims An vector of ints. Must be sized between [0, 9]
  */
 DDim make_ddim(const std::vector<int64_t>& dims);
 
@@ -95,18 +134,18 @@ DDim make_ddim(const std::vector<int>& dims);
 /**
  * \brief Make a DDim from an initializer list
  *
- * \param dims An initializer list of ints. Must be sized between [1, 9]
+ * \param dims An initializer list of ints. Must be sized between [0, 9]
  *
  */
 DDim make_ddim(std::initializer_list<int64_t> dims);
 
-int64_t get(const DDim& dim, int idx);
+inline int64_t get(const DDim& dim, int idx) { return dim[idx]; }
 void set(DDim& dim, int idx, int val);
 
 std::vector<int64_t> vectorize(const DDim& ddim);
 std::vector<int> vectorize2int(const DDim& ddim);
 
-int64_t product(const DDim& ddim);
+inline int64_t product(const DDim& ddim) { return ddim.numel(); }
 
 /**
  * \brief Slice a ddim
@@ -123,7 +162,7 @@ DDim slice_ddim(const DDim& dim, int begin, int end);
  * \param Dynamic dimension to inspect
  */
 
-int arity(const DDim& ddim);
+inline int arity(const DDim& ddim) { return ddim.size(); }
 
 std::ostream& operator<<(std::ostream&, const DDim&);
 
@@ -136,6 +175,33 @@ DDim flatten_to_1d(const DDim& src);
 DDim stride(const DDim& ddim);
 
 DDim stride_numel(const DDim& ddim);
+
+template <typename Visitor>
+typename Visitor::result_type DDim::apply_visitor(Visitor& visitor) const {
+  switch (rank_) {
+    case 0:
+      return visitor(ToDim<0>());
+    case 1:
+      return visitor(ToDim<1>());
+    case 2:
+      return visitor(ToDim<2>());
+    case 3:
+      return visitor(ToDim<3>());
+    case 4:
+      return visitor(ToDim<4>());
+    case 5:
+      return visitor(ToDim<5>());
+    case 6:
+      return visitor(ToDim<6>());
+    case 7:
+      return visitor(ToDim<7>());
+    case 8:
+      return visitor(ToDim<8>());
+    default:
+      return visitor(ToDim<9>());
+  }
+}
+
 }  // namespace framework
 }  // namespace fluid
 }  // namespace paddle
@@ -144,7 +210,7 @@ namespace boost {
 
 template <typename T>
 T get(const paddle::fluid::framework::DDim& in) {
-  return boost::get<T>(in.var);
+  return in.ToDim<T::dimensions>();
 }
 
 }  // namespace boost
@@ -0,0 +1,88 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Times the shape arithmetic of typical InferShape functions, e.g.,
+//
+//   ddim_benchmark --iterations=10000000
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/framework/ddim.h"
+#include "paddle/fluid/framework/tensor.h"
+
+DEFINE_int64(iterations, 1000000, "The number of InferShape calls to time.");
+
+namespace paddle {
+namespace fluid {
+namespace framework {
+
+// The InferShape of mul: flatten both inputs to matrices and multiply.
+int64_t MulInferShape(const Tensor& x, const Tensor& y, Tensor* out) {
+  auto x_dims = x.dims();
+  auto y_dims = y.dims();
+  auto x_mat_dims = flatten_to_2d(x_dims, 1);
+  auto y_mat_dims = flatten_to_2d(y_dims, 1);
+  PADDLE_ENFORCE_EQ(x_mat_dims[1], y_mat_dims[0]);
+  std::vector<int64_t> output_dims;
+  output_dims.reserve(static_cast<size_t>(1 + y_dims.size() - 1));
+  output_dims.push_back(x_dims[0]);
+  for (int i = 1; i < y_dims.size(); ++i) {
+    output_dims.push_back(y_dims[i]);
+  }
+  out->Resize(make_ddim(output_dims));
+  return out->numel();
+}
+
+// The InferShape of elementwise ops: compare and slice the dims.
+int64_t ElementwiseInferShape(const Tensor& x, const Tensor& y, Tensor* out) {
+  auto x_dims = x.dims();
+  auto y_dims = y.dims();
+  int64_t numel = 0;
+  if (x_dims == y_dims) {
+    numel = product(slice_ddim(x_dims, 1, arity(x_dims)));
+  }
+  out->Resize(x_dims);
+  return numel + product(stride(x_dims)) + vectorize(out->dims()).size();
+}
+
+template <typename Callback>
+void Time(const char* name, Callback callback) {
+  auto begin = std::chrono::steady_clock::now();
+  int64_t sum = 0;
+  for (int64_t i = 0; i < FLAGS_iterations; ++i) sum += callback();
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - begin;
+  std::cout << name << "\t" << elapsed.count() / FLAGS_iterations
+            << " ns/call\t(" << sum << ")" << std::endl;
+}
+
+}  // namespace framework
+}  // namespace fluid
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  namespace framework = paddle::fluid::framework;
+  framework::Tensor x, y, out;
+  x.Resize(framework::make_ddim({32, 64, 7, 7}));
+  y.Resize(framework::make_ddim({3136, 128}));
+  framework::Time("mul", [&] { return MulInferShape(x, y, &out); });
+  framework::Time("elementwise",
+                  [&] { return ElementwiseInferShape(x, x, &out); });
+  framework::Time("numel", [&] { return x.numel(); });
+  return 0;
+}
@@ -102,3 +102,45 @@ TEST(DDim, Print) {
   ss << ddim;
   EXPECT_EQ("2, 3, 4", ss.str());
 }
+
+TEST(DDim, Product) {
+  paddle::fluid::framework::DDim ddim =
+      paddle::fluid::framework::make_ddim({2, 3, 4});
+  EXPECT_EQ(paddle::fluid::framework::product(ddim), 24);
+
+  // the product follows the dims changed through a reference
+  ddim[1] = 5;
+  EXPECT_EQ(paddle::fluid::framework::product(ddim), 40);
+  paddle::fluid::framework::DDim copy = ddim;
+  EXPECT_EQ(paddle::fluid::framework::product(copy), 40);
+  paddle::fluid::framework::set(copy, 0, -1);
+  EXPECT_EQ(paddle::fluid::framework::product(copy), -20);
+}
+
+TEST(DDim, Dim) {
+  paddle::fluid::framework::Dim<3> dim(2, 3, 4);
+  paddle::fluid::framework::DDim ddim(dim);
+  EXPECT_EQ(paddle::fluid::framework::arity(ddim), 3);
+  EXPECT_EQ(paddle::fluid::framework::product(ddim), 24);
+  EXPECT_EQ(ddim.ToDim<3>(), dim);
+  EXPECT_EQ(boost::get<paddle::fluid::framework::Dim<3>>(ddim), dim);
+  EXPECT_THROW(ddim.ToDim<2>(), paddle::fluid::platform::EnforceNotMet);
+
+  const paddle::fluid::framework::DDim& const_ddim = ddim;
+  EXPECT_THROW(ddim[3], paddle::fluid::platform::EnforceNotMet);
+  EXPECT_THROW(const_ddim[-1], paddle::fluid::platform::EnforceNotMet);
+}
+
+TEST(DDim, Stride) {
+  paddle::fluid::framework::DDim ddim =
+      paddle::fluid::framework::make_ddim({2, 3, 4});
+  EXPECT_EQ(paddle::fluid::framework::stride(ddim),
+            paddle::fluid::framework::make_ddim({12, 4, 1}));
+  EXPECT_EQ(paddle::fluid::framework::stride_numel(ddim),
+            paddle::fluid::framework::make_ddim({24, 12, 4}));
+
+  // a scalar has no strides.
+  paddle::fluid::framework::DDim scalar(nullptr, 0);
+  EXPECT_EQ(paddle::fluid::framework::stride(scalar).size(), 0);
+  EXPECT_EQ(paddle::fluid::framework::stride_numel(scalar).size(), 0);
+}
@@ -50,13 +50,18 @@ struct EigenTensor {
   using ConstType =
       Eigen::TensorMap<Eigen::Tensor<const T, D, MajorType, IndexType>>;
 
+  // TensorMap has no strides, so views must be made contiguous first.
   static Type From(Tensor& tensor, DDim dims) {
+    PADDLE_ENFORCE(tensor.IsContiguous(),
+                   "Call Tensor::Contiguous before mapping a view.");
     return Type(tensor.data<T>(), EigenDim<D>::From(dims));
   }
 
   static Type From(Tensor& tensor) { return From(tensor, tensor.dims_); }
 
   static ConstType From(const Tensor& tensor, DDim dims) {
+    PADDLE_ENFORCE(tensor.IsContiguous(),
+                   "Call Tensor::Contiguous before mapping a view.");
     return ConstType(tensor.data<T>(), EigenDim<D>::From(dims));
   }
 
@@ -16,9 +16,12 @@ limitations under the License. */
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 #include <algorithm>
+#include <atomic>
+#include <random>
 
 #include "paddle/fluid/framework/data_transform.h"
 #include "paddle/fluid/framework/op_kernel_type.h"
+#include "paddle/fluid/framework/tensor_stats.h"
 #include "paddle/fluid/framework/var_type.h"
 
 DECLARE_bool(benchmark);
@@ -26,6 +29,22 @@ DEFINE_bool(check_nan_inf,
             false,
             "Checking whether operator produce NAN/INF or not. It will be "
             "extremely slow so please use this flag wisely.");
+DEFINE_int32(check_nan_inf_every_n_steps,
+             1,
+             "With check_nan_inf, only check the operators run in one of "
+             "every n steps, as counted by framework::IncreaseGlobalStep.");
+DEFINE_double(check_nan_inf_sample_rate,
+              1.0,
+              "With check_nan_inf, only check this fraction of the operator "
+              "runs, chosen at random.");
+DEFINE_bool(record_op_stats,
+            false,
+            "Record the min, max, mean, L2 norm and zero fraction of the "
+            "outputs of every operator into framework::OpStatsRecorder.");
+DEFINE_int32(record_op_stats_every_n_steps,
+             1,
+             "With record_op_stats, only record the operators run in one of "
+             "every n steps, as counted by framework::IncreaseGlobalStep.");
 
 namespace paddle {
 namespace fluid {
@@ -416,19 +435,44 @@ InferShapeVarPtr RuntimeInferShapeContext::GetVarPtr(const std::string& name) {
   return scope_.FindVar(name);
 }
 
+static std::atomic<int64_t> global_step(0);
+
+int64_t GetGlobalStep() { return global_step.load(); }
+
+void IncreaseGlobalStep() { global_step++; }
+
+static bool ShouldCheckNANOrInf() {
+  if (!FLAGS_check_nan_inf) return false;
+  if (FLAGS_check_nan_inf_every_n_steps > 1 &&
+      GetGlobalStep() % FLAGS_check_nan_inf_every_n_steps != 0) {
+    return false;
+  }
+  if (FLAGS_check_nan_inf_sample_rate < 1.0) {
+    static thread_local std::minstd_rand engine(std::random_device{}());
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    return dist(engine) < FLAGS_check_nan_inf_sample_rate;
+  }
+  return true;
+}
+
+static bool ShouldRecordOpStats() {
+  if (!FLAGS_record_op_stats) return false;
+  return FLAGS_record_op_stats_every_n_steps <= 1 ||
+         GetGlobalStep() % FLAGS_record_op_stats_every_n_steps == 0;
+}
+
 static void CheckTensorNANOrInf(const std::string& name,
                                 const framework::Tensor& tensor) {
   if (tensor.memory_size() == 0) {
     return;
   }
-  if (tensor.type().hash_code() != typeid(float).hash_code() &&   // NOLINT
-      tensor.type().hash_code() != typeid(double).hash_code()) {  // NOLINT
+  if (!framework::TensorContainsNANOrInf(tensor)) {
     return;
   }
-  PADDLE_ENFORCE(
-      !framework::TensorContainsInf(tensor), "Tensor %s contains Inf", name);
+  // Only a failing check pays for telling NaN from Inf.
   PADDLE_ENFORCE(
       !framework::TensorContainsNAN(tensor), "Tensor %s contains NAN", name);
+  PADDLE_THROW("Tensor %s contains Inf", name);
 }
 
 void OperatorWithKernel::RunImpl(const Scope& scope,
@@ -502,6 +546,10 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   }
 
   auto* new_dev_ctx = pool.Get(expected_kernel_key.place_);
+  // Temporaries allocated by the kernel from the scratch arena are freed
+  // when RunImpl returns.
+  ScratchArenaGuard scratch_guard(
+      GetThreadScratchArena(expected_kernel_key.place_));
   kernel_iter->second->Compute(
       ExecutionContext(*this, new_scope, *new_dev_ctx));
 
@@ -517,7 +565,19 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
     new_dev_ctx->Wait();
   }
 
-  if (FLAGS_check_nan_inf) {
+  // Recorded before the check, so that a dump shows the failing outputs.
+  if (ShouldRecordOpStats()) {
+    for (auto& vname : OutputVars(true)) {
+      auto* var = new_scope.FindVar(vname);
+      if (var == nullptr || !var->IsType<framework::LoDTensor>()) continue;
+      auto& tensor = var->Get<framework::LoDTensor>();
+      if (!tensor.IsInitialized()) continue;
+      OpStatsRecorder::Instance().Record(OpStatsRecord{
+          GetGlobalStep(), type_, vname, ComputeTensorStats(tensor)});
+    }
+  }
+
+  if (ShouldCheckNANOrInf()) {
     for (auto& vname : OutputVars(true)) {
       auto* var = new_scope.FindVar(vname);
       if (var == nullptr) continue;
@@ -29,6 +29,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_desc.h"
 #include "paddle/fluid/framework/op_kernel_type.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/scratch_arena.h"
 #include "paddle/fluid/framework/selected_rows.h"
 #include "paddle/fluid/framework/shape_inference.h"
 #include "paddle/fluid/framework/tensor.h"
@@ -275,6 +276,19 @@ class ExecutionContext {
 
   platform::Place GetPlace() const { return device_context_.GetPlace(); }
 
+  //! The arena for kernel temporaries, rewound when the operator returns.
+  ScratchArena* scratch_arena() const {
+    return GetThreadScratchArena(device_context_.GetPlace());
+  }
+
+  //! Allocate a temporary tensor that lives until the operator returns.
+  template <typename T>
+  Tensor AllocateScratchTensor(const DDim& dims) const {
+    Tensor tensor;
+    scratch_arena()->AllocTensor<T>(dims, &tensor);
+    return tensor;
+  }
+
   template <typename DeviceContextType>
   const DeviceContextType& device_context() const {
     return *reinterpret_cast<const DeviceContextType*>(&device_context_);
@@ -564,6 +578,15 @@ class RuntimeInferShapeContext : public InferShapeContext {
 
 extern bool OpSupportGPU(const std::string& op_type);
 
+/**
+ * @brief   The number of steps, e.g., training iterations, finished so far.
+ *
+ * @note    Whoever drives the steps calls IncreaseGlobalStep at the end of
+ *          each, so that FLAGS_check_nan_inf_every_n_steps can sample them.
+ */
+int64_t GetGlobalStep();
+void IncreaseGlobalStep();
+
 }  // namespace framework
 }  // namespace fluid
 }  // namespace paddle
@@ -0,0 +1,289 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/quantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PADDLE_QUANTIZATION_WITH_AVX2
+#include <immintrin.h>
+#endif
+
+namespace paddle {
+namespace fluid {
+namespace framework {
+
+namespace {
+
+constexpr float kQMin = std::numeric_limits<int8_t>::min();
+constexpr float kQMax = std::numeric_limits<int8_t>::max();
+
+// The vector kernels do the same float operations in the same order as
+// the scalar ones, which finish their tails, so they give the same
+// results.  The clamping is written as MAXPS and MINPS compute it, which
+// maps NaN to kQMin.
+
+// A NaN input makes both min and max NaN, so that it can be reported.
+void MinMaxScalar(const float* in, size_t n, float* min, float* max) {
+  for (size_t i = 0; i < n; ++i) {
+    if (std::isnan(in[i])) {
+      *min = *max = in[i];
+      return;
+    }
+    *min = std::min(*min, in[i]);
+    *max = std::max(*max, in[i]);
+  }
+}
+
+void QuantizeScalar(const float* in,
+                    int8_t* out,
+                    size_t n,
+                    float inv_scale,
+                    float zero_point) {
+  for (size_t i = 0; i < n; ++i) {
+    float v = std::nearbyint(in[i] * inv_scale) + zero_point;
+    v = v > kQMin ? v : kQMin;
+    v = v < kQMax ? v : kQMax;
+    out[i] = static_cast<int8_t>(v);
+  }
+}
+
+void DequantizeScalar(
+    const int8_t* in, float* out, size_t n, float scale, int32_t zero_point) {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = static_cast<float>(in[i] - zero_point) * scale;
+  }
+}
+
+#ifdef PADDLE_QUANTIZATION_WITH_AVX2
+
+__attribute__((target("avx2"))) void MinMaxAVX2(const float* in,
+                                                size_t n,
+                                                float* min,
+                                                float* max) {
+  size_t i = 0;
+  if (n >= 8) {
+    __m256 vmin = _mm256_set1_ps(*min);
+    __m256 vmax = _mm256_set1_ps(*max);
+    __m256 vnan = _mm256_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+      __m256 v = _mm256_loadu_ps(in + i);
+      vmin = _mm256_min_ps(v, vmin);
+      vmax = _mm256_max_ps(v, vmax);
+      vnan = _mm256_or_ps(vnan, _mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+    }
+    if (_mm256_movemask_ps(vnan)) {
+      *min = *max = std::numeric_limits<float>::quiet_NaN();
+      return;
+    }
+    float mins[8], maxs[8];
+    _mm256_storeu_ps(mins, vmin);
+    _mm256_storeu_ps(maxs, vmax);
+    MinMaxScalar(mins, 8, min, max);
+    MinMaxScalar(maxs, 8, min, max);
+  }
+  MinMaxScalar(in + i, n - i, min, max);
+}
+
+__attribute__((target("avx2"))) void QuantizeAVX2(const float* in,
+                                                  int8_t* out,
+                                                  size_t n,
+                                                  float inv_scale,
+                                                  float zero_point) {
+  const __m256 inv = _mm256_set1_ps(inv_scale);
+  const __m256 zp = _mm256_set1_ps(zero_point);
+  const __m256 lo = _mm256_set1_ps(kQMin);
+  const __m256 hi = _mm256_set1_ps(kQMax);
+  // Undo the interleaving of the 128-bit lanes by the packs.
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i q[4];
+    for (int j = 0; j < 4; ++j) {
+      __m256 v = _mm256_mul_ps(_mm256_loadu_ps(in + i + 8 * j), inv);
+      v = _mm256_round_ps(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+      v = _mm256_add_ps(v, zp);
+      v = _mm256_min_ps(_mm256_max_ps(v, lo), hi);
+      q[j] = _mm256_cvtps_epi32(v);
+    }
+    __m256i packed = _mm256_packs_epi16(_mm256_packs_epi32(q[0], q[1]),
+                                        _mm256_packs_epi32(q[2], q[3]));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm256_permutevar8x32_epi32(packed, order));
+  }
+  QuantizeScalar(in + i, out + i, n - i, inv_scale, zero_point);
+}
+
+__attribute__((target("avx2"))) void DequantizeAVX2(
+    const int8_t* in, float* out, size_t n, float scale, int32_t zero_point) {
+  const __m256 vscale = _mm256_set1_ps(scale);
+  const __m256i zp = _mm256_set1_epi32(zero_point);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i));
+    __m256i q = _mm256_sub_epi32(_mm256_cvtepi8_epi32(v), zp);
+    _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(q), vscale));
+  }
+  DequantizeScalar(in + i, out + i, n - i, scale, zero_point);
+}
+
+#endif  // PADDLE_QUANTIZATION_WITH_AVX2
+
+struct Kernels {
+  void (*min_max)(const float*, size_t, float*, float*) = MinMaxScalar;
+  void (*quantize)(const float*, int8_t*, size_t, float, float) =
+      QuantizeScalar;
+  void (*dequantize)(const int8_t*, float*, size_t, float, int32_t) =
+      DequantizeScalar;
+
+  Kernels() {
+#ifdef PADDLE_QUANTIZATION_WITH_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      min_max = MinMaxAVX2;
+      quantize = QuantizeAVX2;
+      dequantize = DequantizeAVX2;
+    }
+#endif
+  }
+};
+
+const Kernels& GetKernels() {
+  static Kernels kernels;
+  return kernels;
+}
+
+// Calls fn(offset, size, channel) for each run of contiguous elements
+// sharing a channel.
+void ForEachChannel(const DDim& dims,
+                    int axis,
+                    const std::function<void(int64_t, int64_t, int)>& fn) {
+  int64_t numel = product(dims);
+  if (axis < 0) {
+    fn(0, numel, 0);
+    return;
+  }
+  int64_t channels = dims[axis];
+  int64_t inner = 1;
+  for (int i = axis + 1; i < arity(dims); ++i) inner *= dims[i];
+  for (int64_t offset = 0, c = 0; offset < numel; offset += inner) {
+    fn(offset, inner, static_cast<int>(c));
+    if (++c == channels) c = 0;
+  }
+}
+
+void CheckParams(const DDim& dims, const QuantizationParams& params) {
+  PADDLE_ENFORCE_EQ(params.scales.size(),
+                    params.zero_points.size(),
+                    "There must be a zero point for each scale.");
+  if (params.per_channel()) {
+    PADDLE_ENFORCE_LT(
+        params.axis, arity(dims), "The channel axis is out of range.");
+    PADDLE_ENFORCE_EQ(static_cast<int64_t>(params.channels()),
+                      dims[params.axis],
+                      "There must be a scale for each channel.");
+  } else {
+    PADDLE_ENFORCE_EQ(
+        params.channels(), 1UL, "A per-tensor mapping has one scale.");
+  }
+}
+
+}  // namespace
+
+QuantizationParams ChooseQuantizationParams(const Tensor& in, int axis) {
+  PADDLE_ENFORCE(platform::is_cpu_place(in.place()),
+                 "Quantization is only supported on CPU.");
+  Tensor src = in.Contiguous();
+  const float* data = src.data<float>();
+
+  QuantizationParams params;
+  params.axis = axis;
+  size_t channels = axis < 0 ? 1 : src.dims()[axis];
+  std::vector<float> mins(channels, 0.f);
+  std::vector<float> maxs(channels, 0.f);
+  auto& kernels = GetKernels();
+  ForEachChannel(
+      src.dims(), axis, [&](int64_t offset, int64_t size, int channel) {
+        kernels.min_max(data + offset, size, &mins[channel], &maxs[channel]);
+      });
+
+  for (size_t c = 0; c < channels; ++c) {
+    PADDLE_ENFORCE(!std::isnan(mins[c]) && !std::isnan(maxs[c]),
+                   "Cannot quantize a tensor with NaN.");
+    PADDLE_ENFORCE(std::isfinite(mins[c]) && std::isfinite(maxs[c]),
+                   "Cannot quantize a tensor with Inf.");
+    float scale = (maxs[c] - mins[c]) / (kQMax - kQMin);
+    if (scale == 0.f || !std::isfinite(scale)) scale = 1.f;
+    float zero_point = std::nearbyint(kQMin - mins[c] / scale);
+    zero_point = std::min(std::max(zero_point, kQMin), kQMax);
+    params.scales.push_back(scale);
+    params.zero_points.push_back(static_cast<int32_t>(zero_point));
+  }
+  return params;
+}
+
+void Quantize(const Tensor& in, const QuantizationParams& params, Tensor* out) {
+  PADDLE_ENFORCE(platform::is_cpu_place(in.place()),
+                 "Quantization is only supported on CPU.");
+  CheckParams(in.dims(), params);
+  Tensor src = in.Contiguous();
+  const float* in_data = src.data<float>();
+  out->Resize(src.dims());
+  out->set_layout(src.layout());
+  int8_t* out_data = out->mutable_data<int8_t>(platform::CPUPlace());
+
+  auto& kernels = GetKernels();
+  ForEachChannel(
+      src.dims(), params.axis, [&](int64_t offset, int64_t size, int c) {
+        kernels.quantize(in_data + offset,
+                         out_data + offset,
+                         size,
+                         1.f / params.scales[c],
+                         static_cast<float>(params.zero_points[c]));
+      });
+  out->set_quantization(std::make_shared<const QuantizationParams>(params));
+}
+
+void Dequantize(const Tensor& in, Tensor* out) {
+  PADDLE_ENFORCE(platform::is_cpu_place(in.place()),
+                 "Quantization is only supported on CPU.");
+  PADDLE_ENFORCE_NOT_NULL(in.quantization(), "The tensor is not quantized.");
+  Tensor src = in.Contiguous();
+  const QuantizationParams& params = *src.quantization();
+  CheckParams(src.dims(), params);
+  const int8_t* in_data = src.data<int8_t>();
+  out->Resize(src.dims());
+  out->set_layout(src.layout());
+  out->set_quantization(nullptr);
+  float* out_data = out->mutable_data<float>(platform::CPUPlace());
+
+  auto& kernels = GetKernels();
+  ForEachChannel(
+      src.dims(), params.axis, [&](int64_t offset, int64_t size, int c) {
+        kernels.dequantize(in_data + offset,
+                           out_data + offset,
+                           size,
+                           params.scales[c],
+                           params.zero_points[c]);
+      });
+}
+
+}  // namespace framework
+}  // namespace fluid
+}  // namespace paddle
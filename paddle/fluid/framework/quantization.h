@@ -0,0 +1,64 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "paddle/fluid/framework/tensor.h"
+
+namespace paddle {
+namespace fluid {
+namespace framework {
+
+/**
+ * @brief   The affine mapping of the int8 elements of a quantized tensor to
+ *          real numbers: real = (q - zero_point) * scale.
+ *
+ * @note    A per-tensor mapping has one scale and zero point, and axis -1.
+ *          A per-channel mapping has one of each for every index along
+ *          axis, e.g., the output channels of a filter.
+ */
+struct QuantizationParams {
+  int axis = -1;
+  std::vector<float> scales;
+  std::vector<int32_t> zero_points;
+
+  bool per_channel() const { return axis >= 0; }
+
+  /*! The number of scales, and the dimension along axis if per channel. */
+  size_t channels() const { return scales.size(); }
+};
+
+/**
+ * @brief   Choose the mapping covering the range of a float tensor, zero
+ *          included so that zero is exact.
+ *
+ * @param[in] axis   The channel axis, or -1 for one mapping for all.
+ */
+QuantizationParams ChooseQuantizationParams(const Tensor& in, int axis = -1);
+
+/**
+ * @brief   Quantize a float tensor on CPU into an int8 tensor carrying the
+ *          params, rounding to nearest even and saturating.
+ */
+void Quantize(const Tensor& in, const QuantizationParams& params, Tensor* out);
+
+/*! Map a quantized int8 tensor on CPU back to a float tensor. */
+void Dequantize(const Tensor& in, Tensor* out);
+
+}  // namespace framework
+}  // namespace fluid
+}  // namespace paddle
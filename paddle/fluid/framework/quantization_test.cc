@@ -0,0 +1,170 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/quantization.h"
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/tensor_util.h"
+
+namespace framework = paddle::fluid::framework;
+namespace platform = paddle::fluid::platform;
+
+TEST(Quantization, PerTensor) {
+  framework::Tensor in;
+  // Longer than a vector kernel step, with a tail.
+  const int n = 101;
+  float* data = in.mutable_data<float>(framework::make_ddim({n}),
+                                       platform::CPUPlace());
+  for (int i = 0; i < n; ++i) data[i] = -1.f + 4.f * i / (n - 1);
+  data[25] = 0.f;
+
+  auto params = framework::ChooseQuantizationParams(in);
+  EXPECT_FALSE(params.per_channel());
+  ASSERT_EQ(params.channels(), 1UL);
+  EXPECT_FLOAT_EQ(params.scales[0], 4.f / 255);
+  EXPECT_EQ(params.zero_points[0], -64);
+
+  framework::Tensor q;
+  framework::Quantize(in, params, &q);
+  EXPECT_EQ(q.type(), typeid(int8_t));
+  ASSERT_NE(q.quantization(), nullptr);
+  EXPECT_EQ(q.data<int8_t>()[0], -128);
+  EXPECT_EQ(q.data<int8_t>()[n - 1], 127);
+  EXPECT_EQ(q.data<int8_t>()[25], -64);
+
+  framework::Tensor out;
+  framework::Dequantize(q, &out);
+  EXPECT_EQ(out.quantization(), nullptr);
+  for (int i = 0; i < n; ++i) {
+    EXPECT_NEAR(out.data<float>()[i], data[i], params.scales[0] / 2 + 1e-6);
+  }
+  EXPECT_EQ(out.data<float>()[25], 0.f);
+}
+
+TEST(Quantization, Saturate) {
+  framework::Tensor in;
+  const int n = 67;
+  float* data = in.mutable_data<float>(framework::make_ddim({n}),
+                                       platform::CPUPlace());
+  for (int i = 0; i < n; ++i) data[i] = (i % 2 ? 1.f : -1.f) * i;
+  data[64] = std::numeric_limits<float>::quiet_NaN();
+
+  framework::QuantizationParams params;
+  params.scales = {0.5f};
+  params.zero_points = {10};
+  framework::Tensor q;
+  framework::Quantize(in, params, &q);
+  const int8_t* q_data = q.data<int8_t>();
+  for (int i = 0; i < n; ++i) {
+    if (i == 64) {
+      EXPECT_EQ(q_data[i], -128);
+      continue;
+    }
+    float expected = std::nearbyint(data[i] / 0.5f) + 10;
+    expected = std::min(std::max(expected, -128.f), 127.f);
+    EXPECT_EQ(q_data[i], static_cast<int8_t>(expected)) << i;
+  }
+}
+
+TEST(Quantization, PerChannel) {
+  framework::Tensor in;
+  const int channels = 3, size = 40;
+  float* data = in.mutable_data<float>(framework::make_ddim({channels, size}),
+                                       platform::CPUPlace());
+  for (int c = 0; c < channels; ++c) {
+    for (int i = 0; i < size; ++i) {
+      data[c * size + i] = (c + 1) * (c + 1) * (i - 10) * 0.1f;
+    }
+  }
+
+  auto params = framework::ChooseQuantizationParams(in, 0);
+  EXPECT_TRUE(params.per_channel());
+  ASSERT_EQ(params.channels(), 3UL);
+  EXPECT_LT(params.scales[0], params.scales[2]);
+
+  framework::Tensor q;
+  framework::Quantize(in, params, &q);
+  framework::Tensor out;
+  framework::Dequantize(q, &out);
+  for (int c = 0; c < channels; ++c) {
+    for (int i = 0; i < size; ++i) {
+      EXPECT_NEAR(out.data<float>()[c * size + i],
+                  data[c * size + i],
+                  params.scales[c] / 2 + 1e-5);
+    }
+  }
+
+  // Views carry the params of their channels.
+  framework::Tensor row = q.Slice(2, 3);
+  ASSERT_EQ(row.quantization()->channels(), 1UL);
+  EXPECT_EQ(row.quantization()->scales[0], params.scales[2]);
+  framework::Tensor row_out;
+  framework::Dequantize(row, &row_out);
+  EXPECT_EQ(row_out.data<float>()[7], out.data<float>()[2 * size + 7]);
+
+  framework::Tensor transposed = q.Transpose({1, 0});
+  EXPECT_EQ(transposed.quantization()->axis, 1);
+  framework::Tensor transposed_out;
+  framework::Dequantize(transposed, &transposed_out);
+  EXPECT_EQ(transposed_out.data<float>()[7 * channels + 1],
+            out.data<float>()[1 * size + 7]);
+}
+
+TEST(Quantization, NaN) {
+  framework::Tensor in;
+  const int n = 37;
+  float* data = in.mutable_data<float>(framework::make_ddim({n}),
+                                       platform::CPUPlace());
+  for (int i = 0; i < n; ++i) data[i] = i;
+  // Both in the vector steps and in the tail.
+  for (int i : {3, n - 1}) {
+    data[i] = std::numeric_limits<float>::quiet_NaN();
+    EXPECT_THROW(framework::ChooseQuantizationParams(in),
+                 paddle::fluid::platform::EnforceNotMet);
+    data[i] = i;
+  }
+}
+
+TEST(Quantization, Stream) {
+  framework::Tensor in;
+  const int channels = 2;
+  float* data = in.mutable_data<float>(framework::make_ddim({channels, 5}),
+                                       platform::CPUPlace());
+  for (int i = 0; i < channels * 5; ++i) data[i] = i * (i % 5);
+  framework::Tensor q;
+  framework::Quantize(in, framework::ChooseQuantizationParams(in, 0), &q);
+
+  platform::CPUDeviceContext ctx;
+  std::ostringstream os;
+  framework::TensorToStream(os, q, ctx);
+  std::istringstream is(os.str());
+  framework::Tensor loaded;
+  framework::TensorFromStream(is, &loaded, ctx);
+  ASSERT_NE(loaded.quantization(), nullptr);
+  EXPECT_EQ(loaded.quantization()->axis, 0);
+  EXPECT_EQ(loaded.quantization()->scales, q.quantization()->scales);
+  EXPECT_EQ(loaded.quantization()->zero_points,
+            q.quantization()->zero_points);
+
+  // Tensors which are not quantized stay so.
+  std::ostringstream plain_os;
+  framework::TensorToStream(plain_os, in, ctx);
+  std::istringstream plain_is(plain_os.str());
+  framework::TensorFromStream(plain_is, &loaded, ctx);
+  EXPECT_EQ(loaded.quantization(), nullptr);
+}
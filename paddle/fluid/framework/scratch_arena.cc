@@ -0,0 +1,166 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/scratch_arena.h"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/memory/malloc.h"
+
+DEFINE_uint64(scratch_arena_block_size_in_kb,
+              1024,
+              "The size of the first block of a kernel scratch arena.");
+DEFINE_uint64(scratch_arena_retain_size_in_kb,
+              64 * 1024,
+              "A scratch arena holding more memory than this returns it to "
+              "the allocator whenever it is rewound to the beginning.");
+
+namespace paddle {
+namespace fluid {
+namespace framework {
+
+namespace {
+
+void* AllocBlock(const platform::Place& place, size_t size) {
+  void* ptr = nullptr;
+  if (platform::is_cpu_place(place)) {
+    ptr = memory::Alloc(boost::get<platform::CPUPlace>(place), size);
+  } else {
+#ifdef PADDLE_WITH_CUDA
+    if (platform::is_gpu_place(place)) {
+      ptr = memory::Alloc(boost::get<platform::CUDAPlace>(place), size);
+    } else {
+      ptr = memory::Alloc(boost::get<platform::CUDAPinnedPlace>(place), size);
+    }
+#else
+    PADDLE_THROW(
+        "CUDAPlace or CUDAPinnedPlace is not supported in CPU-only mode.");
+#endif
+  }
+  PADDLE_ENFORCE_NOT_NULL(ptr, "Insufficient memory for the scratch arena.");
+  return ptr;
+}
+
+void FreeBlock(const platform::Place& place, void* ptr) {
+  if (platform::is_cpu_place(place)) {
+    memory::Free(boost::get<platform::CPUPlace>(place), ptr);
+  } else {
+#ifdef PADDLE_WITH_CUDA
+    if (platform::is_gpu_place(place)) {
+      memory::Free(boost::get<platform::CUDAPlace>(place), ptr);
+    } else {
+      memory::Free(boost::get<platform::CUDAPinnedPlace>(place), ptr);
+    }
+#endif
+  }
+}
+
+}  // namespace
+
+constexpr size_t ScratchArena::kAlignment;
+
+ScratchArena::ScratchArena(const platform::Place& place)
+    : place_(place),
+      next_block_size_(FLAGS_scratch_arena_block_size_in_kb << 10) {}
+
+ScratchArena::~ScratchArena() { FreeBlocks(); }
+
+uint8_t* ScratchArena::Fit(const Block& block,
+                           size_t offset,
+                           size_t size) const {
+  uintptr_t begin = reinterpret_cast<uintptr_t>(block.ptr) + offset;
+  uintptr_t aligned = (begin + kAlignment - 1) & ~(kAlignment - 1);
+  uintptr_t end = reinterpret_cast<uintptr_t>(block.ptr) + block.size;
+  if (aligned > end || end - aligned < size) return nullptr;
+  return reinterpret_cast<uint8_t*>(aligned);
+}
+
+void* ScratchArena::Alloc(size_t size) {
+  size = std::max<size_t>(size, 1);
+
+  // Try the current block, then the blocks left behind by a rewind.
+  for (size_t i = current_; i < blocks_.size(); ++i) {
+    uint8_t* p = Fit(blocks_[i], i == current_ ? offset_ : 0, size);
+    if (p != nullptr) {
+      current_ = i;
+      offset_ = p + size - blocks_[i].ptr;
+      return p;
+    }
+  }
+
+  Block block;
+  block.size = std::max(next_block_size_, size + kAlignment);
+  block.ptr = static_cast<uint8_t*>(AllocBlock(place_, block.size));
+  blocks_.push_back(block);
+  next_block_size_ = block.size * 2;
+
+  current_ = blocks_.size() - 1;
+  uint8_t* p = Fit(block, 0, size);
+  offset_ = p + size - block.ptr;
+  return p;
+}
+
+void ScratchArena::Rewind(const Mark& mark) {
+  current_ = mark.block;
+  offset_ = mark.offset;
+  if (current_ != 0 || offset_ != 0) return;
+
+  size_t capacity = Capacity();
+  if (capacity > (FLAGS_scratch_arena_retain_size_in_kb << 10)) {
+    FreeBlocks();
+    next_block_size_ = FLAGS_scratch_arena_block_size_in_kb << 10;
+  } else if (blocks_.size() > 1) {
+    // Steady-state kernels then fit in one block.
+    FreeBlocks();
+    next_block_size_ = capacity;
+  }
+}
+
+size_t ScratchArena::Used() const {
+  size_t used = offset_;
+  for (size_t i = 0; i < current_ && i < blocks_.size(); ++i) {
+    used += blocks_[i].size;
+  }
+  return used;
+}
+
+size_t ScratchArena::Capacity() const {
+  size_t capacity = 0;
+  for (auto& block : blocks_) capacity += block.size;
+  return capacity;
+}
+
+void ScratchArena::FreeBlocks() {
+  for (auto& block : blocks_) FreeBlock(place_, block.ptr);
+  blocks_.clear();
+  current_ = 0;
+  offset_ = 0;
+}
+
+ScratchArena* GetThreadScratchArena(const platform::Place& place) {
+  static thread_local std::unordered_map<platform::Place,
+                                         std::unique_ptr<ScratchArena>,
+                                         platform::PlaceHash>
+      arenas;
+  auto& arena = arenas[place];
+  if (arena == nullptr) arena.reset(new ScratchArena(place));
+  return arena.get();
+}
+
+}  // namespace framework
+}  // namespace fluid
+}  // namespace paddle
@@ -0,0 +1,127 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stddef.h>  // for size_t
+
+#include <typeindex>
+#include <vector>
+
+#include "paddle/fluid/framework/ddim.h"
+#include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace fluid {
+namespace framework {
+
+/**
+ * @brief   ScratchArena is a bump-pointer allocator for the temporaries
+ *          of operator kernels, which die when Compute returns.
+ *
+ * @note    OperatorWithKernel::RunImpl takes a Mark before running the
+ *          kernel and rewinds to it afterwards, so all the temporaries
+ *          of a kernel are freed at once, and nested operators do not
+ *          free those of their callers.  An arena is used by one thread.
+ */
+class ScratchArena {
+ public:
+  // The position of the bump pointer.
+  struct Mark {
+    size_t block;
+    size_t offset;
+  };
+
+  explicit ScratchArena(const platform::Place& place);
+  ~ScratchArena();
+
+  ScratchArena(const ScratchArena&) = delete;
+  ScratchArena& operator=(const ScratchArena&) = delete;
+
+  const platform::Place& place() const { return place_; }
+
+  /*! Allocate size bytes, aligned to kAlignment. */
+  void* Alloc(size_t size);
+
+  /**
+   * @brief   Back a tensor with arena memory.
+   *
+   * @note    The tensor must not be used after the arena is rewound past
+   *          this allocation, i.e., after the current operator returns.
+   */
+  template <typename T>
+  T* AllocTensor(const DDim& dims, Tensor* tensor) {
+    static_assert(std::is_pod<T>::value, "T must be POD");
+    tensor->Resize(dims);
+    size_t size = tensor->numel() * sizeof(T);
+    return static_cast<T*>(tensor->ShareExternalData(
+        Alloc(size), size, place_, std::type_index(typeid(T))));
+  }
+
+  Mark GetMark() const { return Mark{current_, offset_}; }
+
+  /**
+   * @brief   Free everything allocated after the mark.
+   *
+   * @note    Rewinding to the beginning also merges the blocks into one
+   *          block of the total size, or frees them if they exceed
+   *          FLAGS_scratch_arena_retain_size_in_kb.
+   */
+  void Rewind(const Mark& mark);
+
+  /*! The bytes allocated since the beginning. */
+  size_t Used() const;
+
+  /*! The bytes held from the memory allocator. */
+  size_t Capacity() const;
+
+  static constexpr size_t kAlignment = 64;
+
+ private:
+  struct Block {
+    uint8_t* ptr;
+    size_t size;
+  };
+
+  // Returns the aligned address if size bytes fit in the block after
+  // offset, or nullptr.
+  uint8_t* Fit(const Block& block, size_t offset, size_t size) const;
+  void FreeBlocks();
+
+  platform::Place place_;
+  std::vector<Block> blocks_;
+  size_t current_ = 0;  // the block of the bump pointer
+  size_t offset_ = 0;   // the bump pointer in blocks_[current_]
+  size_t next_block_size_;
+};
+
+/*! The scratch arena of the calling thread on a place. */
+ScratchArena* GetThreadScratchArena(const platform::Place& place);
+
+/*! Rewinds an arena to where it was when the guard was created. */
+class ScratchArenaGuard {
+ public:
+  explicit ScratchArenaGuard(ScratchArena* arena)
+      : arena_(arena), mark_(arena->GetMark()) {}
+  ~ScratchArenaGuard() { arena_->Rewind(mark_); }
+
+ private:
+  ScratchArena* arena_;
+  ScratchArena::Mark mark_;
+};
+
+}  // namespace framework
+}  // namespace fluid
+}  // namespace paddle
@@ -0,0 +1,86 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/scratch_arena.h"
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+
+DECLARE_uint64(scratch_arena_block_size_in_kb);
+
+namespace paddle {
+namespace fluid {
+namespace framework {
+
+TEST(ScratchArena, AllocRewind) {
+  ScratchArena arena(platform::CPUPlace{});
+  EXPECT_EQ(arena.Capacity(), 0UL);
+
+  void* a = arena.Alloc(100);
+  void* b = arena.Alloc(1);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % ScratchArena::kAlignment, 0UL);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % ScratchArena::kAlignment, 0UL);
+  EXPECT_GE(static_cast<uint8_t*>(b) - static_cast<uint8_t*>(a), 100);
+  EXPECT_EQ(arena.Capacity(), FLAGS_scratch_arena_block_size_in_kb << 10);
+
+  // A nested scope frees only its own allocations.
+  {
+    ScratchArenaGuard guard(&arena);
+    EXPECT_NE(arena.Alloc(10), b);
+  }
+  EXPECT_GT(static_cast<uint8_t*>(arena.Alloc(10)), static_cast<uint8_t*>(b));
+
+  arena.Rewind(ScratchArena::Mark{0, 0});
+  EXPECT_EQ(arena.Used(), 0UL);
+  EXPECT_EQ(arena.Alloc(100), a);
+}
+
+TEST(ScratchArena, Grow) {
+  ScratchArena arena(platform::CPUPlace{});
+  const size_t block_size = FLAGS_scratch_arena_block_size_in_kb << 10;
+  arena.Alloc(block_size / 2);
+  // Does not fit in the first block.
+  arena.Alloc(block_size);
+  EXPECT_GT(arena.Capacity(), 2 * block_size);
+  size_t capacity = arena.Capacity();
+
+  // Rewinding to the beginning merges the blocks into one.
+  arena.Rewind(ScratchArena::Mark{0, 0});
+  EXPECT_EQ(arena.Capacity(), 0UL);
+  arena.Alloc(block_size / 2);
+  arena.Alloc(block_size);
+  EXPECT_EQ(arena.Capacity(), capacity);
+}
+
+TEST(ScratchArena, Tensor) {
+  auto* arena = GetThreadScratchArena(platform::CPUPlace());
+  EXPECT_EQ(arena, GetThreadScratchArena(platform::CPUPlace()));
+
+  ScratchArenaGuard guard(arena);
+  Tensor tensor;
+  float* data = arena->AllocTensor<float>(make_ddim({3, 4}), &tensor);
+  EXPECT_EQ(tensor.data<float>(), data);
+  EXPECT_EQ(tensor.numel(), 12);
+  EXPECT_TRUE(platform::is_cpu_place(tensor.place()));
+  EXPECT_EQ(tensor.memory_size(), 12 * sizeof(float));
+
+  // Growing the tensor moves it out of the arena.
+  float* grown = tensor.mutable_data<float>(make_ddim({4, 4}),
+                                            platform::CPUPlace());
+  EXPECT_NE(grown, data);
+}
+
+}  // namespace framework
+}  // namespace fluid
+}  // namespace paddle
@@ -27,8 +27,11 @@ struct ReAllocateVisitor {
     framework::Tensor cpu_tensor;
     platform::CPUPlace cpu;
     T* ptr = cpu_tensor.mutable_data<T>(dims_, cpu);
+    // Read through a const reference, so a lazy copy about to be replaced
+    // is not copied first.
+    const framework::Tensor& old_tensor = *tensor_;
     const T* old_ptr =
-        tensor_->memory_size() == 0 ? nullptr : tensor_->data<T>();
+        old_tensor.memory_size() == 0 ? nullptr : old_tensor.data<T>();
     if (old_ptr != nullptr) {
       std::copy(old_ptr, old_ptr + tensor_->numel(), ptr);
     }
@@ -81,9 +84,8 @@ void SerializeToStream(std::ostream& os,
     auto& rows = selected_rows.rows();
     uint64_t size = rows.size();
     os.write(reinterpret_cast<const char*>(&size), sizeof(size));
-    for (uint64_t i = 0; i < size; ++i) {
-      os.write(reinterpret_cast<const char*>(&rows[i]), sizeof(rows[i]));
-    }
+    os.write(reinterpret_cast<const char*>(rows.data()),
+             size * sizeof(int64_t));
   }
   {
     // the 3st field, the height of SelectedRows
@@ -109,9 +111,7 @@ void DeserializeFromStream(std::istream& is,
     is.read(reinterpret_cast<char*>(&size), sizeof(size));
     auto& rows = *selected_rows->mutable_rows();
     rows.resize(size);
-    for (uint64_t i = 0; i < size; ++i) {
-      is.read(reinterpret_cast<char*>(&rows[i]), sizeof(int64_t));
-    }
+    is.read(reinterpret_cast<char*>(rows.data()), size * sizeof(int64_t));
   }
   {
     // the 3st field, the height of the SelectedRows
@@ -123,6 +123,24 @@ void DeserializeFromStream(std::istream& is,
   TensorFromStream(is, selected_rows->mutable_value(), dev_ctx);
 }
 
+std::vector<int64_t> SelectedRows::DirtyRows() const {
+  std::lock_guard<std::mutex> lock(*auto_grown_mutex_);
+  std::vector<int64_t> rows(dirty_rows_.begin(), dirty_rows_.end());
+  std::sort(rows.begin(), rows.end());
+  return rows;
+}
+
+std::vector<int64_t> SelectedRows::TakeDirtyRows() {
+  std::unordered_set<int64_t> dirty;
+  {
+    std::lock_guard<std::mutex> lock(*auto_grown_mutex_);
+    dirty.swap(dirty_rows_);
+  }
+  std::vector<int64_t> rows(dirty.begin(), dirty.end());
+  std::sort(rows.begin(), rows.end());
+  return rows;
+}
+
 bool SelectedRows::HasKey(int64_t key) const {
   return std::find(rows_.begin(), rows_.end(), key) == rows_.end() ? false
                                                                    : true;
@@ -194,6 +212,7 @@ bool SelectedRows::Set(int64_t key, const framework::Tensor& value) {
                         value,
                         static_cast<int64_t>(0),
                         value.numel()));
+  dirty_rows_.insert(index);
   return is_new_key;
 }
 
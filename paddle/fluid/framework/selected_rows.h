@@ -17,6 +17,7 @@ limitations under the License. */
 #include <algorithm>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -117,6 +118,35 @@ class SelectedRows {
     return static_cast<int64_t>(std::distance(rows_.begin(), it));
   }
 
+  /*
+   * @brief Mark the row at index of the value as changed since the last
+   *  snapshot, so that a delta checkpoint writes it.  Set marks the rows it
+   *  writes; kernels writing the value in place mark theirs.
+   */
+  void MarkDirty(int64_t index) {
+    std::lock_guard<std::mutex> lock(*auto_grown_mutex_);
+    dirty_rows_.insert(index);
+  }
+
+  /*
+   * @brief The indices of the rows changed since the last snapshot, sorted.
+   */
+  std::vector<int64_t> DirtyRows() const;
+
+  /*
+   * @brief The indices of the changed rows, sorted, forgotten at once, so
+   *  that rows marked while a snapshot is written stay for the next one.
+   */
+  std::vector<int64_t> TakeDirtyRows();
+
+  /*
+   * @brief Forget the changed rows, after a snapshot.
+   */
+  void ClearDirtyRows() {
+    std::lock_guard<std::mutex> lock(*auto_grown_mutex_);
+    dirty_rows_.clear();
+  }
+
   DDim GetCompleteDims() const {
     std::vector<int64_t> dims = vectorize(value_->dims());
     dims[0] = height_;
@@ -131,6 +161,8 @@ class SelectedRows {
   std::unique_ptr<Tensor> value_{nullptr};
   int64_t height_;
   std::unique_ptr<std::mutex> auto_grown_mutex_{nullptr};
+  // The indices of the rows written since the last snapshot.
+  std::unordered_set<int64_t> dirty_rows_;
 };
 
 /*
@@ -95,6 +95,21 @@ TEST_F(SelectedRowsTester, SparseTable) {
   ASSERT_EQ(non_key_pairs[0].first, non_key);
 }
 
+TEST_F(SelectedRowsTester, DirtyRows) {
+  platform::CPUPlace cpu;
+  framework::Tensor value;
+  value.mutable_data<float>(framework::make_ddim({1, 100}), cpu);
+  ASSERT_TRUE(selected_rows_->DirtyRows().empty());
+
+  selected_rows_->Set(7, value);
+  selected_rows_->Set(0, value);
+  selected_rows_->MarkDirty(1);
+  ASSERT_EQ(selected_rows_->DirtyRows(), std::vector<int64_t>({0, 1, 2}));
+
+  selected_rows_->ClearDirtyRows();
+  ASSERT_TRUE(selected_rows_->DirtyRows().empty());
+}
+
 }  // namespace framework
 }  // namespace fluid
 }  // namespace paddle
@@ -14,15 +14,179 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/tensor.h"
 
+#include <stdlib.h>
+
+#include <algorithm>
+#include <new>
+
+#include "paddle/fluid/framework/quantization.h"
+
 namespace paddle {
 namespace fluid {
 namespace framework {
 extern size_t SizeOfType(std::type_index type);
+
+namespace {
+
+std::atomic<size_t> cow_shared_bytes(0);
+std::atomic<size_t> cow_copied_bytes(0);
+
+bool IsContiguousStrides(const DDim& dims, const DDim& strides) {
+  int64_t expected = 1;
+  for (int i = arity(dims) - 1; i >= 0; --i) {
+    if (dims[i] != 1 && strides[i] != expected) return false;
+    expected *= dims[i];
+  }
+  return true;
+}
+
+// Copy the elements of a strided view densely into dst.
+void GatherStrided(const uint8_t* src,
+                   const DDim& dims,
+                   const DDim& strides,
+                   size_t elem_size,
+                   uint8_t* dst) {
+  int rank = arity(dims);
+  int64_t numel = product(dims);
+  if (numel == 0) return;
+  int64_t inner = dims[rank - 1];
+  int64_t inner_stride = strides[rank - 1] * elem_size;
+  std::vector<int64_t> index(rank, 0);
+  for (int64_t n = 0; n < numel; n += inner) {
+    const uint8_t* p = src;
+    for (int i = 0; i < rank - 1; ++i) {
+      p += index[i] * strides[i] * elem_size;
+    }
+    if (inner_stride == static_cast<int64_t>(elem_size)) {
+      std::memcpy(dst, p, inner * elem_size);
+      dst += inner * elem_size;
+    } else {
+      for (int64_t j = 0; j < inner; ++j, p += inner_stride) {
+        std::memcpy(dst, p, elem_size);
+        dst += elem_size;
+      }
+    }
+    for (int i = rank - 2; i >= 0; --i) {
+      if (++index[i] < dims[i]) break;
+      index[i] = 0;
+    }
+  }
+}
+
+// The params of the channels [begin, end) of a per-channel quantized
+// tensor.
+std::shared_ptr<const QuantizationParams> SliceChannels(
+    const std::shared_ptr<const QuantizationParams>& params,
+    int begin,
+    int end) {
+  auto sliced = std::make_shared<QuantizationParams>(*params);
+  sliced->scales.assign(params->scales.begin() + begin,
+                        params->scales.begin() + end);
+  sliced->zero_points.assign(params->zero_points.begin() + begin,
+                             params->zero_points.begin() + end);
+  return sliced;
+}
+
+}  // namespace
+
+void Tensor::Placeholder::PrepareWrite() {
+  std::vector<std::shared_ptr<Placeholder>> copies;
+  {
+    std::lock_guard<std::mutex> lock(copies_mutex_);
+    for (auto& weak : copies_) {
+      auto copy = weak.lock();
+      if (copy != nullptr) copies.push_back(copy);
+    }
+    copies_.clear();
+    copy_on_write_ = false;
+  }
+  // The copies still reading this block take the old data with them.
+  for (auto& copy : copies) {
+    static_cast<CopyOnWritePlaceholder*>(copy.get())->Materialize(this);
+  }
+}
+
+void Tensor::Placeholder::AddCopy(const std::shared_ptr<Placeholder>& copy) {
+  std::lock_guard<std::mutex> lock(copies_mutex_);
+  copies_.erase(std::remove_if(copies_.begin(),
+                               copies_.end(),
+                               [](const std::weak_ptr<Placeholder>& weak) {
+                                 return weak.expired();
+                               }),
+                copies_.end());
+  copies_.push_back(copy);
+  copy_on_write_ = true;
+}
+
+void Tensor::CopyOnWritePlaceholder::PrepareWrite() {
+  Placeholder::PrepareWrite();
+  Materialize(nullptr);
+}
+
+void Tensor::CopyOnWritePlaceholder::Materialize(const Placeholder* source) {
+  std::lock_guard<std::mutex> block_lock(block_mutex_);
+  if (materialized_ || (source != nullptr && block_.get() != source)) {
+    return;
+  }
+  size_t size = size_;
+  std::shared_ptr<Placeholder> block;
+  if (platform::is_cpu_place(place_)) {
+    auto cpu = boost::get<platform::CPUPlace>(place_);
+    block.reset(new PlaceholderImpl<platform::CPUPlace>(cpu, size, type_));
+    memory::Copy(cpu, block->ptr(), cpu, block_->ptr(), size);
+  } else {
+#ifdef PADDLE_WITH_CUDA
+    if (platform::is_gpu_place(place_)) {
+      auto gpu = boost::get<platform::CUDAPlace>(place_);
+      block.reset(new PlaceholderImpl<platform::CUDAPlace>(gpu, size, type_));
+      auto* ctx = static_cast<platform::CUDADeviceContext*>(
+          platform::DeviceContextPool::Instance().Get(gpu));
+      memory::Copy(gpu, block->ptr(), gpu, block_->ptr(), size, ctx->stream());
+      ctx->Wait();
+    } else {
+      auto pinned = boost::get<platform::CUDAPinnedPlace>(place_);
+      block.reset(
+          new PlaceholderImpl<platform::CUDAPinnedPlace>(pinned, size, type_));
+      memory::Copy(pinned, block->ptr(), pinned, block_->ptr(), size);
+    }
+#else
+    PADDLE_THROW(
+        "CUDAPlace or CUDAPinnedPlace is not supported in CPU-only mode.");
+#endif
+  }
+  block_ = block;
+  ptr_.store(block->ptr(), std::memory_order_release);
+  materialized_ = true;
+  cow_copied_bytes += size;
+
+  std::lock_guard<std::mutex> lock(copies_mutex_);
+  copy_on_write_ = !copies_.empty();
+}
+
+constexpr size_t Tensor::InlinePlaceholder::kCapacity;
+
+void* Tensor::InlinePlaceholder::operator new(size_t size) {
+  void* p = nullptr;
+  if (posix_memalign(&p, alignof(InlinePlaceholder), size) != 0) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void Tensor::InlinePlaceholder::operator delete(void* p) { free(p); }
+
+CopyOnWriteStats GetCopyOnWriteStats() {
+  CopyOnWriteStats stats;
+  stats.shared_bytes = cow_shared_bytes;
+  stats.copied_bytes = cow_copied_bytes;
+  return stats;
+}
+
 void Tensor::check_memory_size() const {
   PADDLE_ENFORCE_NOT_NULL(
       holder_, "Tensor holds no memory. Call Tensor::mutable_data first.");
   PADDLE_ENFORCE_LE(
-      numel() * SizeOfType(type()),
+      span() * SizeOfType(type()),
       memory_size(),
       "Tensor's dims_ is out of bound. Call Tensor::mutable_data "
       "first to re-allocate memory.\n"
@@ -42,11 +206,17 @@ void* Tensor::mutable_data(platform::Place place, std::type_index type) {
                     "When calling this method, the Tensor's numel must be "
                     "equal or larger than zero. "
                     "Please check Tensor::Resize has been called first.");
-  int64_t size = numel() * SizeOfType(type);
+  int64_t size = span() * SizeOfType(type);
   /* some versions of boost::variant don't have operator!= */
   if (holder_ == nullptr || !(holder_->place() == place) ||
       holder_->size() < size + offset_) {
-    if (platform::is_cpu_place(place)) {
+    // A view which does not fit is replaced by a new contiguous tensor.
+    contiguous_ = true;
+    size = numel() * SizeOfType(type);
+    if (platform::is_cpu_place(place) &&
+        size <= static_cast<int64_t>(InlinePlaceholder::kCapacity)) {
+      holder_.reset(new InlinePlaceholder(size, type));
+    } else if (platform::is_cpu_place(place)) {
       holder_.reset(new PlaceholderImpl<platform::CPUPlace>(
           boost::get<platform::CPUPlace>(place), size, type));
     } else if (platform::is_gpu_place(place) ||
@@ -66,11 +236,26 @@ void* Tensor::mutable_data(platform::Place place, std::type_index type) {
     }
 #endif
     offset_ = 0;
+  } else if (holder_->copy_on_write_) {
+    holder_->PrepareWrite();
   }
   return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(holder_->ptr()) +
                                  offset_);
 }
 
+void* Tensor::ShareExternalData(void* ptr,
+                                size_t size,
+                                platform::Place place,
+                                std::type_index type,
+                                std::function<void(void*)> deleter) {
+  PADDLE_ENFORCE_NOT_NULL(ptr, "Cannot share a null memory block.");
+  holder_.reset(
+      new ExternalPlaceholder(ptr, size, place, type, std::move(deleter)));
+  offset_ = 0;
+  contiguous_ = true;
+  return ptr;
+}
+
 void* Tensor::mutable_data(platform::Place place) {
   PADDLE_ENFORCE(this->holder_ != nullptr,
                  "Cannot invoke mutable data if current hold nothing.");
@@ -83,7 +268,18 @@ Tensor& Tensor::ShareDataWith(const Tensor& src) {
   return *this;
 }
 
+Tensor& Tensor::CopyOnWriteFrom(const Tensor& src) {
+  src.check_memory_size();
+  std::shared_ptr<Placeholder> copy(new CopyOnWritePlaceholder(src.holder_));
+  src.holder_->AddCopy(copy);
+  cow_shared_bytes += copy->size();
+  *this = src;
+  holder_ = copy;
+  return *this;
+}
+
 Tensor Tensor::Slice(int begin_idx, int end_idx) const {
+  if (!contiguous_) return Slice(begin_idx, end_idx, 0);
   check_memory_size();
   PADDLE_ENFORCE_GE(
       begin_idx, 0, "The start row index must be greater than 0.");
@@ -104,11 +300,170 @@ Tensor Tensor::Slice(int begin_idx, int end_idx) const {
     dst_dims[0] = end_idx - begin_idx;
     dst.Resize(dst_dims);
     dst.offset_ = offset_ + begin_idx * base * SizeOfType(type());
+    dst.quantization_ = quantization_;
+    if (quantization_ && quantization_->axis == 0) {
+      dst.quantization_ = SliceChannels(quantization_, begin_idx, end_idx);
+    }
     return dst;
   }
 }
 
+Tensor Tensor::Slice(int begin_idx, int end_idx, int axis) const {
+  check_memory_size();
+  PADDLE_ENFORCE(axis >= 0 && axis < arity(dims_),
+                 "The axis %d is out of range.",
+                 axis);
+  PADDLE_ENFORCE_GE(
+      begin_idx, 0, "The start index must be greater than 0.");
+  PADDLE_ENFORCE_LE(end_idx, dims_[axis], "The end index is out of bound.");
+  PADDLE_ENFORCE_LT(begin_idx,
+                    end_idx,
+                    "The start index must be lesser than the end index.");
+  if (axis == 0 && contiguous_) return Slice(begin_idx, end_idx);
+
+  DDim strides = this->strides();
+  Tensor dst = *this;
+  dst.dims_[axis] = end_idx - begin_idx;
+  dst.offset_ = offset_ + begin_idx * strides[axis] * SizeOfType(type());
+  dst.SetStrides(strides);
+  if (quantization_ && quantization_->axis == axis) {
+    dst.quantization_ = SliceChannels(quantization_, begin_idx, end_idx);
+  }
+  return dst;
+}
+
+Tensor Tensor::Transpose(const std::vector<int>& axis) const {
+  check_memory_size();
+  int rank = arity(dims_);
+  PADDLE_ENFORCE_EQ(static_cast<int>(axis.size()),
+                    rank,
+                    "The axis must be a permutation of the dims.");
+  std::vector<bool> seen(rank, false);
+  DDim strides = this->strides();
+  DDim dst_dims = dims_;
+  DDim dst_strides = strides;
+  for (int i = 0; i < rank; ++i) {
+    PADDLE_ENFORCE(axis[i] >= 0 && axis[i] < rank && !seen[axis[i]],
+                   "The axis must be a permutation of the dims.");
+    seen[axis[i]] = true;
+    dst_dims[i] = dims_[axis[i]];
+    dst_strides[i] = strides[axis[i]];
+  }
+
+  Tensor dst = *this;
+  dst.dims_ = dst_dims;
+  dst.SetStrides(dst_strides);
+  if (quantization_ && quantization_->per_channel()) {
+    auto params = std::make_shared<QuantizationParams>(*quantization_);
+    params->axis = static_cast<int>(
+        std::find(axis.begin(), axis.end(), quantization_->axis) -
+        axis.begin());
+    dst.quantization_ = params;
+  }
+  return dst;
+}
+
+Tensor Tensor::Broadcast(const DDim& dims) const {
+  check_memory_size();
+  int rank = arity(dims_);
+  int dst_rank = arity(dims);
+  PADDLE_ENFORCE_GE(
+      dst_rank, rank, "Cannot broadcast to dims of a lower rank.");
+  DDim strides = this->strides();
+  DDim dst_strides = dims;
+  for (int i = dst_rank - 1, j = rank - 1; i >= 0; --i, --j) {
+    if (j < 0 || dims_[j] == 1) {
+      dst_strides[i] = 0;
+    } else {
+      PADDLE_ENFORCE_EQ(
+          dims_[j], dims[i], "Cannot broadcast dimension %d.", j);
+      dst_strides[i] = strides[j];
+    }
+  }
+
+  Tensor dst = *this;
+  dst.dims_ = dims;
+  dst.SetStrides(dst_strides);
+  if (quantization_ && quantization_->per_channel()) {
+    auto params = std::make_shared<QuantizationParams>(*quantization_);
+    params->axis += dst_rank - rank;
+    if (dims_[quantization_->axis] == 1) {
+      // All the broadcast elements share the one channel.
+      params->axis = -1;
+    }
+    dst.quantization_ = params;
+  }
+  return dst;
+}
+
+DDim Tensor::strides() const { return contiguous_ ? stride(dims_) : strides_; }
+
+Tensor Tensor::Contiguous() const {
+  if (contiguous_) return *this;
+  check_memory_size();
+
+  Tensor dst;
+  dst.Resize(dims_);
+  dst.set_layout(layout_);
+  dst.quantization_ = quantization_;
+  size_t elem_size = SizeOfType(type());
+  auto* src_ptr = reinterpret_cast<const uint8_t*>(holder_->ptr()) + offset_;
+  auto place = holder_->place();
+  if (platform::is_gpu_place(place)) {
+#ifdef PADDLE_WITH_CUDA
+    // Gather on the host, as the views are only materialized when a
+    // kernel cannot handle them.
+    auto gpu = boost::get<platform::CUDAPlace>(place);
+    platform::CPUPlace cpu;
+    auto* ctx = static_cast<platform::CUDADeviceContext*>(
+        platform::DeviceContextPool::Instance().Get(gpu));
+    size_t span_size = span() * elem_size;
+    std::vector<uint8_t> src_buf(span_size);
+    std::vector<uint8_t> dst_buf(numel() * elem_size);
+    memory::Copy(
+        cpu, src_buf.data(), gpu, src_ptr, span_size, ctx->stream());
+    ctx->Wait();
+    GatherStrided(
+        src_buf.data(), dims_, strides_, elem_size, dst_buf.data());
+    memory::Copy(gpu,
+                 dst.mutable_data(place, type()),
+                 cpu,
+                 dst_buf.data(),
+                 dst_buf.size(),
+                 ctx->stream());
+    ctx->Wait();
+#else
+    PADDLE_THROW("CUDAPlace is not supported in CPU-only mode.");
+#endif
+  } else {
+    GatherStrided(src_ptr,
+                  dims_,
+                  strides_,
+                  elem_size,
+                  static_cast<uint8_t*>(dst.mutable_data(place, type())));
+  }
+  return dst;
+}
+
+void Tensor::SetStrides(const DDim& strides) {
+  contiguous_ = IsContiguousStrides(dims_, strides);
+  if (!contiguous_) strides_ = strides;
+}
+
+int64_t Tensor::span() const {
+  if (contiguous_) return numel();
+  int64_t span = 1;
+  for (int i = 0; i < arity(dims_); ++i) {
+    if (dims_[i] == 0) return 0;
+    span += (dims_[i] - 1) * strides_[i];
+  }
+  return span;
+}
+
 Tensor& Tensor::Resize(const DDim& dims) {
+  PADDLE_ENFORCE(contiguous_ || dims == dims_,
+                 "Cannot resize a non-contiguous view, call "
+                 "Tensor::Contiguous first.");
   dims_ = dims;
   return *this;
 }
@@ -14,10 +14,14 @@ limitations under the License. */
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <typeindex>
+#include <utility>
 #include <vector>
 
 #include "paddle/fluid/framework/ddim.h"
@@ -31,6 +35,8 @@ namespace paddle {
 namespace fluid {
 namespace framework {
 
+struct QuantizationParams;
+
 class Tensor {
  public:
   template <typename T, size_t D, int MajorType, typename IndexType>
@@ -43,15 +49,20 @@ class Tensor {
   friend struct EigenVector;
 
  public:
-  Tensor() : layout_(TensorDataLayout::kNCHW), offset_(0) {}
+  Tensor()
+      : layout_(TensorDataLayout::kNCHW), offset_(0), contiguous_(true) {}
 
   /*! Constructor with place should only be used in pybind. */
   explicit Tensor(const platform::Place& place)
-      : layout_(TensorDataLayout::kNCHW), offset_(0) {
+      : layout_(TensorDataLayout::kNCHW), offset_(0), contiguous_(true) {
     holder_->set_place(place);
   }
 
-  /*! Return a pointer to mutable memory block. */
+  /**
+   * @brief   Return a pointer to mutable memory block.
+   * @note    A block shared by a lazy copy is copied first, as with
+   *          mutable_data; read through the const overload to avoid it.
+   */
   template <typename T>
   T* data();
 
@@ -61,6 +72,11 @@ class Tensor {
 
   bool IsInitialized() const;
 
+  /*! Whether writing the memory block copies it first, see CopyOnWriteFrom. */
+  bool IsCopyOnWrite() const {
+    return holder_ != nullptr && holder_->copy_on_write_;
+  }
+
   /**
    * @brief   Return a pointer to mutable memory block.
    * @note    If not exist, then allocation.
@@ -83,18 +99,57 @@ class Tensor {
   template <typename T>
   T* mutable_data(DDim dims, platform::Place place);
 
+  /**
+   * @brief     Use a memory block owned elsewhere without copying it, e.g.,
+   *            the buffer of a feeder, an mmaped file or a ScratchArena.
+   *
+   * @param[in] ptr     The memory block.
+   * @param[in] size    The size of the memory block in bytes.
+   * @param[in] place   The place of the memory block.
+   * @param[in] type    The element type.
+   * @param[in] deleter Called with ptr when the last tensor sharing the
+   *                    block releases it, to unmap or unpin it, or to
+   *                    drop a reference to its owner.
+   *
+   * @note      Without a deleter, the tensor must not be used after the
+   *            owner frees the block.  mutable_data still allocates a
+   *            new block if this one is too small.
+   */
+  void* ShareExternalData(void* ptr,
+                          size_t size,
+                          platform::Place place,
+                          std::type_index type,
+                          std::function<void(void*)> deleter = nullptr);
+
   /*! Return the dimensions of the memory block. */
   const DDim& dims() const;
 
   /*! Return the numel of the memory block. */
   int64_t numel() const;
 
-  /*! Resize the dimensions of the memory block. */
+  /**
+   * @brief   Resize the dimensions of the memory block.
+   *
+   * @note    A non-contiguous view cannot be resized to other dims.
+   */
   Tensor& Resize(const DDim& dims);
 
   /*! The internal of two tensors share the same memory block. */
   Tensor& ShareDataWith(const Tensor& src);
 
+  /**
+   * @brief   Copy src lazily.
+   *
+   * @note    The two tensors read the same memory block until either of
+   *          them, or a tensor sharing data with them, is first written
+   *          through mutable_data or the non-const data<T>(), which then
+   *          copies the block; the const data<T>() never copies.  Pointers
+   *          returned before this call must not be written through
+   *          afterwards, and a pointer read from the copy is only valid
+   *          until the source is next written.
+   */
+  Tensor& CopyOnWriteFrom(const Tensor& src);
+
   /**
    * @brief  Return a sub-tensor of the given tensor.
    *
@@ -105,6 +160,52 @@ class Tensor {
    */
   Tensor Slice(int begin_idx, int end_idx) const;
 
+  /**
+   * @brief  Return a view of the given tensor sliced along any axis.
+   *
+   * @param[in] begin_idx   The index of the start element(inclusive) of
+   *                        the slice along axis.
+   * @param[in] end_idx     The index of the end element(exclusive).
+   * @param[in] axis        The axis to slice.
+   *
+   * @note   The view is not contiguous unless axis is the first
+   *         non-trivial axis.
+   */
+  Tensor Slice(int begin_idx, int end_idx, int axis) const;
+
+  /**
+   * @brief  Return a view whose i-th dimension is the axis[i]-th
+   *         dimension of the given tensor, without copying.
+   */
+  Tensor Transpose(const std::vector<int>& axis) const;
+
+  /**
+   * @brief  Return a view broadcasting the given tensor to dims, without
+   *         copying.
+   *
+   * @note   As in numpy, the dims are aligned from the last one, and a
+   *         dimension of the tensor must be 1 or equal to the one in dims.
+   */
+  Tensor Broadcast(const DDim& dims) const;
+
+  /**
+   * @brief  The distance in elements between two neighbours along each
+   *         dimension; 0 along broadcast dimensions.
+   *
+   * @note   Kernels reading a view, which data<T>() points at the first
+   *         element of, must honour the strides.
+   */
+  DDim strides() const;
+
+  /*! Whether the elements are laid out densely in row-major order. */
+  bool IsContiguous() const { return contiguous_; }
+
+  /**
+   * @brief  Return the tensor if it is contiguous, or else a contiguous
+   *         copy of it, for kernels which only handle contiguous tensors.
+   */
+  Tensor Contiguous() const;
+
   platform::Place place() const {
     PADDLE_ENFORCE_NOT_NULL(
         holder_, "Tensor not initialized yet when Tensor::place() is called.");
@@ -126,6 +227,21 @@ class Tensor {
 
   void set_layout(const TensorDataLayout layout) { layout_ = layout; }
 
+  /**
+   * @brief   The mapping of the elements of an int8 tensor to reals, or
+   *          nullptr if the tensor is not quantized.
+   *
+   * @note    Views of the tensor carry it along, sliced or permuted with
+   *          the channel axis.
+   */
+  const std::shared_ptr<const QuantizationParams>& quantization() const {
+    return quantization_;
+  }
+
+  void set_quantization(std::shared_ptr<const QuantizationParams> params) {
+    quantization_ = std::move(params);
+  }
+
  private:
   /**
    * @note    Placeholder hides type T, so it doesn't appear as a template
@@ -139,6 +255,21 @@ class Tensor {
     virtual platform::Place place() const = 0;
     virtual void set_type(std::type_index type) = 0;
     virtual void set_place(platform::Place place) = 0;
+
+    /*! Copy the memory block wherever needed before it is written. */
+    virtual void PrepareWrite();
+
+    /*! Register a lazy copy reading this memory block. */
+    void AddCopy(const std::shared_ptr<Placeholder>& copy);
+
+    /**
+     * @note    Set if this block is read by a lazy copy, or is itself
+     *          one, so that writing it calls PrepareWrite.
+     */
+    std::atomic<bool> copy_on_write_{false};
+
+    std::mutex copies_mutex_;
+    std::vector<std::weak_ptr<Placeholder>> copies_;
   };
 
   template <typename Place>
@@ -174,6 +305,108 @@ class Tensor {
     std::type_index type_;
   };
 
+  /**
+   * @brief   Placeholder holding a tiny CPU memory block in itself.
+   *
+   * @note    Scalars, e.g., the learning rate or the beta powers of Adam,
+   *          then take neither a min chunk of the allocator nor its lock.
+   *          The block keeps the 32-byte alignment of the allocator.
+   */
+  struct InlinePlaceholder : public Placeholder {
+    static constexpr size_t kCapacity = 64;
+
+    InlinePlaceholder(size_t size, std::type_index type)
+        : size_(size), type_(type) {}
+
+    virtual size_t size() const { return size_; }
+    virtual platform::Place place() const { return platform::CPUPlace(); }
+    virtual void* ptr() const { return const_cast<uint8_t*>(data_); }
+    virtual std::type_index type() const { return type_; }
+    virtual void set_type(std::type_index type) { type_ = type; }
+    virtual void set_place(platform::Place place) {
+      PADDLE_ENFORCE(platform::is_cpu_place(place),
+                     "An inline memory block must be on CPU.");
+    }
+
+    // new honors alignments above 16 bytes only since C++17.
+    static void* operator new(size_t size);
+    static void operator delete(void* p);
+
+    alignas(32) uint8_t data_[kCapacity];
+    size_t size_;
+    std::type_index type_;
+  };
+
+  /*! Placeholder of a memory block owned by someone else. */
+  struct ExternalPlaceholder : public Placeholder {
+    ExternalPlaceholder(void* ptr,
+                        size_t size,
+                        platform::Place place,
+                        std::type_index type,
+                        std::function<void(void*)> deleter)
+        : ptr_(ptr),
+          place_(place),
+          size_(size),
+          type_(type),
+          deleter_(std::move(deleter)) {}
+
+    virtual ~ExternalPlaceholder() {
+      if (deleter_) deleter_(ptr_);
+    }
+
+    virtual size_t size() const { return size_; }
+    virtual platform::Place place() const { return place_; }
+    virtual void* ptr() const { return ptr_; }
+    virtual std::type_index type() const { return type_; }
+    virtual void set_type(std::type_index type) { type_ = type; }
+    virtual void set_place(platform::Place place) { place_ = place; }
+
+    void* ptr_;
+    platform::Place place_;
+    size_t size_;
+    std::type_index type_;
+    std::function<void(void*)> deleter_;
+  };
+
+  /*! Placeholder of a lazy copy, see CopyOnWriteFrom. */
+  struct CopyOnWritePlaceholder : public Placeholder {
+    explicit CopyOnWritePlaceholder(std::shared_ptr<Placeholder> source)
+        : block_(source),
+          ptr_(source->ptr()),
+          size_(source->size()),
+          place_(source->place()),
+          type_(source->type()) {
+      copy_on_write_ = true;
+    }
+
+    virtual size_t size() const { return size_; }
+    virtual platform::Place place() const { return place_; }
+    virtual void* ptr() const { return ptr_.load(std::memory_order_acquire); }
+    virtual std::type_index type() const { return type_; }
+    virtual void set_type(std::type_index type) { type_ = type; }
+    virtual void set_place(platform::Place place) { place_ = place; }
+    virtual void PrepareWrite();
+
+    /**
+     * @brief   Copy the source block into a block of its own, if it still
+     *          reads source, or any block if source is null.
+     *
+     * @note    Called by the threads writing the copy or its source, so
+     *          block_ is only changed under block_mutex_, and ptr_ is
+     *          published atomically for the readers.
+     */
+    void Materialize(const Placeholder* source);
+
+    /*! The source block until materialized, guarded by block_mutex_. */
+    std::shared_ptr<Placeholder> block_;
+    std::mutex block_mutex_;
+    std::atomic<void*> ptr_;
+    std::atomic<bool> materialized_{false};
+    const size_t size_;
+    platform::Place place_;
+    std::type_index type_;
+  };
+
   /*! holds the memory block if allocated. */
   std::shared_ptr<Placeholder> holder_;
 
@@ -208,8 +441,36 @@ class Tensor {
    *          PlaceHolder::ptr_ and where the tensor data really begins.
    */
   size_t offset_;
+
+  /**
+   * @brief   Views created by Slice along other axes, Transpose and
+   *          Broadcast are not contiguous, and their elements are
+   *          strides_ apart.
+   *
+   * @note    strides_ is only set if contiguous_ is false.
+   */
+  bool contiguous_;
+  DDim strides_;
+
+  std::shared_ptr<const QuantizationParams> quantization_;
+
+  void SetStrides(const DDim& strides);
+
+  /*! The number of elements from the first to the last one, inclusive. */
+  int64_t span() const;
+};
+
+/*! Counters of the bytes copied lazily by Tensor::CopyOnWriteFrom. */
+struct CopyOnWriteStats {
+  size_t shared_bytes = 0;  // the bytes of all lazy copies
+  size_t copied_bytes = 0;  // the bytes materialized by a write
+
+  /*! The copying avoided so far, as long as no lazy copy is written later. */
+  size_t avoided_bytes() const { return shared_bytes - copied_bytes; }
 };
 
+CopyOnWriteStats GetCopyOnWriteStats();
+
 }  // namespace framework
 }  // namespace fluid
 }  // namespace paddle
@@ -41,6 +41,7 @@ inline T* Tensor::data() {
                      holder_->type() == std::type_index(typeid(T)),
                  "Tensor holds the wrong type, it holds %s",
                  this->holder_->type().name());
+  if (holder_->copy_on_write_) holder_->PrepareWrite();
   return reinterpret_cast<T*>(reinterpret_cast<uintptr_t>(holder_->ptr()) +
                               offset_);
 }
@@ -0,0 +1,253 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/tensor_stats.h"
+
+#include <gflags/gflags.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/platform/float16.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PADDLE_TENSOR_STATS_WITH_AVX2
+#include <immintrin.h>
+#endif
+
+DEFINE_int32(op_stats_buffer_size,
+             4096,
+             "The number of operator output statistics kept by the global "
+             "OpStatsRecorder.");
+
+namespace paddle {
+namespace fluid {
+namespace framework {
+
+namespace {
+
+// The running sums of a pass.  Sums are kept in double, so that long
+// float tensors do not lose their small elements.
+struct Accumulator {
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+  double sum = 0;
+  double sum_of_squares = 0;
+  int64_t zeros = 0;
+};
+
+template <typename T>
+void AccumulateScalar(const T* data, size_t n, Accumulator* acc) {
+  for (size_t i = 0; i < n; ++i) {
+    double v = static_cast<double>(data[i]);
+    // Written as MINPS and MAXPS compute it, which skips NaN.
+    acc->min = v < acc->min ? v : acc->min;
+    acc->max = v > acc->max ? v : acc->max;
+    acc->sum += v;
+    acc->sum_of_squares += v * v;
+    acc->zeros += v == 0;
+  }
+}
+
+#ifdef PADDLE_TENSOR_STATS_WITH_AVX2
+
+__attribute__((target("avx2"))) void AccumulateAVX2(const float* data,
+                                                    size_t n,
+                                                    Accumulator* acc) {
+  size_t i = 0;
+  if (n >= 8) {
+    __m256 vmin = _mm256_set1_ps(static_cast<float>(acc->min));
+    __m256 vmax = _mm256_set1_ps(static_cast<float>(acc->max));
+    __m256d sum[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d squares[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    const __m256 zero = _mm256_setzero_ps();
+    int64_t zeros = 0;
+    for (; i + 8 <= n; i += 8) {
+      __m256 v = _mm256_loadu_ps(data + i);
+      vmin = _mm256_min_ps(v, vmin);
+      vmax = _mm256_max_ps(v, vmax);
+      __m256d half[2] = {_mm256_cvtps_pd(_mm256_castps256_ps128(v)),
+                         _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1))};
+      for (int j = 0; j < 2; ++j) {
+        sum[j] = _mm256_add_pd(sum[j], half[j]);
+        squares[j] =
+            _mm256_add_pd(squares[j], _mm256_mul_pd(half[j], half[j]));
+      }
+      zeros += __builtin_popcount(
+          _mm256_movemask_ps(_mm256_cmp_ps(v, zero, _CMP_EQ_OQ)));
+    }
+    float mins[8], maxs[8];
+    double sums[4], sums_of_squares[4];
+    _mm256_storeu_ps(mins, vmin);
+    _mm256_storeu_ps(maxs, vmax);
+    _mm256_storeu_pd(sums, _mm256_add_pd(sum[0], sum[1]));
+    _mm256_storeu_pd(sums_of_squares, _mm256_add_pd(squares[0], squares[1]));
+    for (int j = 0; j < 8; ++j) {
+      acc->min = std::min<double>(acc->min, mins[j]);
+      acc->max = std::max<double>(acc->max, maxs[j]);
+    }
+    for (int j = 0; j < 4; ++j) {
+      acc->sum += sums[j];
+      acc->sum_of_squares += sums_of_squares[j];
+    }
+    acc->zeros += zeros;
+  }
+  AccumulateScalar(data + i, n - i, acc);
+}
+
+#endif  // PADDLE_TENSOR_STATS_WITH_AVX2
+
+bool HasAVX2() {
+#ifdef PADDLE_TENSOR_STATS_WITH_AVX2
+  static bool has_avx2 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+  }();
+  return has_avx2;
+#else
+  return false;
+#endif
+}
+
+void Accumulate(const float* data, size_t n, Accumulator* acc) {
+#ifdef PADDLE_TENSOR_STATS_WITH_AVX2
+  if (HasAVX2()) {
+    AccumulateAVX2(data, n, acc);
+    return;
+  }
+#endif
+  AccumulateScalar(data, n, acc);
+}
+
+template <typename T>
+void Accumulate(const T* data, size_t n, Accumulator* acc) {
+  AccumulateScalar(data, n, acc);
+}
+
+// 16-bit floats are widened into a buffer on the stack a block at a time.
+template <typename T, void (*ToFloat)(const T*, float*, size_t)>
+void AccumulateWidened(const T* data, size_t n, Accumulator* acc) {
+  constexpr size_t kBlock = 1024;
+  float block[kBlock];
+  for (size_t i = 0; i < n; i += kBlock) {
+    size_t size = std::min(kBlock, n - i);
+    ToFloat(data + i, block, size);
+    Accumulate(block, size, acc);
+  }
+}
+
+template <>
+void Accumulate(const platform::float16* data, size_t n, Accumulator* acc) {
+  AccumulateWidened<platform::float16, platform::HalfToFloat>(data, n, acc);
+}
+
+template <>
+void Accumulate(const platform::bfloat16* data, size_t n, Accumulator* acc) {
+  AccumulateWidened<platform::bfloat16, platform::BFloat16ToFloat>(
+      data, n, acc);
+}
+
+struct AccumulateVisitor {
+  const Tensor& tensor;
+  Accumulator* acc;
+
+  template <typename T>
+  void operator()() const {
+    Accumulate(tensor.data<T>(), static_cast<size_t>(tensor.numel()), acc);
+  }
+};
+
+}  // namespace
+
+TensorStats ComputeTensorStats(const Tensor& tensor) {
+  TensorStats stats;
+  stats.numel = tensor.numel();
+  if (stats.numel == 0) return stats;
+
+  Tensor src = tensor.Contiguous();
+  if (!platform::is_cpu_place(src.place())) {
+    Tensor cpu;
+    TensorCopySync(src, platform::CPUPlace(), &cpu);
+    src = cpu;
+  }
+  Accumulator acc;
+  VisitDataType(ToDataType(src.type()), AccumulateVisitor{src, &acc});
+
+  stats.min = acc.min;
+  stats.max = acc.max;
+  stats.mean = acc.sum / stats.numel;
+  stats.l2_norm = std::sqrt(acc.sum_of_squares);
+  stats.zero_fraction = static_cast<double>(acc.zeros) / stats.numel;
+  return stats;
+}
+
+OpStatsRecorder::OpStatsRecorder(size_t capacity) : capacity_(capacity) {
+  PADDLE_ENFORCE_GT(capacity, 0UL, "The recorder must hold a record.");
+  buffer_.reserve(capacity);
+}
+
+OpStatsRecorder& OpStatsRecorder::Instance() {
+  static OpStatsRecorder recorder(
+      static_cast<size_t>(std::max(FLAGS_op_stats_buffer_size, 1)));
+  return recorder;
+}
+
+void OpStatsRecorder::Record(OpStatsRecord record) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (buffer_.size() < capacity_) {
+    buffer_.push_back(std::move(record));
+    return;
+  }
+  buffer_[next_] = std::move(record);
+  next_ = (next_ + 1) % capacity_;
+  ++dropped_;
+}
+
+std::vector<OpStatsRecord> OpStatsRecorder::Records() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<OpStatsRecord> records;
+  records.reserve(buffer_.size());
+  records.insert(records.end(), buffer_.begin() + next_, buffer_.end());
+  records.insert(records.end(), buffer_.begin(), buffer_.begin() + next_);
+  return records;
+}
+
+size_t OpStatsRecorder::Dropped() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return dropped_;
+}
+
+void OpStatsRecorder::Dump(std::ostream& os) const {
+  for (auto& record : Records()) {
+    auto& stats = record.stats;
+    os << record.step << '\t' << record.op_type << '\t' << record.var_name
+       << '\t' << stats.numel << '\t' << stats.min << '\t' << stats.max
+       << '\t' << stats.mean << '\t' << stats.l2_norm << '\t'
+       << stats.zero_fraction << '\n';
+  }
+}
+
+void OpStatsRecorder::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  buffer_.clear();
+  next_ = 0;
+  dropped_ = 0;
+}
+
+}  // namespace framework
+}  // namespace fluid
+}  // namespace paddle
@@ -0,0 +1,101 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace fluid {
+namespace framework {
+
+/*! Summary statistics of the elements of a tensor. */
+struct TensorStats {
+  int64_t numel = 0;
+  double min = 0;
+  double max = 0;
+  double mean = 0;
+  double l2_norm = 0;
+  double zero_fraction = 0;
+};
+
+/**
+ * @brief   Compute the statistics of a tensor in one pass over its elements.
+ *
+ * @note    Float tensors on the host are scanned with AVX2 when the CPU has
+ *          it, and 16-bit floats are widened block by block.  A tensor on
+ *          GPU is copied to the host first.  NaNs are skipped by min and
+ *          max but propagate to the mean and the norm.
+ */
+TensorStats ComputeTensorStats(const Tensor& tensor);
+
+/*! The statistics of an output of an operator run. */
+struct OpStatsRecord {
+  int64_t step;  // GetGlobalStep() when the operator ran
+  std::string op_type;
+  std::string var_name;
+  TensorStats stats;
+};
+
+/**
+ * @brief   OpStatsRecorder keeps the latest records in a ring buffer, so
+ *          that the drift of the values leading to a failure can be dumped.
+ *
+ * @note    OperatorWithKernel::RunImpl records the statistics of every
+ *          output when FLAGS_record_op_stats is set.  The capacity of the
+ *          global recorder is FLAGS_op_stats_buffer_size.
+ */
+class OpStatsRecorder {
+ public:
+  explicit OpStatsRecorder(size_t capacity);
+
+  static OpStatsRecorder& Instance();
+
+  void Record(OpStatsRecord record);
+
+  /*! The records in the buffer, the oldest first. */
+  std::vector<OpStatsRecord> Records() const;
+
+  /*! The number of records overwritten since the last Clear. */
+  size_t Dropped() const;
+
+  /**
+   * @brief   Write the records, the oldest first, one per line as
+   *          step, op_type, var_name, numel, min, max, mean, l2_norm and
+   *          zero_fraction separated by tabs.
+   */
+  void Dump(std::ostream& os) const;
+
+  void Clear();
+
+ private:
+  mutable std::mutex mutex_;
+  std::vector<OpStatsRecord> buffer_;
+  size_t capacity_;
+  size_t next_ = 0;  // where the next record goes once the buffer is full
+  size_t dropped_ = 0;
+
+  DISABLE_COPY_AND_ASSIGN(OpStatsRecorder);
+};
+
+}  // namespace framework
+}  // namespace fluid
+}  // namespace paddle
@@ -0,0 +1,111 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/tensor_stats.h"
+
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/float16.h"
+
+namespace framework = paddle::fluid::framework;
+namespace platform = paddle::fluid::platform;
+
+TEST(TensorStats, Float) {
+  framework::Tensor t;
+  // Longer than a vector kernel step, with a tail.
+  const int n = 103;
+  float* data =
+      t.mutable_data<float>(framework::make_ddim({n}), platform::CPUPlace());
+  double sum = 0, sum_of_squares = 0;
+  for (int i = 0; i < n; ++i) {
+    data[i] = i % 4 == 0 ? 0.f : (i - 50) * 0.25f;
+    sum += data[i];
+    sum_of_squares += data[i] * data[i];
+  }
+  data[90] = std::numeric_limits<float>::quiet_NaN();
+
+  auto stats = framework::ComputeTensorStats(t.Slice(0, 90));
+  EXPECT_EQ(stats.numel, 90);
+  EXPECT_EQ(stats.min, -49 * 0.25);
+  EXPECT_EQ(stats.max, 39 * 0.25);
+  EXPECT_EQ(stats.zero_fraction, 24. / 90);
+
+  stats = framework::ComputeTensorStats(t);
+  EXPECT_EQ(stats.max, 52 * 0.25);
+  EXPECT_TRUE(std::isnan(stats.mean));
+
+  data[90] = (90 - 50) * 0.25f;
+  stats = framework::ComputeTensorStats(t);
+  EXPECT_EQ(stats.min, -49 * 0.25);
+  EXPECT_EQ(stats.max, 52 * 0.25);
+  EXPECT_DOUBLE_EQ(stats.mean, sum / n);
+  EXPECT_DOUBLE_EQ(stats.l2_norm, std::sqrt(sum_of_squares));
+  EXPECT_EQ(stats.zero_fraction, 27. / n);
+}
+
+TEST(TensorStats, OtherTypes) {
+  framework::Tensor half;
+  const int n = 1500;  // more than a block widened at a time
+  auto* half_data = half.mutable_data<platform::float16>(
+      framework::make_ddim({n}), platform::CPUPlace());
+  for (int i = 0; i < n; ++i) half_data[i] = platform::float16(i % 3);
+  auto stats = framework::ComputeTensorStats(half);
+  EXPECT_EQ(stats.min, 0);
+  EXPECT_EQ(stats.max, 2);
+  EXPECT_DOUBLE_EQ(stats.mean, 1);
+  EXPECT_DOUBLE_EQ(stats.zero_fraction, 1. / 3);
+
+  framework::Tensor ints;
+  auto* int_data = ints.mutable_data<int64_t>(framework::make_ddim({2, 2}),
+                                              platform::CPUPlace());
+  int_data[0] = -3;
+  int_data[1] = 4;
+  int_data[2] = 0;
+  int_data[3] = 0;
+  stats = framework::ComputeTensorStats(ints);
+  EXPECT_EQ(stats.min, -3);
+  EXPECT_EQ(stats.max, 4);
+  EXPECT_DOUBLE_EQ(stats.mean, 0.25);
+  EXPECT_DOUBLE_EQ(stats.l2_norm, 5);
+  EXPECT_DOUBLE_EQ(stats.zero_fraction, 0.5);
+}
+
+TEST(OpStatsRecorder, Ring) {
+  framework::OpStatsRecorder recorder(3);
+  for (int i = 0; i < 5; ++i) {
+    framework::OpStatsRecord record;
+    record.step = i;
+    record.op_type = "relu";
+    record.var_name = "out";
+    record.stats.numel = 10 * i;
+    recorder.Record(record);
+  }
+  auto records = recorder.Records();
+  ASSERT_EQ(records.size(), 3UL);
+  EXPECT_EQ(records[0].step, 2);
+  EXPECT_EQ(records[2].step, 4);
+  EXPECT_EQ(recorder.Dropped(), 2UL);
+
+  std::ostringstream os;
+  recorder.Dump(os);
+  EXPECT_EQ(os.str().substr(0, os.str().find('\n')),
+            "2\trelu\tout\t20\t0\t0\t0\t0\t0");
+
+  recorder.Clear();
+  EXPECT_TRUE(recorder.Records().empty());
+  EXPECT_EQ(recorder.Dropped(), 0UL);
+}
@@ -104,6 +104,26 @@ TEST(Tensor, MutableData) {
 #endif
 }
 
+TEST(Tensor, InlineScalar) {
+  platform::CPUPlace cpu;
+  size_t used = paddle::fluid::memory::Used(cpu);
+  framework::Tensor scalar;
+  float* p1 = scalar.mutable_data<float>(framework::make_ddim({1}), cpu);
+  *p1 = 0.5f;
+  EXPECT_EQ(paddle::fluid::memory::Used(cpu), used);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(p1) % 32, 0UL);
+
+  framework::Tensor alias;
+  alias.ShareDataWith(scalar);
+  EXPECT_EQ(alias.data<float>(), p1);
+  EXPECT_EQ(scalar.memory_size(), sizeof(float));
+
+  // Larger tensors still come from the allocator.
+  scalar.mutable_data<float>(framework::make_ddim({1024}), cpu);
+  EXPECT_GT(paddle::fluid::memory::Used(cpu), used);
+  EXPECT_EQ(*alias.data<float>(), 0.5f);
+}
+
 TEST(Tensor, ShareDataWith) {
   {
     framework::Tensor src_tensor;
@@ -196,6 +216,134 @@ TEST(Tensor, Slice) {
 #endif
 }
 
+TEST(Tensor, ShareExternalData) {
+  std::vector<float> buffer(6, 1.0f);
+  int num_deleted = 0;
+  {
+    framework::Tensor tensor;
+    tensor.Resize(framework::make_ddim({2, 3}));
+    tensor.ShareExternalData(buffer.data(),
+                             buffer.size() * sizeof(float),
+                             platform::CPUPlace(),
+                             typeid(float),
+                             [&](void* ptr) {
+                               EXPECT_EQ(ptr, buffer.data());
+                               ++num_deleted;
+                             });
+    EXPECT_EQ(tensor.data<float>(), buffer.data());
+    EXPECT_EQ(tensor.mutable_data<float>(platform::CPUPlace()), buffer.data());
+
+    framework::Tensor alias;
+    alias.ShareDataWith(tensor);
+    tensor = framework::Tensor();
+    EXPECT_EQ(num_deleted, 0);
+    EXPECT_EQ(alias.data<float>()[5], 1.0f);
+  }
+  EXPECT_EQ(num_deleted, 1);
+}
+
+TEST(Tensor, CopyOnWrite) {
+  framework::Tensor src;
+  int* src_ptr =
+      src.mutable_data<int>(framework::make_ddim({2, 3}), platform::CPUPlace());
+  for (int i = 0; i < 6; ++i) src_ptr[i] = i;
+  auto stats = framework::GetCopyOnWriteStats();
+
+  // Reading the copy does not copy.
+  framework::Tensor dst;
+  dst.CopyOnWriteFrom(src);
+  const framework::Tensor& const_dst = dst;
+  EXPECT_EQ(const_dst.data<int>(), src_ptr);
+  EXPECT_EQ(framework::GetCopyOnWriteStats().shared_bytes,
+            stats.shared_bytes + 6 * sizeof(int));
+  EXPECT_EQ(framework::GetCopyOnWriteStats().copied_bytes, stats.copied_bytes);
+
+  // Writing the copy copies, and tensors sharing it see the write.
+  framework::Tensor alias;
+  alias.ShareDataWith(dst);
+  int* dst_ptr = dst.mutable_data<int>(platform::CPUPlace());
+  EXPECT_NE(dst_ptr, src_ptr);
+  dst_ptr[0] = 100;
+  EXPECT_EQ(alias.data<int>()[0], 100);
+  EXPECT_EQ(src.data<int>()[0], 0);
+  EXPECT_EQ(framework::GetCopyOnWriteStats().copied_bytes,
+            stats.copied_bytes + 6 * sizeof(int));
+
+  // Writing the source copies the data to its lazy copies first.
+  framework::Tensor copy;
+  copy.CopyOnWriteFrom(src.Slice(1, 2));
+  const framework::Tensor& const_src = src;
+  EXPECT_EQ(const_src.data<int>(), src_ptr);
+  // The non-const data<T>() is a write, as kernels update through it.
+  src.data<int>()[3] = 300;
+  const framework::Tensor& const_copy = copy;
+  EXPECT_NE(const_copy.data<int>(), src_ptr + 3);
+  EXPECT_EQ(const_copy.data<int>()[0], 3);
+  EXPECT_EQ(const_src.data<int>()[3], 300);
+}
+
+TEST(Tensor, StridedViews) {
+  framework::Tensor src;
+  int* src_ptr =
+      src.mutable_data<int>(framework::make_ddim({2, 3}), platform::CPUPlace());
+  for (int i = 0; i < 6; ++i) src_ptr[i] = i;
+  ASSERT_TRUE(src.IsContiguous());
+  ASSERT_EQ(src.strides(), framework::make_ddim({3, 1}));
+
+  // A column slice reads the same memory block.
+  framework::Tensor column = src.Slice(1, 2, 1);
+  ASSERT_FALSE(column.IsContiguous());
+  ASSERT_EQ(column.dims(), framework::make_ddim({2, 1}));
+  ASSERT_EQ(column.strides(), framework::make_ddim({3, 1}));
+  EXPECT_EQ(column.data<int>(), src_ptr + 1);
+  framework::Tensor dense_column = column.Contiguous();
+  ASSERT_TRUE(dense_column.IsContiguous());
+  EXPECT_EQ(dense_column.data<int>()[0], 1);
+  EXPECT_EQ(dense_column.data<int>()[1], 4);
+
+  framework::Tensor transposed = src.Transpose({1, 0});
+  ASSERT_FALSE(transposed.IsContiguous());
+  ASSERT_EQ(transposed.dims(), framework::make_ddim({3, 2}));
+  EXPECT_EQ(transposed.data<int>(), src_ptr);
+  framework::Tensor dense = transposed.Contiguous();
+  const int expected[] = {0, 3, 1, 4, 2, 5};
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(dense.data<int>()[i], expected[i]);
+  }
+  // Transposing back gives a contiguous view again.
+  EXPECT_TRUE(transposed.Transpose({1, 0}).IsContiguous());
+
+  framework::Tensor row = src.Slice(1, 2);
+  framework::Tensor broadcast = row.Broadcast(framework::make_ddim({4, 1, 3}));
+  ASSERT_EQ(broadcast.strides(), framework::make_ddim({0, 0, 1}));
+  EXPECT_EQ(broadcast.data<int>(), src_ptr + 3);
+  framework::Tensor dense_broadcast = broadcast.Contiguous();
+  for (int i = 0; i < 12; ++i) {
+    EXPECT_EQ(dense_broadcast.data<int>()[i], 3 + i % 3);
+  }
+
+  // A scalar has no strides, and broadcasts to any dims.
+  framework::Tensor scalar;
+  scalar.mutable_data<int>(framework::make_ddim(std::vector<int64_t>()),
+                           platform::CPUPlace())[0] = 7;
+  EXPECT_EQ(scalar.strides().size(), 0);
+  EXPECT_TRUE(scalar.Transpose({}).IsContiguous());
+  framework::Tensor filled = scalar.Broadcast(framework::make_ddim({2, 2}));
+  ASSERT_EQ(filled.strides(), framework::make_ddim({0, 0}));
+  framework::Tensor dense_filled = filled.Contiguous();
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(dense_filled.data<int>()[i], 7);
+  }
+
+  bool caught = false;
+  try {
+    transposed.Resize(framework::make_ddim({6}));
+  } catch (const paddle::fluid::platform::EnforceNotMet& err) {
+    caught = true;
+  }
+  EXPECT_TRUE(caught);
+}
+
 TEST(Tensor, ReshapeToMatrix) {
   framework::Tensor src;
   int* src_ptr = src.mutable_data<int>({2, 3, 4, 9}, platform::CPUPlace());
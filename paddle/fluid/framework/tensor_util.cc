@@ -16,6 +16,9 @@
 #include <limits>
 #include <vector>
 
+#include "paddle/fluid/framework/quantization.h"
+#include "paddle/fluid/platform/nan_inf.h"
+
 namespace paddle {
 namespace fluid {
 namespace framework {
@@ -26,10 +29,15 @@ void TensorCopy(const Tensor& src,
                 Tensor* dst) {
   VLOG(3) << "TensorCopy " << src.dims() << " from " << src.place() << " to "
           << dst_place;
+  if (!src.IsContiguous()) {
+    TensorCopy(src.Contiguous(), dst_place, ctx, dst);
+    return;
+  }
   src.check_memory_size();
 
   dst->Resize(src.dims());
   dst->set_layout(src.layout());
+  dst->set_quantization(src.quantization());
   auto src_place = src.place();
   auto src_ptr = src.data<void>();
 
@@ -98,9 +106,14 @@ void TensorCopySync(const Tensor& src,
                     Tensor* dst) {
   VLOG(3) << "TensorCopySync " << src.dims() << " from " << src.place()
           << " to " << dst_place;
+  if (!src.IsContiguous()) {
+    TensorCopySync(src.Contiguous(), dst_place, dst);
+    return;
+  }
   src.check_memory_size();
   dst->Resize(src.dims());
   dst->set_layout(src.layout());
+  dst->set_quantization(src.quantization());
   auto src_place = src.place();
   auto src_ptr = src.data<void>();
   auto dst_ptr = dst->mutable_data(dst_place, src.type());
@@ -241,9 +254,77 @@ bool TensorContainsInf(const framework::Tensor& tensor) {
   return Any(tensor, predicate);
 }
 
+struct ContainsNANOrInfPredicate {
+  template <typename T>
+  auto operator()(const T& eigen_vec) const
+      -> decltype(std::declval<T>().isnan() || std::declval<T>().isinf()) {
+    return eigen_vec.isnan() || eigen_vec.isinf();
+  }
+};
+
+bool TensorContainsNANOrInf(const framework::Tensor& tensor) {
+  // Other types, e.g., integers or size_t, which VisitDataType does not
+  // support, hold neither.
+  auto type = tensor.type();
+  if (type != typeid(float) && type != typeid(double) &&
+      type != typeid(platform::float16) && type != typeid(platform::bfloat16)) {
+    return false;
+  }
+
+  // Read through a const tensor, so a lazy copy is not copied.
+  const Tensor dense = tensor.Contiguous();
+  if (platform::is_gpu_place(dense.place())) {
+    ContainsNANOrInfPredicate predicate;
+    return Any(dense, predicate);
+  }
+
+  size_t numel = static_cast<size_t>(dense.numel());
+  if (type == typeid(float)) {
+    return platform::ContainsNanOrInf(dense.data<float>(), numel);
+  } else if (type == typeid(double)) {
+    return platform::ContainsNanOrInf(dense.data<double>(), numel);
+  } else if (type == typeid(platform::float16)) {
+    return platform::ContainsNanOrInf(dense.data<platform::float16>(), numel);
+  }
+  return platform::ContainsNanOrInf(dense.data<platform::bfloat16>(), numel);
+}
+
+void QuantizationToDesc(const Tensor& tensor,
+                        proto::VarType::TensorDesc* desc) {
+  auto& params = tensor.quantization();
+  if (params == nullptr) return;
+  desc->set_quantization_axis(params->axis);
+  for (float scale : params->scales) desc->add_quantization_scales(scale);
+  for (int32_t zero_point : params->zero_points) {
+    desc->add_quantization_zero_points(zero_point);
+  }
+}
+
+void QuantizationFromDesc(const proto::VarType::TensorDesc& desc,
+                          Tensor* tensor) {
+  if (desc.quantization_scales_size() == 0) {
+    tensor->set_quantization(nullptr);
+    return;
+  }
+  PADDLE_ENFORCE_EQ(desc.quantization_scales_size(),
+                    desc.quantization_zero_points_size(),
+                    "There must be a zero point for each scale.");
+  auto params = std::make_shared<QuantizationParams>();
+  params->axis = desc.quantization_axis();
+  params->scales.assign(desc.quantization_scales().begin(),
+                        desc.quantization_scales().end());
+  params->zero_points.assign(desc.quantization_zero_points().begin(),
+                             desc.quantization_zero_points().end());
+  tensor->set_quantization(params);
+}
+
 void TensorToStream(std::ostream& os,
                     const Tensor& tensor,
                     const platform::DeviceContext& dev_ctx) {
+  if (!tensor.IsContiguous()) {
+    TensorToStream(os, tensor.Contiguous(), dev_ctx);
+    return;
+  }
   {  // the 1st field, uint32_t version
     constexpr uint32_t version = 0;
     os.write(reinterpret_cast<const char*>(&version), sizeof(version));
@@ -257,6 +338,7 @@ void TensorToStream(std::ostream& os,
     auto* pb_dims = desc.mutable_dims();
     pb_dims->Resize(static_cast<int>(dims.size()), 0);
     std::copy(dims.begin(), dims.end(), pb_dims->begin());
+    QuantizationToDesc(tensor, &desc);
     int32_t size = desc.ByteSize();
     os.write(reinterpret_cast<const char*>(&size), sizeof(size));
     auto out = desc.SerializeAsString();
@@ -345,6 +427,7 @@ void TensorFromStream(std::istream& is,
           desc.data_type(),
           DeserializedDataFunctor(&buf, &cpu_tensor, ctx.GetPlace()));
       is.read(static_cast<char*>(buf), cpu_tensor.memory_size());
+      QuantizationFromDesc(desc, &cpu_tensor);
       auto dst_place = dev_ctx.GetPlace();
       framework::TensorCopy(cpu_tensor, dst_place, dev_ctx, tensor);
 #else
@@ -355,6 +438,7 @@ void TensorFromStream(std::istream& is,
           desc.data_type(),
           DeserializedDataFunctor(&buf, tensor, ctx.GetPlace()));
       is.read(static_cast<char*>(buf), tensor->memory_size());
+      QuantizationFromDesc(desc, tensor);
     }
   }
 }
@@ -52,6 +52,22 @@ void TesnorToVector(const Tensor& src, std::vector<T>* dst);
 bool TensorContainsNAN(const framework::Tensor& tensor);
 bool TensorContainsInf(const framework::Tensor& tensor);
 
+/**
+ * @brief   Whether a tensor contains NaN or Inf, checked in one pass.
+ *
+ * @note    Floating point tensors on the host are scanned by SIMD kernels,
+ *          in parallel when they are large, which stop at the first hit.
+ */
+bool TensorContainsNANOrInf(const framework::Tensor& tensor);
+
+/*! Record the quantization params of a tensor, if any, in its desc. */
+void QuantizationToDesc(const Tensor& tensor,
+                        proto::VarType::TensorDesc* desc);
+
+/*! Set the quantization params of a tensor from its desc. */
+void QuantizationFromDesc(const proto::VarType::TensorDesc& desc,
+                          Tensor* tensor);
+
 void TensorToStream(std::ostream& os,
                     const Tensor& tensor,
                     const platform::DeviceContext& dev_ctx);
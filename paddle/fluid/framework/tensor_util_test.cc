@@ -265,6 +265,30 @@ TEST(TensorContainsInf, CPU) {
   }
 }
 
+TEST(TensorContainsNANOrInf, CPU) {
+  paddle::fluid::framework::Tensor src;
+  float* buf =
+      src.mutable_data<float>({2, 3}, paddle::fluid::platform::CPUPlace());
+  for (int i = 0; i < 6; ++i) buf[i] = i;
+  ASSERT_FALSE(paddle::fluid::framework::TensorContainsNANOrInf(src));
+  buf[4] = NAN;
+  ASSERT_TRUE(paddle::fluid::framework::TensorContainsNANOrInf(src));
+  buf[4] = -INFINITY;
+  ASSERT_TRUE(paddle::fluid::framework::TensorContainsNANOrInf(src));
+  // Only the elements of a view are checked.
+  ASSERT_FALSE(paddle::fluid::framework::TensorContainsNANOrInf(
+      src.Slice(0, 1, 1).Transpose({1, 0})));
+
+  paddle::fluid::framework::Tensor ints;
+  ints.mutable_data<int>({3}, paddle::fluid::platform::CPUPlace());
+  ASSERT_FALSE(paddle::fluid::framework::TensorContainsNANOrInf(ints));
+  // Types which VisitDataType does not support are skipped too.
+  paddle::fluid::framework::Tensor sizes;
+  sizes.mutable_data<size_t>({2, 3}, paddle::fluid::platform::CPUPlace());
+  ASSERT_FALSE(paddle::fluid::framework::TensorContainsNANOrInf(
+      sizes.Transpose({1, 0})));
+}
+
 TEST(Tensor, FromAndToStream) {
   framework::Tensor src_tensor;
   int array[6] = {1, 2, 3, 4, 5, 6};
@@ -0,0 +1,107 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <type_traits>
+
+#include "paddle/fluid/framework/ddim.h"
+#include "paddle/fluid/framework/dim.h"
+#include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/hostdevice.h"
+
+namespace paddle {
+namespace fluid {
+namespace framework {
+
+/**
+ * @brief   TensorView is a typed accessor of a tensor of a known rank.
+ *
+ * @note    The type, the rank and the memory size are checked once when
+ *          the view is created, so element accesses are plain pointer
+ *          arithmetic on Dim<Rank>, which compilers unroll and vectorize.
+ *          T is const for read-only views.  Strided views of the tensor
+ *          are honoured.  A TensorView is invalidated, like a pointer
+ *          returned by data<T>(), when the tensor is reallocated.
+ */
+template <typename T, int Rank>
+class TensorView {
+ public:
+  using ElementType = typename std::remove_const<T>::type;
+
+  /*! A read-only view. */
+  explicit TensorView(const Tensor& tensor)
+      : TensorView(tensor, tensor.data<ElementType>()) {
+    static_assert(std::is_const<T>::value,
+                  "A view of a const tensor must have a const T.");
+  }
+
+  /*! A writable view, which copies a shared block as mutable_data does. */
+  explicit TensorView(Tensor* tensor)
+      : TensorView(*tensor, tensor->data<ElementType>()) {}
+
+  HOSTDEVICE T* data() const { return data_; }
+
+  HOSTDEVICE const Dim<Rank>& dims() const { return dims_; }
+
+  HOSTDEVICE const Dim<Rank>& strides() const { return strides_; }
+
+  /*! The I-th dimension, resolved at compile time. */
+  template <int I>
+  HOSTDEVICE int64_t dim() const {
+    static_assert(I >= 0 && I < Rank, "The dimension is out of range.");
+    return get<I>(dims_);
+  }
+
+  HOSTDEVICE int64_t numel() const { return product(dims_); }
+
+  /*! Whether operator[] may be used. */
+  HOSTDEVICE bool IsContiguous() const { return contiguous_; }
+
+  /*! The element at the given indices; no bound checks. */
+  template <typename... Indices>
+  HOSTDEVICE T& operator()(Indices... indices) const {
+    static_assert(sizeof...(Indices) == Rank,
+                  "The number of indices must equal the rank.");
+    return data_[linearize(Dim<Rank>(indices...), strides_)];
+  }
+
+  /*! The i-th element in row-major order of a contiguous view. */
+  HOSTDEVICE T& operator[](int64_t i) const { return data_[i]; }
+
+  /*! The first element of the i-th slice along the first dimension. */
+  HOSTDEVICE T* row(int64_t i) const { return data_ + i * get<0>(strides_); }
+
+ private:
+  TensorView(const Tensor& tensor, const ElementType* data)
+      : data_(const_cast<T*>(data)),
+        contiguous_(tensor.IsContiguous()) {
+    static_assert(Rank > 0, "The rank of a TensorView must be positive.");
+    PADDLE_ENFORCE_EQ(arity(tensor.dims()),
+                      Rank,
+                      "The rank of the tensor does not match the view.");
+    dims_ = boost::get<Dim<Rank>>(tensor.dims());
+    strides_ = boost::get<Dim<Rank>>(tensor.strides());
+  }
+
+  T* data_;
+  Dim<Rank> dims_;
+  Dim<Rank> strides_;
+  bool contiguous_;
+};
+
+}  // namespace framework
+}  // namespace fluid
+}  // namespace paddle
@@ -0,0 +1,68 @@
+//  Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/tensor_view.h"
+#include <gtest/gtest.h>
+
+namespace paddle {
+namespace fluid {
+namespace framework {
+
+TEST(TensorView, Access) {
+  Tensor t;
+  float* p = t.mutable_data<float>(make_ddim({2, 3}), platform::CPUPlace());
+  for (int i = 0; i < 6; ++i) p[i] = static_cast<float>(i);
+
+  TensorView<float, 2> view(&t);
+  ASSERT_EQ(view.data(), p);
+  ASSERT_EQ(view.dim<0>(), 2);
+  ASSERT_EQ(view.dim<1>(), 3);
+  ASSERT_EQ(view.numel(), 6);
+  ASSERT_TRUE(view.IsContiguous());
+  EXPECT_EQ(view(1, 2), 5.0f);
+  EXPECT_EQ(view.row(1)[0], 3.0f);
+  view(0, 1) = 10.0f;
+  EXPECT_EQ(p[1], 10.0f);
+
+  const Tensor& const_t = t;
+  TensorView<const float, 2> const_view(const_t);
+  EXPECT_EQ(const_view[1], 10.0f);
+}
+
+TEST(TensorView, Strided) {
+  Tensor t;
+  int* p = t.mutable_data<int>(make_ddim({2, 3}), platform::CPUPlace());
+  for (int i = 0; i < 6; ++i) p[i] = i;
+
+  Tensor transposed = t.Transpose({1, 0});
+  TensorView<const int, 2> view(transposed);
+  ASSERT_FALSE(view.IsContiguous());
+  ASSERT_EQ(view.dim<0>(), 3);
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 2; ++j) {
+      EXPECT_EQ(view(i, j), j * 3 + i);
+    }
+  }
+}
+
+TEST(TensorView, Checks) {
+  Tensor t;
+  t.mutable_data<float>(make_ddim({2, 3}), platform::CPUPlace());
+  EXPECT_THROW((TensorView<float, 3>(&t)), platform::EnforceNotMet);
+  EXPECT_THROW((TensorView<int, 2>(&t)), platform::EnforceNotMet);
+}
+
+}  // namespace framework
+}  // namespace fluid
+}  // namespace paddle
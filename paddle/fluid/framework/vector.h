@@ -71,10 +71,13 @@ class Vector {
   // Copy ctor
   Vector(const Vector<T>& other) { this->operator=(other); }
 
-  // Copy operator
+  // Copy operator. The CPU data is copied lazily, on the first write.
   Vector<T>& operator=(const Vector<T>& other) {
     if (other.size() != 0) {
-      this->InitByIter(other.size(), other.begin(), other.end());
+      other.ImmutableCPU();
+      this->cpu_vec_.CopyOnWriteFrom(other.cpu_vec_);
+      flag_ = kDataInCPU | kDirty;
+      size_ = other.size();
     } else {
       InitEmpty();
     }
@@ -102,7 +105,7 @@ class Vector {
   // CPU data access method. Immutable.
   const T& operator[](size_t i) const {
     ImmutableCPU();
-    return cpu_vec_.data<T>()[i];
+    return CPUVec().template data<T>()[i];
   }
 
   // std::vector iterator methods. Based on CPU data access method
@@ -187,7 +190,7 @@ class Vector {
       T* ptr = cpu_tensor.mutable_data<T>(
           framework::make_ddim({static_cast<int64_t>(size)}), cpu);
       const T* old_ptr =
-          cpu_vec_.memory_size() == 0 ? nullptr : cpu_vec_.data<T>();
+          cpu_vec_.memory_size() == 0 ? nullptr : CPUVec().template data<T>();
       if (old_ptr != nullptr) {
         std::copy(old_ptr, old_ptr + size_, ptr);
       }
@@ -267,6 +270,10 @@ class Vector {
   }
 
  private:
+  // Reading cpu_vec_ through a const reference does not copy it if it
+  // is shared by a lazy copy.
+  const Tensor& CPUVec() const { return cpu_vec_; }
+
   void InitEmpty() {
     size_ = 0;
     flag_ = kDataInCPU;
@@ -302,6 +309,10 @@ class Vector {
       CopyToCPU();
     }
     flag_ = kDirty | kDataInCPU;
+    // Copies a block still shared by a lazy copy before it is written.
+    if (cpu_vec_.IsCopyOnWrite()) {
+      cpu_vec_.mutable_data<T>(platform::CPUPlace());
+    }
   }
 
   void ImmutableCUDA(platform::Place place) const {
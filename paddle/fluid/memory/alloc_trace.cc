@@ -0,0 +1,202 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/memory/alloc_trace.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+
+namespace {
+
+// The file starts with a header, followed by the events.
+struct AllocTraceHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t event_size;
+};
+
+constexpr char kAllocTraceMagic[8] = {'P', 'D', 'A', 'L', 'L', 'O', 'C', 'T'};
+constexpr uint32_t kAllocTraceVersion = 1;
+
+uint32_t CurrentThreadId() {
+  static std::atomic<uint32_t> next_id(0);
+  static thread_local uint32_t id = next_id++;
+  return id;
+}
+
+bool IsPlaceOf(const AllocTraceEvent& event, const platform::Place& place) {
+  if (platform::is_gpu_place(place)) {
+    return event.place_type == AllocTraceEvent::kCUDA &&
+           event.device == boost::get<platform::CUDAPlace>(place).device;
+  }
+  if (platform::is_cuda_pinned_place(place)) {
+    return event.place_type == AllocTraceEvent::kCUDAPinned;
+  }
+  return event.place_type == AllocTraceEvent::kCPU;
+}
+
+}  // namespace
+
+constexpr size_t AllocTraceWriter::kBufferedEvents;
+
+AllocTraceWriter::AllocTraceWriter(const std::string& path)
+    : file_(path, std::ios::binary | std::ios::trunc),
+      start_(std::chrono::steady_clock::now()) {
+  PADDLE_ENFORCE(file_.is_open(), "Cannot open allocation trace %s", path);
+  AllocTraceHeader header;
+  memcpy(header.magic, kAllocTraceMagic, sizeof(header.magic));
+  header.version = kAllocTraceVersion;
+  header.event_size = sizeof(AllocTraceEvent);
+  file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  buffer_.reserve(kBufferedEvents);
+}
+
+AllocTraceWriter::~AllocTraceWriter() { Flush(); }
+
+void AllocTraceWriter::RecordAlloc(const platform::Place& place,
+                                   size_t size,
+                                   void* p) {
+  Record(AllocTraceEvent::kAlloc, place, size, p);
+}
+
+void AllocTraceWriter::RecordFree(const platform::Place& place, void* p) {
+  Record(AllocTraceEvent::kFree, place, 0, p);
+}
+
+void AllocTraceWriter::Record(AllocTraceEvent::Type type,
+                              const platform::Place& place,
+                              size_t size,
+                              void* p) {
+  AllocTraceEvent event;
+  event.address = reinterpret_cast<uint64_t>(p);
+  event.size = size;
+  event.thread = CurrentThreadId();
+  event.type = type;
+  event.device = 0;
+  if (platform::is_gpu_place(place)) {
+    event.place_type = AllocTraceEvent::kCUDA;
+    event.device = boost::get<platform::CUDAPlace>(place).device;
+  } else if (platform::is_cuda_pinned_place(place)) {
+    event.place_type = AllocTraceEvent::kCUDAPinned;
+  } else {
+    event.place_type = AllocTraceEvent::kCPU;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Take the time under the lock, so that timestamps follow file order.
+  event.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start_)
+                           .count();
+  buffer_.push_back(event);
+  if (buffer_.size() == kBufferedEvents) FlushLocked();
+}
+
+void AllocTraceWriter::Flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  FlushLocked();
+}
+
+void AllocTraceWriter::FlushLocked() {
+  file_.write(reinterpret_cast<const char*>(buffer_.data()),
+              buffer_.size() * sizeof(AllocTraceEvent));
+  file_.flush();
+  buffer_.clear();
+}
+
+std::vector<AllocTraceEvent> ReadAllocTrace(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  PADDLE_ENFORCE(file.is_open(), "Cannot open allocation trace %s", path);
+
+  AllocTraceHeader header;
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  PADDLE_ENFORCE(file.good() && memcmp(header.magic,
+                                       kAllocTraceMagic,
+                                       sizeof(header.magic)) == 0,
+                 "%s is not an allocation trace",
+                 path);
+  PADDLE_ENFORCE_EQ(header.version, kAllocTraceVersion);
+  PADDLE_ENFORCE_EQ(header.event_size, sizeof(AllocTraceEvent));
+
+  std::vector<AllocTraceEvent> events;
+  AllocTraceEvent event;
+  while (file.read(reinterpret_cast<char*>(&event), sizeof(event))) {
+    events.push_back(event);
+  }
+  return events;
+}
+
+AllocTraceReplayResult ReplayAllocTrace(
+    const std::vector<AllocTraceEvent>& events,
+    const platform::Place& place,
+    const std::function<void*(size_t)>& alloc,
+    const std::function<void(void*)>& free,
+    const std::function<void()>& sample,
+    size_t sample_interval) {
+  AllocTraceReplayResult result;
+  // Recorded address -> (replayed pointer, requested size)
+  std::unordered_map<uint64_t, std::pair<void*, size_t>> live;
+  size_t requested = 0;
+  size_t replayed = 0;
+  std::chrono::duration<double> elapsed(0);
+
+  for (auto& event : events) {
+    if (!IsPlaceOf(event, place)) continue;
+
+    if (event.type == AllocTraceEvent::kAlloc) {
+      if (event.address == 0) continue;  // failed when recorded
+      auto start = std::chrono::steady_clock::now();
+      void* p = alloc(event.size);
+      elapsed += std::chrono::steady_clock::now() - start;
+      ++result.num_allocs;
+      if (p == nullptr) {
+        ++result.num_failed_allocs;
+        continue;
+      }
+      live[event.address] = std::make_pair(p, event.size);
+      requested += event.size;
+      result.peak_requested = std::max(result.peak_requested, requested);
+    } else {
+      auto it = live.find(event.address);
+      if (it == live.end()) {
+        ++result.num_unmatched_frees;
+        continue;
+      }
+      auto start = std::chrono::steady_clock::now();
+      free(it->second.first);
+      elapsed += std::chrono::steady_clock::now() - start;
+      ++result.num_frees;
+      requested -= it->second.second;
+      live.erase(it);
+    }
+
+    if (sample && ++replayed % sample_interval == 0) sample();
+  }
+
+  for (auto& block : live) free(block.second.first);
+  result.seconds = elapsed.count();
+  return result;
+}
+
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
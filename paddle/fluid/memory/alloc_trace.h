@@ -0,0 +1,126 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint64_t
+
+#include <chrono>  // NOLINT
+#include <fstream>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+
+/**
+ * \brief   One Alloc or Free call in an allocation trace.
+ *
+ * \note    The layout is the on-disk format, in the host byte order.
+ *          Size is 0 for Free events, and address is the pointer
+ *          returned by Alloc, or nullptr if Alloc failed.
+ */
+struct AllocTraceEvent {
+  enum Type : uint8_t { kAlloc = 0, kFree = 1 };
+  enum PlaceType : uint8_t { kCPU = 0, kCUDA = 1, kCUDAPinned = 2 };
+
+  uint64_t timestamp_ns;  // since the trace was opened
+  uint64_t address;
+  uint64_t size;
+  uint32_t thread;  // sequential id of the calling thread
+  uint8_t type;
+  uint8_t place_type;
+  uint16_t device;
+};
+
+static_assert(sizeof(AllocTraceEvent) == 32,
+              "AllocTraceEvent is part of the trace file format");
+
+/**
+ * \brief   AllocTraceWriter appends Alloc/Free events to a trace file.
+ *
+ * \note    Events are buffered and written in batches under a lock, so
+ *          the recording slows down the allocator noticeably.  It is
+ *          meant for collecting traces, not for production runs.
+ */
+class AllocTraceWriter {
+ public:
+  explicit AllocTraceWriter(const std::string& path);
+  ~AllocTraceWriter();
+
+  void RecordAlloc(const platform::Place& place, size_t size, void* p);
+  void RecordFree(const platform::Place& place, void* p);
+
+  /*! \brief Write the buffered events to the file */
+  void Flush();
+
+ private:
+  void Record(AllocTraceEvent::Type type,
+              const platform::Place& place,
+              size_t size,
+              void* p);
+  void FlushLocked();
+
+  static constexpr size_t kBufferedEvents = 4096;
+
+  std::mutex mutex_;
+  std::ofstream file_;
+  std::chrono::steady_clock::time_point start_;
+  std::vector<AllocTraceEvent> buffer_;
+};
+
+/*! \brief Read all events of a trace file, in the recorded order */
+std::vector<AllocTraceEvent> ReadAllocTrace(const std::string& path);
+
+/*! \brief The result of replaying a trace against an allocator */
+struct AllocTraceReplayResult {
+  size_t num_allocs = 0;
+  size_t num_frees = 0;
+  size_t num_failed_allocs = 0;
+  size_t num_unmatched_frees = 0;  // frees of blocks not allocated in trace
+  size_t peak_requested = 0;       // peak of the requested live bytes
+  double seconds = 0;              // time spent in alloc and free
+};
+
+/**
+ * \brief   Replay the events of a trace on one place against an allocator.
+ *
+ * \param[in]  events  The trace, e.g., from ReadAllocTrace.
+ * \param[in]  place   Only events on this place are replayed.
+ * \param[in]  alloc   Allocates size bytes, or returns nullptr.
+ * \param[in]  free    Frees a pointer returned by alloc.
+ * \param[in]  sample  If not empty, called after every sample_interval
+ *                     events, e.g., to record the allocator's stats.
+ *
+ * \note    Events of all threads are replayed in one thread, in the
+ *          recorded order.  Blocks still live at the end of the trace
+ *          are freed and not counted.
+ */
+AllocTraceReplayResult ReplayAllocTrace(
+    const std::vector<AllocTraceEvent>& events,
+    const platform::Place& place,
+    const std::function<void*(size_t)>& alloc,
+    const std::function<void(void*)>& free,
+    const std::function<void()>& sample = nullptr,
+    size_t sample_interval = 1024);
+
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
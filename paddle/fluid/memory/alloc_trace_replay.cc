@@ -0,0 +1,155 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Replays an allocation trace recorded with --alloc_trace_file against
+// candidate allocators, and compares their throughput, peak reserved
+// memory and fragmentation.  For example:
+//
+//   alloc_trace_replay --trace=resnet.trace --allocators=buddy,segregated
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/memory/alloc_trace.h"
+#include "paddle/fluid/memory/detail/buddy_allocator.h"
+#include "paddle/fluid/memory/detail/system_allocator.h"
+#include "paddle/fluid/platform/cpu_info.h"
+
+DEFINE_string(trace, "", "The allocation trace to replay.");
+DEFINE_string(place,
+              "cpu",
+              "Replay the events on this place: cpu, gpu or cuda_pinned.");
+DEFINE_int32(device, 0, "The GPU of the events to replay if place is gpu.");
+DEFINE_string(allocators,
+              "buddy,segregated,malloc",
+              "Comma separated candidates: buddy, segregated, huge_page, "
+              "or malloc.");
+DEFINE_uint64(min_chunk_size_in_kb,
+              0,
+              "The min chunk size of buddy allocators; 0 for the CPU default.");
+DEFINE_uint64(max_chunk_size_in_kb,
+              0,
+              "The max chunk size of buddy allocators; 0 for the CPU default.");
+DECLARE_bool(use_pinned_memory);
+DECLARE_bool(use_segregated_buddy_pool);
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+
+using detail::BuddyAllocator;
+
+platform::Place ReplayPlace() {
+  if (FLAGS_place == "gpu") return platform::CUDAPlace(FLAGS_device);
+  if (FLAGS_place == "cuda_pinned") return platform::CUDAPinnedPlace();
+  PADDLE_ENFORCE(FLAGS_place == "cpu", "Unknown place %s", FLAGS_place);
+  return platform::CPUPlace();
+}
+
+std::unique_ptr<BuddyAllocator> NewBuddyAllocator(const std::string& name) {
+  size_t min_chunk = FLAGS_min_chunk_size_in_kb
+                         ? FLAGS_min_chunk_size_in_kb << 10
+                         : platform::CpuMinChunkSize();
+  size_t max_chunk = FLAGS_max_chunk_size_in_kb
+                         ? FLAGS_max_chunk_size_in_kb << 10
+                         : platform::CpuMaxChunkSize();
+  FLAGS_use_segregated_buddy_pool = name == "segregated";
+  detail::SystemAllocator* system_allocator;
+  if (name == "huge_page") {
+    system_allocator = new detail::HugePageCPUAllocator;
+  } else {
+    system_allocator = new detail::CPUAllocator;
+  }
+  return std::unique_ptr<BuddyAllocator>(
+      new BuddyAllocator(system_allocator, min_chunk, max_chunk));
+}
+
+void Replay(const std::vector<AllocTraceEvent>& events,
+            const std::string& name) {
+  AllocTraceReplayResult result;
+  size_t peak_reserved = 0;
+  double max_fragmentation = 0;
+
+  if (name == "malloc") {
+    result = ReplayAllocTrace(events,
+                              ReplayPlace(),
+                              [](size_t size) { return malloc(size); },
+                              [](void* p) { ::free(p); });
+  } else {
+    PADDLE_ENFORCE(name == "buddy" || name == "segregated" ||
+                       name == "huge_page",
+                   "Unknown allocator %s",
+                   name);
+    auto buddy = NewBuddyAllocator(name);
+    auto sample = [&] {
+      MemoryStats stats = buddy->Stats();
+      peak_reserved = std::max(peak_reserved, stats.reserved + stats.huge_used);
+      max_fragmentation = std::max(max_fragmentation, stats.fragmentation());
+    };
+    result = ReplayAllocTrace(events,
+                              ReplayPlace(),
+                              [&](size_t size) { return buddy->Alloc(size); },
+                              [&](void* p) { buddy->Free(p); },
+                              sample);
+    sample();
+  }
+
+  size_t num_ops = result.num_allocs + result.num_frees;
+  std::cout << name << "\t" << num_ops / result.seconds << "\t"
+            << (result.peak_requested >> 20) << "\t";
+  if (name == "malloc") {
+    std::cout << "n/a\tn/a";
+  } else {
+    std::cout << (peak_reserved >> 20) << "\t" << max_fragmentation;
+  }
+  std::cout << "\t" << result.num_failed_allocs << std::endl;
+  if (result.num_unmatched_frees > 0) {
+    std::cout << "  " << result.num_unmatched_frees
+              << " frees of blocks allocated before the trace" << std::endl;
+  }
+}
+
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::SetUsageMessage("alloc_trace_replay --trace=<file>");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_trace.empty()) {
+    std::cerr << gflags::ProgramUsage() << std::endl;
+    return 1;
+  }
+  // Replay on pageable memory, as mlock would dominate the refills.
+  FLAGS_use_pinned_memory = false;
+
+  auto events = paddle::fluid::memory::ReadAllocTrace(FLAGS_trace);
+  std::cout << events.size() << " events in " << FLAGS_trace << std::endl;
+  std::cout << "allocator\tops/s\tpeak requested (MB)\tpeak reserved (MB)"
+            << "\tmax fragmentation\tfailed allocs" << std::endl;
+
+  std::stringstream allocators(FLAGS_allocators);
+  std::string name;
+  while (std::getline(allocators, name, ',')) {
+    paddle::fluid::memory::Replay(events, name);
+  }
+  return 0;
+}
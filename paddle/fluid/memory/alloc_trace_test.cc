@@ -0,0 +1,100 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/memory/alloc_trace.h"
+
+#include <stdio.h>
+
+#include <thread>  // NOLINT
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/detail/buddy_allocator.h"
+#include "paddle/fluid/platform/cpu_info.h"
+
+DECLARE_bool(use_pinned_memory);
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+
+TEST(AllocTrace, WriteRead) {
+  const std::string path = "alloc_trace_test.trace";
+  int blocks[3];
+  {
+    AllocTraceWriter writer(path);
+    writer.RecordAlloc(platform::CPUPlace(), 100, &blocks[0]);
+    std::thread([&] {
+      writer.RecordAlloc(platform::CUDAPlace(1), 200, &blocks[1]);
+    }).join();
+    writer.RecordAlloc(platform::CUDAPinnedPlace(), 300, &blocks[2]);
+    writer.RecordFree(platform::CPUPlace(), &blocks[0]);
+  }
+
+  auto events = ReadAllocTrace(path);
+  ASSERT_EQ(events.size(), 4UL);
+  EXPECT_EQ(events[0].type, AllocTraceEvent::kAlloc);
+  EXPECT_EQ(events[0].size, 100UL);
+  EXPECT_EQ(events[0].address, reinterpret_cast<uint64_t>(&blocks[0]));
+  EXPECT_EQ(events[0].place_type, AllocTraceEvent::kCPU);
+  EXPECT_EQ(events[1].place_type, AllocTraceEvent::kCUDA);
+  EXPECT_EQ(events[1].device, 1);
+  EXPECT_NE(events[1].thread, events[0].thread);
+  EXPECT_EQ(events[2].place_type, AllocTraceEvent::kCUDAPinned);
+  EXPECT_EQ(events[2].thread, events[0].thread);
+  EXPECT_EQ(events[3].type, AllocTraceEvent::kFree);
+  EXPECT_EQ(events[3].address, events[0].address);
+  for (size_t i = 1; i < events.size(); ++i) {
+    EXPECT_GE(events[i].timestamp_ns, events[i - 1].timestamp_ns);
+  }
+  remove(path.c_str());
+}
+
+TEST(AllocTrace, Replay) {
+  FLAGS_use_pinned_memory = false;
+  std::vector<AllocTraceEvent> events;
+  auto add = [&](AllocTraceEvent::Type type, uint64_t address, size_t size) {
+    AllocTraceEvent event = {0, address, size, 0, type, 0, 0};
+    events.push_back(event);
+  };
+  add(AllocTraceEvent::kAlloc, 1, 1000);
+  add(AllocTraceEvent::kAlloc, 2, 5000);
+  add(AllocTraceEvent::kFree, 1, 0);
+  add(AllocTraceEvent::kAlloc, 3, 2000);
+  add(AllocTraceEvent::kFree, 4, 0);  // allocated before the trace
+  add(AllocTraceEvent::kFree, 2, 0);
+  events.back().place_type = AllocTraceEvent::kCUDA;
+
+  detail::BuddyAllocator buddy(new detail::CPUAllocator,
+                               platform::CpuMinChunkSize(),
+                               platform::CpuMaxChunkSize());
+  int samples = 0;
+  auto result = ReplayAllocTrace(events,
+                                 platform::CPUPlace(),
+                                 [&](size_t size) { return buddy.Alloc(size); },
+                                 [&](void* p) { buddy.Free(p); },
+                                 [&] { ++samples; },
+                                 2);
+  EXPECT_EQ(result.num_allocs, 3UL);
+  EXPECT_EQ(result.num_frees, 1UL);
+  EXPECT_EQ(result.num_unmatched_frees, 1UL);
+  EXPECT_EQ(result.num_failed_allocs, 0UL);
+  EXPECT_EQ(result.peak_requested, 7000UL);
+  EXPECT_EQ(samples, 2);
+  EXPECT_EQ(buddy.Used(), 0UL);
+}
+
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
@@ -13,8 +13,18 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/memory/detail/buddy_allocator.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+
+#include "gflags/gflags.h"
 #include "glog/logging.h"
 
+DEFINE_bool(use_segregated_buddy_pool,
+            false,
+            "If set, the buddy allocator indexes free chunks by power-of-two "
+            "size classes and a bitmap instead of a std::set.");
+
 namespace paddle {
 namespace fluid {
 namespace memory {
@@ -25,19 +35,23 @@ BuddyAllocator::BuddyAllocator(SystemAllocator* system_allocator,
                                size_t max_chunk_size)
     : min_chunk_size_(min_chunk_size),
       max_chunk_size_(max_chunk_size),
+      pool_(FLAGS_use_segregated_buddy_pool
+                ? static_cast<PoolIndex*>(new SegregatedPoolIndex)
+                : static_cast<PoolIndex*>(new SetPoolIndex)),
       cache_(system_allocator->UseGpu()),
       system_allocator_(std::move(system_allocator)) {}
 
 BuddyAllocator::~BuddyAllocator() {
   VLOG(10) << "BuddyAllocator Disconstructor makes sure that all of these "
               "have actually been freed";
-  while (!pool_.empty()) {
-    auto block = static_cast<MemoryBlock*>(std::get<2>(*pool_.begin()));
+  IndexSizeAddress chunk;
+  while (pool_->Largest(&chunk)) {
+    auto block = static_cast<MemoryBlock*>(std::get<2>(chunk));
     VLOG(10) << "Free from block (" << block << ", " << max_chunk_size_ << ")";
 
     system_allocator_->Free(block, max_chunk_size_, block->index(cache_));
     cache_.invalidate(block);
-    pool_.erase(pool_.begin());
+    pool_->Erase(chunk);
   }
 }
 
@@ -46,57 +60,119 @@ inline size_t align(size_t size, size_t alignment) {
   return remaining == 0 ? size : size + (alignment - remaining);
 }
 
+std::unique_lock<std::mutex> BuddyAllocator::Lock() {
+  // Only read the clock if the lock is contended.
+  std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    auto start = std::chrono::steady_clock::now();
+    lock.lock();
+    auto wait = std::chrono::steady_clock::now() - start;
+    stats_.lock_wait_ns +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count();
+    stats_.num_lock_contentions++;
+  }
+  return lock;
+}
+
 void* BuddyAllocator::Alloc(size_t unaligned_size) {
+  // acquire the allocator lock
+  auto lock = Lock();
+  return AllocImpl(unaligned_size);
+}
+
+void BuddyAllocator::Free(void* p) {
+  // Acquire the allocator lock
+  auto lock = Lock();
+  FreeImpl(p);
+
+  // Clean up if existing too much free memory
+
+  // Prefer freeing fallback allocation first
+  CleanIdleFallBackAlloc();
+
+  // Free normal allocation
+  CleanIdleNormalAlloc();
+}
+
+size_t BuddyAllocator::AllocBatch(size_t unaligned_size,
+                                  size_t n,
+                                  void** ptrs) {
+  auto lock = Lock();
+  size_t allocated = 0;
+  for (; allocated < n; ++allocated) {
+    ptrs[allocated] = AllocImpl(unaligned_size);
+    if (ptrs[allocated] == nullptr) break;
+  }
+  return allocated;
+}
+
+void BuddyAllocator::FreeBatch(void** ptrs, size_t n) {
+  auto lock = Lock();
+  for (size_t i = 0; i < n; ++i) {
+    FreeImpl(ptrs[i]);
+  }
+  CleanIdleFallBackAlloc();
+  CleanIdleNormalAlloc();
+}
+
+void* BuddyAllocator::AllocImpl(size_t unaligned_size) {
   // adjust allocation alignment
   size_t size =
       align(unaligned_size + sizeof(MemoryBlock::Desc), min_chunk_size_);
 
-  // acquire the allocator lock
-  std::lock_guard<std::mutex> lock(mutex_);
-
   VLOG(10) << "Allocate " << unaligned_size << " bytes from chunk size "
            << size;
 
+  stats_.num_allocs++;
+  int bucket = unaligned_size == 0 ? 0 : 63 - __builtin_clzll(unaligned_size);
+  stats_.size_histogram[std::min(bucket, MemoryStats::kNumSizeBuckets - 1)]++;
+
   // if the allocation is huge, send directly to the system allocator
   if (size > max_chunk_size_) {
     VLOG(10) << "Allocate from system allocator.";
-    return SystemAlloc(size);
+    void* p = SystemAlloc(size);
+    if (p != nullptr) {
+      stats_.num_huge_allocs++;
+      stats_.huge_used += size;
+      UpdatePeakUsed();
+    }
+    return p;
   }
 
   // query and allocate from the existing chunk
-  auto it = FindExistChunk(size);
+  IndexSizeAddress chunk;
 
   // refill the pool if failure
-  if (it == pool_.end()) {
-    it = RefillPool();
+  if (!FindExistChunk(size, &chunk)) {
     // if still failure, fail fatally
-    if (it == pool_.end()) {
+    if (!RefillPool(&chunk)) {
       return nullptr;
     }
   } else {
-    VLOG(10) << "Allocation from existing memory block " << std::get<2>(*it)
+    VLOG(10) << "Allocation from existing memory block " << std::get<2>(chunk)
              << " at address "
-             << reinterpret_cast<MemoryBlock*>(std::get<2>(*it))->data();
+             << reinterpret_cast<MemoryBlock*>(std::get<2>(chunk))->data();
   }
 
   total_used_ += size;
   total_free_ -= size;
+  UpdatePeakUsed();
 
   // split the allocation and return data for use
-  return reinterpret_cast<MemoryBlock*>(SplitToAlloc(it, size))->data();
+  return reinterpret_cast<MemoryBlock*>(SplitToAlloc(chunk, size))->data();
 }
 
-void BuddyAllocator::Free(void* p) {
+void BuddyAllocator::FreeImpl(void* p) {
   // Point back to metadata
   auto block = static_cast<MemoryBlock*>(p)->metadata();
 
-  // Acquire the allocator lock
-  std::lock_guard<std::mutex> lock(mutex_);
-
   VLOG(10) << "Free from address " << block;
 
+  stats_.num_frees++;
+
   if (block->type(cache_) == MemoryBlock::HUGE_CHUNK) {
     VLOG(10) << "Free directly from system allocator";
+    stats_.huge_used -= block->total_size(cache_);
     system_allocator_->Free(
         block, block->total_size(cache_), block->index(cache_));
 
@@ -120,12 +196,13 @@ void BuddyAllocator::Free(void* p) {
 
     if (right_buddy->type(cache_) == MemoryBlock::FREE_CHUNK) {
       // Take away right buddy from pool
-      pool_.erase(IndexSizeAddress(right_buddy->index(cache_),
-                                   right_buddy->total_size(cache_),
-                                   right_buddy));
+      pool_->Erase(IndexSizeAddress(right_buddy->index(cache_),
+                                    right_buddy->total_size(cache_),
+                                    right_buddy));
 
       // merge its right buddy to the block
       block->merge(&cache_, right_buddy);
+      stats_.num_merges++;
     }
   }
 
@@ -138,32 +215,50 @@ void BuddyAllocator::Free(void* p) {
 
     if (left_buddy->type(cache_) == MemoryBlock::FREE_CHUNK) {
       // Take away right buddy from pool
-      pool_.erase(IndexSizeAddress(left_buddy->index(cache_),
-                                   left_buddy->total_size(cache_),
-                                   left_buddy));
+      pool_->Erase(IndexSizeAddress(left_buddy->index(cache_),
+                                    left_buddy->total_size(cache_),
+                                    left_buddy));
 
       // merge the block to its left buddy
       left_buddy->merge(&cache_, block);
       block = left_buddy;
+      stats_.num_merges++;
     }
   }
 
   // Dumping this block into pool
   VLOG(10) << "Inserting free block (" << block << ", "
            << block->total_size(cache_) << ")";
-  pool_.insert(
+  pool_->Insert(
       IndexSizeAddress(block->index(cache_), block->total_size(cache_), block));
+}
 
-  // Clean up if existing too much free memory
+size_t BuddyAllocator::Used() { return total_used_; }
 
-  // Prefer freeing fallback allocation first
-  CleanIdleFallBackAlloc();
+MemoryStats BuddyAllocator::Stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  MemoryStats stats = stats_;
+  stats.used = total_used_;
+  stats.reserved = total_used_ + total_free_;
+  stats.free = total_free_;
+  stats.num_free_blocks = pool_->Size();
+  stats.largest_free_block = pool_->LargestSize();
+  return stats;
+}
 
-  // Free normal allocation
-  CleanIdleNormalAlloc();
+void BuddyAllocator::ResetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  MemoryStats stats;
+  stats.huge_used = stats_.huge_used;
+  stats.num_chunks = stats_.num_chunks;
+  stats_ = stats;
+  UpdatePeakUsed();
 }
 
-size_t BuddyAllocator::Used() { return total_used_; }
+void BuddyAllocator::UpdatePeakUsed() {
+  stats_.peak_used =
+      std::max(stats_.peak_used, total_used_ + stats_.huge_used);
+}
 
 void* BuddyAllocator::SystemAlloc(size_t size) {
   size_t index = 0;
@@ -179,7 +274,7 @@ void* BuddyAllocator::SystemAlloc(size_t size) {
   return static_cast<MemoryBlock*>(p)->data();
 }
 
-BuddyAllocator::PoolSet::iterator BuddyAllocator::RefillPool() {
+bool BuddyAllocator::RefillPool(IndexSizeAddress* chunk) {
 #ifdef PADDLE_WITH_CUDA
   if (system_allocator_->UseGpu()) {
     if ((total_used_ + total_free_) == 0) {
@@ -193,7 +288,7 @@ BuddyAllocator::PoolSet::iterator BuddyAllocator::RefillPool() {
   size_t index = 0;
   void* p = system_allocator_->Alloc(&index, max_chunk_size_);
 
-  if (p == nullptr) return pool_.end();
+  if (p == nullptr) return false;
 
   VLOG(10) << "Creating and inserting new block " << p
            << " from system allocator";
@@ -212,37 +307,23 @@ BuddyAllocator::PoolSet::iterator BuddyAllocator::RefillPool() {
   }
 
   total_free_ += max_chunk_size_;
+  stats_.num_chunks++;
+  stats_.num_refills++;
 
   // dump the block into pool
-  return pool_.insert(IndexSizeAddress(index, max_chunk_size_, p)).first;
+  *chunk = IndexSizeAddress(index, max_chunk_size_, p);
+  pool_->Insert(*chunk);
+  return true;
 }
 
-BuddyAllocator::PoolSet::iterator BuddyAllocator::FindExistChunk(size_t size) {
-  size_t index = 0;
-
-  while (1) {
-    auto it = pool_.lower_bound(IndexSizeAddress(index, size, nullptr));
-
-    // no match chunk memory
-    if (it == pool_.end()) return it;
-
-    if (std::get<0>(*it) > index) {
-      // find suitable one
-      if (std::get<1>(*it) >= size) {
-        return it;
-      }
-      // update and continue
-      index = std::get<0>(*it);
-      continue;
-    }
-    return it;
-  }
+bool BuddyAllocator::FindExistChunk(size_t size, IndexSizeAddress* chunk) {
+  return pool_->FindFit(size, chunk);
 }
 
-void* BuddyAllocator::SplitToAlloc(BuddyAllocator::PoolSet::iterator it,
+void* BuddyAllocator::SplitToAlloc(const IndexSizeAddress& chunk,
                                    size_t size) {
-  auto block = static_cast<MemoryBlock*>(std::get<2>(*it));
-  pool_.erase(it);
+  auto block = static_cast<MemoryBlock*>(std::get<2>(chunk));
+  pool_->Erase(chunk);
 
   VLOG(10) << "Split block (" << block << ", " << block->total_size(cache_)
            << ") into";
@@ -257,8 +338,9 @@ void* BuddyAllocator::SplitToAlloc(BuddyAllocator::PoolSet::iterator it,
     if (block->right_buddy(cache_)->type(cache_) == MemoryBlock::FREE_CHUNK) {
       VLOG(10) << "Insert right block (" << block->right_buddy(cache_) << ", "
                << block->right_buddy(cache_)->total_size(cache_) << ")";
+      stats_.num_splits++;
 
-      pool_.insert(
+      pool_->Insert(
           IndexSizeAddress(block->right_buddy(cache_)->index(cache_),
                            block->right_buddy(cache_)->total_size(cache_),
                            block->right_buddy(cache_)));
@@ -272,11 +354,12 @@ void BuddyAllocator::CleanIdleFallBackAlloc() {
   // If fallback allocation does not exist, return directly
   if (!fallback_alloc_count_) return;
 
-  for (auto pool = pool_.rbegin(); pool != pool_.rend();) {
+  IndexSizeAddress chunk;
+  while (pool_->Largest(&chunk)) {
     // If free memory block less than max_chunk_size_, return directly
-    if (std::get<1>(*pool) < max_chunk_size_) return;
+    if (std::get<1>(chunk) < max_chunk_size_) return;
 
-    MemoryBlock* block = static_cast<MemoryBlock*>(std::get<2>(*pool));
+    MemoryBlock* block = static_cast<MemoryBlock*>(std::get<2>(chunk));
 
     // If no GPU fallback allocator, return
     if (!system_allocator_->UseGpu() || block->index(cache_) == 0) {
@@ -288,9 +371,10 @@ void BuddyAllocator::CleanIdleFallBackAlloc() {
     system_allocator_->Free(block, max_chunk_size_, block->index(cache_));
     cache_.invalidate(block);
 
-    pool = PoolSet::reverse_iterator(pool_.erase(std::next(pool).base()));
+    pool_->Erase(chunk);
 
     total_free_ -= max_chunk_size_;
+    stats_.num_chunks--;
     fallback_alloc_count_--;
 
     // If no fall allocation exists, return directly
@@ -313,20 +397,22 @@ void BuddyAllocator::CleanIdleNormalAlloc() {
 
   if (!shall_free_alloc()) return;
 
-  for (auto pool = pool_.rbegin(); pool != pool_.rend();) {
+  IndexSizeAddress chunk;
+  while (pool_->Largest(&chunk)) {
     // If free memory block less than max_chunk_size_, return directly
-    if (std::get<1>(*pool) < max_chunk_size_) return;
+    if (std::get<1>(chunk) < max_chunk_size_) return;
 
-    MemoryBlock* block = static_cast<MemoryBlock*>(std::get<2>(*pool));
+    MemoryBlock* block = static_cast<MemoryBlock*>(std::get<2>(chunk));
 
     VLOG(10) << "Return block " << block << " to base allocator.";
 
     system_allocator_->Free(block, max_chunk_size_, block->index(cache_));
     cache_.invalidate(block);
 
-    pool = PoolSet::reverse_iterator(pool_.erase(std::next(pool).base()));
+    pool_->Erase(chunk);
 
     total_free_ -= max_chunk_size_;
+    stats_.num_chunks--;
 
     if (!shall_free_alloc()) return;
   }
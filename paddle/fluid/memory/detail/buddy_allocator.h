@@ -14,14 +14,16 @@ limitations under the License. */
 
 #pragma once
 
+#include <memory>
 #include <mutex>  // NOLINT
-#include <set>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
 
 #include "paddle/fluid/memory/detail/memory_block.h"
+#include "paddle/fluid/memory/detail/pool_index.h"
 #include "paddle/fluid/memory/detail/system_allocator.h"
+#include "paddle/fluid/memory/memory_stats.h"
 #include "paddle/fluid/platform/assert.h"
 #include "paddle/fluid/platform/cpu_info.h"
 #include "paddle/fluid/platform/gpu_info.h"
@@ -44,36 +46,60 @@ class BuddyAllocator {
   void Free(void* ptr);
   size_t Used();
 
+  /*! \brief Statistics since the last ResetStats */
+  MemoryStats Stats();
+  void ResetStats();
+
+  /**
+   *  \brief   Allocate up to n blocks of the same size while holding
+   *           the allocator lock only once.
+   *
+   *  \param   unaligned_size  the size of each allocation
+   *  \param   n               the number of blocks wanted
+   *  \param   ptrs            the output array, at least n elements
+   *
+   *  \return  the number of blocks actually allocated
+   */
+  size_t AllocBatch(size_t unaligned_size, size_t n, void** ptrs);
+
+  /*! \brief Free n blocks while holding the allocator lock only once */
+  void FreeBatch(void** ptrs, size_t n);
+
+  size_t min_chunk_size() const { return min_chunk_size_; }
+  size_t max_chunk_size() const { return max_chunk_size_; }
+
  public:
   // Disable copy and assignment
   BuddyAllocator(const BuddyAllocator&) = delete;
   BuddyAllocator& operator=(const BuddyAllocator&) = delete;
 
  private:
-  // Tuple (allocator index, memory size, memory address)
-  using IndexSizeAddress = std::tuple<size_t, size_t, void*>;
-  // Each element in PoolSet is a free allocation
-  using PoolSet = std::set<IndexSizeAddress>;
+  /*! \brief Acquire the allocator lock, recording the time waited */
+  std::unique_lock<std::mutex> Lock();
+
+  /*! \brief Alloc and Free without acquiring the allocator lock */
+  void* AllocImpl(size_t unaligned_size);
+  void FreeImpl(void* ptr);
 
   /*! \brief Allocate fixed-size memory from system */
   void* SystemAlloc(size_t size);
 
   /*! \brief If existing chunks are not suitable, refill pool */
-  PoolSet::iterator RefillPool();
+  bool RefillPool(IndexSizeAddress* chunk);
 
   /**
    *  \brief   Find the suitable chunk from existing pool and split
    *           it to left and right buddies
    *
-   *  \param   it     the iterator of pool list
+   *  \param   chunk  the free chunk in pool
    *  \param   size   the size of allocation
    *
    *  \return  the left buddy address
    */
-  void* SplitToAlloc(PoolSet::iterator it, size_t size);
+  void* SplitToAlloc(const IndexSizeAddress& chunk, size_t size);
 
   /*! \brief Find the existing chunk which used to allocation */
-  PoolSet::iterator FindExistChunk(size_t size);
+  bool FindExistChunk(size_t size, IndexSizeAddress* chunk);
 
   /*! \brief Clean idle fallback allocation */
   void CleanIdleFallBackAlloc();
@@ -81,6 +107,8 @@ class BuddyAllocator {
   /*! \brief Clean idle normal allocation */
   void CleanIdleNormalAlloc();
 
+  void UpdatePeakUsed();
+
  private:
   size_t total_used_ = 0;  // the total size of used memory
   size_t total_free_ = 0;  // the total size of free memory
@@ -92,13 +120,17 @@ class BuddyAllocator {
   /**
    * \brief A list of free allocation
    *
-   * \note  Only store free chunk memory in pool
+   * \note  Only store free chunk memory in pool.  It is a SetPoolIndex,
+   *        or a SegregatedPoolIndex if FLAGS_use_segregated_buddy_pool.
    */
-  PoolSet pool_;
+  std::unique_ptr<PoolIndex> pool_;
 
   /*! Record fallback allocation count for auto-scaling */
   size_t fallback_alloc_count_ = 0;
 
+  /*! Counters behind Stats(), updated while holding the lock */
+  MemoryStats stats_;
+
  private:
   /*! Unify the metadata format between GPU and CPU allocations */
   MetadataCache cache_;
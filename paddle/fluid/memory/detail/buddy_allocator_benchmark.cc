@@ -0,0 +1,92 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Compares the Alloc/Free throughput of a BuddyAllocator whose free
+// blocks are indexed by a std::set and by segregated size classes.
+
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/memory/detail/buddy_allocator.h"
+#include "paddle/fluid/platform/cpu_info.h"
+
+DEFINE_int32(iterations, 200000, "Alloc/Free steps per measurement.");
+DECLARE_bool(use_pinned_memory);
+DECLARE_bool(use_segregated_buddy_pool);
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+namespace detail {
+
+// Randomly allocates and frees mixed sizes, keeping up to max_live
+// allocations alive, and returns the number of Alloc/Free pairs per
+// second.
+double RandomAllocFree(BuddyAllocator* buddy, int iterations, int max_live) {
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> log_size(4, 18);
+  std::vector<void*> live;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    if (live.size() < static_cast<size_t>(max_live)) {
+      size_t size = 1UL << log_size(rng);
+      void* p = buddy->Alloc(size + rng() % size);
+      live.push_back(p);
+    }
+    if (live.size() == static_cast<size_t>(max_live) || rng() % 2) {
+      size_t victim = rng() % live.size();
+      buddy->Free(live[victim]);
+      live[victim] = live.back();
+      live.pop_back();
+    }
+  }
+  for (auto p : live) buddy->Free(p);
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return iterations / elapsed.count();
+}
+
+void Run() {
+  FLAGS_use_pinned_memory = false;
+
+  std::cout << "live blocks\tstd::set (ops/s)\tsegregated (ops/s)\n";
+  for (int max_live : {16, 256, 2048}) {
+    double throughput[2];
+    for (bool segregated : {false, true}) {
+      FLAGS_use_segregated_buddy_pool = segregated;
+      BuddyAllocator buddy(new CPUAllocator,
+                           platform::CpuMinChunkSize(),
+                           platform::CpuMaxChunkSize());
+      throughput[segregated] =
+          RandomAllocFree(&buddy, FLAGS_iterations, max_live);
+    }
+    std::cout << max_live << "\t" << throughput[0] << "\t" << throughput[1]
+              << std::endl;
+  }
+}
+
+}  // namespace detail
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  paddle::fluid::memory::detail::Run();
+  return 0;
+}
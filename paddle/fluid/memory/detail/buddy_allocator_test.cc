@@ -0,0 +1,131 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/memory/detail/buddy_allocator.h"
+
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/cpu_info.h"
+
+DECLARE_bool(use_pinned_memory);
+DECLARE_bool(use_segregated_buddy_pool);
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+namespace detail {
+
+void TestPoolIndex(PoolIndex* pool) {
+  int blocks[4];
+  EXPECT_TRUE(pool->Empty());
+  pool->Insert(IndexSizeAddress(0, 4096, &blocks[0]));
+  pool->Insert(IndexSizeAddress(0, 12288, &blocks[1]));
+  pool->Insert(IndexSizeAddress(1, 65536, &blocks[2]));
+  pool->Insert(IndexSizeAddress(0, 1 << 20, &blocks[3]));
+
+  IndexSizeAddress chunk;
+  ASSERT_TRUE(pool->FindFit(4096, &chunk));
+  EXPECT_GE(std::get<1>(chunk), 4096UL);
+  EXPECT_EQ(std::get<0>(chunk), 0UL);
+
+  ASSERT_TRUE(pool->FindFit(10000, &chunk));
+  EXPECT_GE(std::get<1>(chunk), 10000UL);
+  EXPECT_EQ(std::get<0>(chunk), 0UL);
+
+  // Lower allocator indices are preferred.
+  ASSERT_TRUE(pool->FindFit(32768, &chunk));
+  EXPECT_EQ(std::get<2>(chunk), &blocks[3]);
+
+  ASSERT_TRUE(pool->Largest(&chunk));
+  EXPECT_EQ(std::get<2>(chunk), &blocks[2]);
+  // The largest chunk by size may have a lower index.
+  EXPECT_EQ(pool->LargestSize(), 1UL << 20);
+
+  pool->Erase(IndexSizeAddress(0, 1 << 20, &blocks[3]));
+  ASSERT_TRUE(pool->FindFit(32768, &chunk));
+  EXPECT_EQ(std::get<2>(chunk), &blocks[2]);
+  EXPECT_FALSE(pool->FindFit(1 << 20, &chunk));
+
+  pool->Erase(IndexSizeAddress(1, 65536, &blocks[2]));
+  pool->Erase(IndexSizeAddress(0, 12288, &blocks[1]));
+  ASSERT_TRUE(pool->Largest(&chunk));
+  EXPECT_EQ(std::get<2>(chunk), &blocks[0]);
+  pool->Erase(IndexSizeAddress(0, 4096, &blocks[0]));
+  EXPECT_TRUE(pool->Empty());
+  EXPECT_FALSE(pool->Largest(&chunk));
+  EXPECT_EQ(pool->LargestSize(), 0UL);
+}
+
+TEST(PoolIndex, Set) {
+  SetPoolIndex pool;
+  TestPoolIndex(&pool);
+}
+
+TEST(PoolIndex, Segregated) {
+  SegregatedPoolIndex pool;
+  TestPoolIndex(&pool);
+}
+
+TEST(BuddyAllocator, Stats) {
+  FLAGS_use_pinned_memory = false;
+  const size_t kMinChunk = platform::CpuMinChunkSize();
+  const size_t kMaxChunk = 1 << 20;
+  BuddyAllocator buddy(new CPUAllocator, kMinChunk, kMaxChunk);
+
+  void* small = buddy.Alloc(100);
+  void* medium = buddy.Alloc(3 * kMinChunk);
+  void* huge = buddy.Alloc(2 * kMaxChunk);
+
+  MemoryStats stats = buddy.Stats();
+  EXPECT_EQ(stats.num_allocs, 3UL);
+  EXPECT_EQ(stats.num_huge_allocs, 1UL);
+  EXPECT_EQ(stats.num_chunks, 1UL);
+  EXPECT_EQ(stats.num_splits, 2UL);
+  EXPECT_EQ(stats.used, buddy.Used());
+  EXPECT_EQ(stats.used, 5 * kMinChunk);
+  EXPECT_GT(stats.huge_used, 2 * kMaxChunk);
+  EXPECT_EQ(stats.reserved, kMaxChunk);
+  EXPECT_EQ(stats.free, kMaxChunk - stats.used);
+  EXPECT_EQ(stats.largest_free_block, stats.free);
+  EXPECT_EQ(stats.fragmentation(), 0.0);
+  EXPECT_EQ(stats.size_histogram[6], 1UL);
+
+  // Freeing the small block leaves a hole before the medium one.
+  buddy.Free(small);
+  buddy.Free(huge);
+  stats = buddy.Stats();
+  EXPECT_EQ(stats.num_free_blocks, 2UL);
+  EXPECT_EQ(stats.huge_used, 0UL);
+  EXPECT_GT(stats.fragmentation(), 0.0);
+  EXPECT_GT(stats.peak_used, stats.used + 2 * kMaxChunk);
+
+  buddy.ResetStats();
+  stats = buddy.Stats();
+  EXPECT_EQ(stats.num_allocs, 0UL);
+  EXPECT_EQ(stats.peak_used, stats.used);
+  EXPECT_EQ(stats.num_chunks, 1UL);
+
+  buddy.Free(medium);
+  stats = buddy.Stats();
+  EXPECT_EQ(stats.num_frees, 1UL);
+  EXPECT_EQ(stats.num_merges, 2UL);
+  EXPECT_EQ(stats.used, 0UL);
+}
+
+}  // namespace detail
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
@@ -0,0 +1,204 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Compares the time and data TLB misses of memory-bound and GEMM
+// workloads on buffers from CPUAllocator and HugePageCPUAllocator.
+
+#include <cblas.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>  // NOLINT
+#include <iostream>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/memory/detail/system_allocator.h"
+#include "paddle/fluid/platform/enforce.h"
+
+DECLARE_bool(use_pinned_memory);
+DECLARE_bool(prefault_huge_page_memory);
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+namespace detail {
+
+// Counts data TLB read misses of this thread, or returns -1 if the
+// performance counter is not available, e.g., in a container.
+class TLBMissCounter {
+ public:
+  TLBMissCounter() {
+#ifdef __linux__
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+
+  ~TLBMissCounter() {
+#ifdef __linux__
+    if (fd_ >= 0) close(fd_);
+#endif
+  }
+
+  void Start() {
+#ifdef __linux__
+    if (fd_ < 0) return;
+    ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+  }
+
+  int64_t Stop() {
+#ifdef __linux__
+    if (fd_ < 0) return -1;
+    ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    int64_t count = 0;
+    if (read(fd_, &count, sizeof(count)) != sizeof(count)) return -1;
+    return count;
+#else
+    return -1;
+#endif
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+struct BenchmarkResult {
+  double seconds;
+  int64_t tlb_misses;
+};
+
+template <typename Callback>
+BenchmarkResult Measure(Callback callback) {
+  TLBMissCounter counter;
+  auto start = std::chrono::steady_clock::now();
+  counter.Start();
+  callback();
+  int64_t misses = counter.Stop();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return BenchmarkResult{elapsed.count(), misses};
+}
+
+// Random gathers over a large buffer, which is dominated by TLB misses
+// when the buffer is backed by 4 KB pages.
+BenchmarkResult RandomAccess(SystemAllocator* a) {
+  const size_t kSize = 256UL << 20;
+  const size_t kMask = kSize / sizeof(float) - 1;
+  const int kAccesses = 10000000;
+
+  size_t index;
+  float* buffer = static_cast<float*>(a->Alloc(&index, kSize));
+  PADDLE_ENFORCE_NOT_NULL(buffer);
+  memset(buffer, 0, kSize);
+
+  float sum = 0;
+  auto result = Measure([&] {
+    uint64_t i = 1;
+    for (int n = 0; n < kAccesses; ++n) {
+      i = i * 6364136223846793005ULL + 1442695040888963407ULL;
+      sum += buffer[(i >> 20) & kMask];
+    }
+  });
+  PADDLE_ENFORCE_EQ(sum, 0.f);
+
+  a->Free(buffer, kSize, index);
+  return result;
+}
+
+BenchmarkResult Gemm(SystemAllocator* a) {
+  const int kDim = 2048;
+  const size_t kSize = kDim * kDim * sizeof(float);
+
+  size_t index[3];
+  float* m[3];
+  for (int i = 0; i < 3; ++i) {
+    m[i] = static_cast<float*>(a->Alloc(&index[i], kSize));
+    PADDLE_ENFORCE_NOT_NULL(m[i]);
+    for (int j = 0; j < kDim * kDim; ++j) m[i][j] = 1.0f;
+  }
+
+  auto result = Measure([&] {
+    cblas_sgemm(CblasRowMajor,
+                CblasNoTrans,
+                CblasNoTrans,
+                kDim,
+                kDim,
+                kDim,
+                1.0f,
+                m[0],
+                kDim,
+                m[1],
+                kDim,
+                0.0f,
+                m[2],
+                kDim);
+  });
+  PADDLE_ENFORCE_EQ(m[2][0], static_cast<float>(kDim));
+
+  for (int i = 0; i < 3; ++i) a->Free(m[i], kSize, index[i]);
+  return result;
+}
+
+void Run() {
+  FLAGS_use_pinned_memory = false;
+  FLAGS_prefault_huge_page_memory = true;
+  CPUAllocator base_pages;
+  HugePageCPUAllocator huge_pages;
+
+  auto print = [](const char* name, BenchmarkResult r) {
+    std::cout << name << "\t" << r.seconds << " s\tdTLB misses: ";
+    if (r.tlb_misses < 0) {
+      std::cout << "n/a" << std::endl;
+    } else {
+      std::cout << r.tlb_misses << std::endl;
+    }
+  };
+
+  std::cout << "random access over 256 MB" << std::endl;
+  print("posix_memalign", RandomAccess(&base_pages));
+  print("huge pages", RandomAccess(&huge_pages));
+
+  std::cout << "2048x2048 sgemm" << std::endl;
+  print("posix_memalign", Gemm(&base_pages));
+  print("huge pages", Gemm(&huge_pages));
+}
+
+}  // namespace detail
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  paddle::fluid::memory::detail::Run();
+  return 0;
+}
@@ -0,0 +1,61 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/memory/detail/system_allocator.h"
+
+DECLARE_bool(use_pinned_memory);
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+namespace detail {
+
+TEST(HugePageCPUAllocator, Alloc) {
+  FLAGS_use_pinned_memory = false;
+  HugePageCPUAllocator a;
+  for (size_t size : {1UL, 4096UL, 3UL << 20, 17UL << 20}) {
+    size_t index;
+    void* p = a.Alloc(&index, size);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % (2 << 20), 0UL);
+    EXPECT_EQ(index, 0UL);
+    memset(p, 1, size);
+    a.Free(p, size, index);
+  }
+  size_t index;
+  EXPECT_EQ(a.Alloc(&index, 0), nullptr);
+}
+
+TEST(NumaCPUAllocator, Alloc) {
+  FLAGS_use_pinned_memory = false;
+  for (int node : {0, -1}) {
+    NumaCPUAllocator a(node);
+    size_t index;
+    void* p = a.Alloc(&index, 3UL << 20);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 4096, 0UL);
+    memset(p, 1, 3UL << 20);
+    a.Free(p, 3UL << 20, index);
+  }
+}
+
+}  // namespace detail
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
@@ -0,0 +1,183 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/memory/detail/pool_index.h"
+
+#include <algorithm>
+
+#include "paddle/fluid/platform/assert.h"
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+namespace detail {
+
+void SetPoolIndex::Insert(const IndexSizeAddress& chunk) {
+  pool_.insert(chunk);
+}
+
+void SetPoolIndex::Erase(const IndexSizeAddress& chunk) { pool_.erase(chunk); }
+
+bool SetPoolIndex::FindFit(size_t size, IndexSizeAddress* chunk) const {
+  size_t index = 0;
+
+  while (1) {
+    auto it = pool_.lower_bound(IndexSizeAddress(index, size, nullptr));
+
+    // no match chunk memory
+    if (it == pool_.end()) return false;
+
+    if (std::get<0>(*it) > index) {
+      // find suitable one
+      if (std::get<1>(*it) >= size) {
+        *chunk = *it;
+        return true;
+      }
+      // update and continue
+      index = std::get<0>(*it);
+      continue;
+    }
+    *chunk = *it;
+    return true;
+  }
+}
+
+bool SetPoolIndex::Largest(IndexSizeAddress* chunk) const {
+  if (pool_.empty()) return false;
+  *chunk = *pool_.rbegin();
+  return true;
+}
+
+size_t SetPoolIndex::LargestSize() const {
+  size_t largest = 0;
+  // The last chunk of each index is its largest one.
+  for (auto it = pool_.rbegin(); it != pool_.rend();) {
+    largest = std::max(largest, std::get<1>(*it));
+    it = std::set<IndexSizeAddress>::const_reverse_iterator(
+        pool_.lower_bound(IndexSizeAddress(std::get<0>(*it), 0, nullptr)));
+  }
+  return largest;
+}
+
+bool SetPoolIndex::Empty() const { return pool_.empty(); }
+
+size_t SetPoolIndex::Size() const { return pool_.size(); }
+
+namespace {
+
+inline int Log2Floor(size_t size) { return 63 - __builtin_clzll(size); }
+
+inline int Log2Ceil(size_t size) {
+  int floor = Log2Floor(size);
+  return (size & (size - 1)) == 0 ? floor : floor + 1;
+}
+
+}  // namespace
+
+void SegregatedPoolIndex::Insert(const IndexSizeAddress& chunk) {
+  size_t index = std::get<0>(chunk);
+  size_t size = std::get<1>(chunk);
+  PADDLE_ASSERT(size > 0);
+
+  if (index >= indices_.size()) indices_.resize(index + 1);
+  auto& bins = indices_[index];
+
+  int b = Log2Floor(size);
+  positions_[std::get<2>(chunk)] = bins.bins[b].size();
+  bins.bins[b].emplace_back(size, std::get<2>(chunk));
+  bins.bitmap |= 1ULL << b;
+}
+
+void SegregatedPoolIndex::Erase(const IndexSizeAddress& chunk) {
+  auto pos = positions_.find(std::get<2>(chunk));
+  if (pos == positions_.end()) return;
+
+  auto& bins = indices_[std::get<0>(chunk)];
+  int b = Log2Floor(std::get<1>(chunk));
+  auto& bin = bins.bins[b];
+
+  // Move the last chunk of the bin into the erased slot.
+  size_t i = pos->second;
+  positions_.erase(pos);
+  if (i + 1 != bin.size()) {
+    bin[i] = bin.back();
+    positions_[bin[i].second] = i;
+  }
+  bin.pop_back();
+
+  if (bin.empty()) bins.bitmap &= ~(1ULL << b);
+}
+
+bool SegregatedPoolIndex::FindFit(size_t size, IndexSizeAddress* chunk) const {
+  int floor = Log2Floor(size);
+  int ceil = Log2Ceil(size);
+
+  for (size_t index = 0; index < indices_.size(); ++index) {
+    auto& bins = indices_[index];
+
+    uint64_t fits = ceil < kNumBins ? bins.bitmap & (~0ULL << ceil) : 0;
+    if (fits) {
+      auto& bin = bins.bins[__builtin_ctzll(fits)];
+      *chunk = IndexSizeAddress(index, bin.back().first, bin.back().second);
+      return true;
+    }
+
+    if (floor != ceil && (bins.bitmap & (1ULL << floor))) {
+      for (auto& free_chunk : bins.bins[floor]) {
+        if (free_chunk.first >= size) {
+          *chunk =
+              IndexSizeAddress(index, free_chunk.first, free_chunk.second);
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+bool SegregatedPoolIndex::Largest(IndexSizeAddress* chunk) const {
+  for (size_t index = indices_.size(); index-- > 0;) {
+    auto& bins = indices_[index];
+    if (!bins.bitmap) continue;
+
+    auto& bin = bins.bins[Log2Floor(bins.bitmap)];
+    auto largest = bin.front();
+    for (auto& free_chunk : bin) {
+      if (free_chunk.first > largest.first) largest = free_chunk;
+    }
+    *chunk = IndexSizeAddress(index, largest.first, largest.second);
+    return true;
+  }
+  return false;
+}
+
+size_t SegregatedPoolIndex::LargestSize() const {
+  size_t largest = 0;
+  for (auto& bins : indices_) {
+    if (!bins.bitmap) continue;
+    for (auto& free_chunk : bins.bins[Log2Floor(bins.bitmap)]) {
+      largest = std::max(largest, free_chunk.first);
+    }
+  }
+  return largest;
+}
+
+bool SegregatedPoolIndex::Empty() const { return positions_.empty(); }
+
+size_t SegregatedPoolIndex::Size() const { return positions_.size(); }
+
+}  // namespace detail
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
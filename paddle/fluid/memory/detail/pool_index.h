@@ -0,0 +1,118 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint64_t
+
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+namespace detail {
+
+// Tuple (allocator index, memory size, memory address)
+using IndexSizeAddress = std::tuple<size_t, size_t, void*>;
+
+/**
+ * \brief PoolIndex indexes the free chunks of a BuddyAllocator.
+ *
+ * \note  Lookups prefer chunks with a lower allocator index, e.g.,
+ *        normal GPU memory over the host fallback memory.
+ */
+class PoolIndex {
+ public:
+  virtual ~PoolIndex() {}
+
+  virtual void Insert(const IndexSizeAddress& chunk) = 0;
+  virtual void Erase(const IndexSizeAddress& chunk) = 0;
+
+  /*! \brief Find a free chunk whose size is no less than size */
+  virtual bool FindFit(size_t size, IndexSizeAddress* chunk) const = 0;
+
+  /*! \brief Find the free chunk with the largest (index, size) */
+  virtual bool Largest(IndexSizeAddress* chunk) const = 0;
+
+  /*! \brief The largest size of a free chunk of any index, or 0 */
+  virtual size_t LargestSize() const = 0;
+
+  virtual bool Empty() const = 0;
+
+  /*! \brief The number of free chunks */
+  virtual size_t Size() const = 0;
+};
+
+/**
+ * \brief SetPoolIndex keeps free chunks in a std::set ordered by
+ *        (index, size, address) and returns the best fit.
+ */
+class SetPoolIndex : public PoolIndex {
+ public:
+  void Insert(const IndexSizeAddress& chunk) override;
+  void Erase(const IndexSizeAddress& chunk) override;
+  bool FindFit(size_t size, IndexSizeAddress* chunk) const override;
+  bool Largest(IndexSizeAddress* chunk) const override;
+  size_t LargestSize() const override;
+  bool Empty() const override;
+  size_t Size() const override;
+
+ private:
+  std::set<IndexSizeAddress> pool_;
+};
+
+/**
+ * \brief SegregatedPoolIndex bins free chunks by the power of two
+ *        below their size, and keeps a bitmap of the non-empty bins
+ *        for each allocator index.
+ *
+ * \note  Every chunk in the bin of ceil(log2(size)) or above fits, so
+ *        FindFit is a bit scan in the common case.  Only when none of
+ *        them is free does it look into the partially fitting bin of
+ *        floor(log2(size)).
+ */
+class SegregatedPoolIndex : public PoolIndex {
+ public:
+  void Insert(const IndexSizeAddress& chunk) override;
+  void Erase(const IndexSizeAddress& chunk) override;
+  bool FindFit(size_t size, IndexSizeAddress* chunk) const override;
+  bool Largest(IndexSizeAddress* chunk) const override;
+  size_t LargestSize() const override;
+  bool Empty() const override;
+  size_t Size() const override;
+
+ private:
+  static constexpr int kNumBins = 64;
+
+  // The (size, address) of free chunks in one bin.
+  using Bin = std::vector<std::pair<size_t, void*>>;
+
+  struct Bins {
+    uint64_t bitmap = 0;  // bit b is set if bins[b] is non-empty
+    Bin bins[kNumBins];
+  };
+
+  std::vector<Bins> indices_;
+  // The position of each free chunk in its bin, for O(1) erase.
+  std::unordered_map<void*, size_t> positions_;
+};
+
+}  // namespace detail
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
@@ -15,7 +15,11 @@ limitations under the License. */
 #include "paddle/fluid/memory/detail/system_allocator.h"
 
 #include <stdlib.h>    // for malloc and free
-#include <sys/mman.h>  // for mlock and munlock
+#include <sys/mman.h>  // for mlock, munlock, mmap and madvise
+#include <unistd.h>    // for sysconf and syscall
+#ifdef __linux__
+#include <sys/syscall.h>  // for __NR_mbind
+#endif
 #include <algorithm>   // for std::max
 
 #include "gflags/gflags.h"
@@ -30,6 +34,13 @@ limitations under the License. */
 // of memory available to the system for paging.  So, by default, we
 // should set false to use_pinned_memory.
 DEFINE_bool(use_pinned_memory, true, "If set, allocate cpu pinned memory.");
+DEFINE_bool(use_huge_page_cpu_memory,
+            false,
+            "If set, allocate cpu memory chunks by mmap and back them by "
+            "transparent huge pages.");
+DEFINE_bool(prefault_huge_page_memory,
+            false,
+            "If set, fault in huge page cpu memory chunks on allocation.");
 DECLARE_double(fraction_of_gpu_memory_to_use);
 namespace paddle {
 namespace fluid {
@@ -69,6 +80,140 @@ void CPUAllocator::Free(void* p, size_t size, size_t index) {
 
 bool CPUAllocator::UseGpu() const { return false; }
 
+namespace {
+
+constexpr size_t kHugePageSize = 2UL << 20;
+
+inline size_t AlignUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+// Maps size bytes aligned to alignment.  It over-reserves by alignment,
+// so that an aligned range fits, and unmaps the slack on both sides.
+uint8_t* MapAligned(size_t size, size_t alignment) {
+  size_t length = AlignUp(size, sysconf(_SC_PAGE_SIZE));
+  size_t reserved = length + alignment;
+  void* raw = mmap(nullptr,
+                   reserved,
+                   PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS,
+                   -1,
+                   0);
+  if (raw == MAP_FAILED) {
+    LOG(WARNING) << "Cannot mmap " << size / 1024.0 / 1024.0
+                 << " MB CPU memory.";
+    return nullptr;
+  }
+
+  uint8_t* begin = static_cast<uint8_t*>(raw);
+  uint8_t* p = reinterpret_cast<uint8_t*>(
+      AlignUp(reinterpret_cast<uintptr_t>(begin), alignment));
+  size_t head = p - begin;
+  size_t tail = reserved - head - length;
+  if (head > 0) munmap(begin, head);
+  if (tail > 0) munmap(p + length, tail);
+  return p;
+}
+
+void AdviseHugePage(uint8_t* p, size_t size) {
+#ifdef MADV_HUGEPAGE
+  madvise(p, size, MADV_HUGEPAGE);
+#endif
+}
+
+// Faults in and locks the pages of a fresh mapping as the flags say.
+// This must come after madvise and mbind, which only affect pages that
+// are not faulted in yet.  It is also why MAP_POPULATE is not used: it
+// would fault in the over-reserved range with base pages.
+void PrefaultAndLock(uint8_t* p, size_t size, size_t* index) {
+  *index = 0;  // unlock memory
+
+  if (FLAGS_prefault_huge_page_memory) {
+    size_t page_size = sysconf(_SC_PAGE_SIZE);
+    for (size_t offset = 0; offset < size; offset += page_size) {
+      p[offset] = 0;
+    }
+  }
+
+  if (FLAGS_use_pinned_memory) {
+    *index = 1;
+    mlock(p, size);  // lock memory
+  }
+}
+
+void Unmap(void* p, size_t size, size_t index) {
+  if (p == nullptr) return;
+  if (index == 1) {
+    munlock(p, size);
+  }
+  munmap(p, size);
+}
+
+// Sets the NUMA memory policy of a range that is not faulted in yet.
+// The constants follow <numaif.h>, to avoid depending on libnuma.
+void BindToNumaNode(uint8_t* p, size_t size, int node) {
+#ifdef __linux__
+  const int kMpolPreferred = 1;
+  const int kMpolInterleave = 3;
+
+  int mode = kMpolPreferred;
+  unsigned long nodemask = 0;  // NOLINT
+  if (node < 0) {
+    mode = kMpolInterleave;
+    int num_nodes = std::min(platform::NumaNodeCount(), 64);
+    nodemask = num_nodes == 64 ? ~0UL : (1UL << num_nodes) - 1;
+  } else if (node < 64) {
+    nodemask = 1UL << node;
+  } else {
+    LOG(WARNING) << "NUMA node " << node << " is out of range";
+    return;
+  }
+
+  if (syscall(__NR_mbind, p, size, mode, &nodemask, 65, 0) != 0) {
+    LOG(WARNING) << "Cannot bind CPU memory to NUMA node " << node;
+  }
+#endif
+}
+
+}  // namespace
+
+void* HugePageCPUAllocator::Alloc(size_t* index, size_t size) {
+  if (size <= 0) return nullptr;
+
+  uint8_t* p = MapAligned(size, kHugePageSize);
+  if (p == nullptr) return nullptr;
+
+  AdviseHugePage(p, size);
+  PrefaultAndLock(p, size, index);
+  return p;
+}
+
+void HugePageCPUAllocator::Free(void* p, size_t size, size_t index) {
+  Unmap(p, size, index);
+}
+
+bool HugePageCPUAllocator::UseGpu() const { return false; }
+
+void* NumaCPUAllocator::Alloc(size_t* index, size_t size) {
+  if (size <= 0) return nullptr;
+
+  uint8_t* p = MapAligned(
+      size,
+      FLAGS_use_huge_page_cpu_memory ? kHugePageSize : sysconf(_SC_PAGE_SIZE));
+  if (p == nullptr) return nullptr;
+
+  if (FLAGS_use_huge_page_cpu_memory) AdviseHugePage(p, size);
+  BindToNumaNode(p, size, node_);
+  PrefaultAndLock(p, size, index);
+  return p;
+}
+
+void NumaCPUAllocator::Free(void* p, size_t size, size_t index) {
+  Unmap(p, size, index);
+}
+
+bool NumaCPUAllocator::UseGpu() const { return false; }
+
 #ifdef PADDLE_WITH_CUDA
 
 void* GPUAllocator::Alloc(size_t* index, size_t size) {
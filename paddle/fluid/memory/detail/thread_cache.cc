@@ -0,0 +1,157 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/memory/detail/thread_cache.h"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+namespace detail {
+
+namespace {
+
+// The header keeps the 32-byte alignment given by CPUAllocator.
+struct Header {
+  int size_class;
+};
+constexpr size_t kHeaderSize = 32;
+static_assert(sizeof(Header) <= kHeaderSize, "Header is too large");
+
+// A refill or drain moves about this many bytes at once.
+constexpr size_t kBatchBytes = 256 << 10;
+constexpr size_t kMaxBatch = 32;
+
+inline Header* HeaderOf(void* ptr) {
+  return reinterpret_cast<Header*>(static_cast<uint8_t*>(ptr) - kHeaderSize);
+}
+
+inline void* DataOf(void* block_data) {
+  return static_cast<uint8_t*>(block_data) + kHeaderSize;
+}
+
+}  // namespace
+
+ThreadCache::ThreadCache(BuddyAllocator* allocator, size_t max_cached_size)
+    : allocator_(allocator) {
+  for (size_t block_size = allocator->min_chunk_size();
+       block_size <= std::min(max_cached_size, allocator->max_chunk_size());
+       block_size <<= 1) {
+    FreeList list;
+    list.block_size = block_size;
+    list.batch = std::max<size_t>(
+        1, std::min(kMaxBatch, kBatchBytes / block_size));
+    list.blocks.reserve(2 * list.batch);
+    lists_.push_back(std::move(list));
+  }
+}
+
+ThreadCache::~ThreadCache() {
+  for (auto& list : lists_) {
+    Drain(&list, list.blocks.size());
+  }
+}
+
+int ThreadCache::SizeClass(size_t size) const {
+  size_t total_size = size + kHeaderSize + sizeof(MemoryBlock::Desc);
+  for (size_t i = 0; i < lists_.size(); ++i) {
+    if (total_size <= lists_[i].block_size) return static_cast<int>(i);
+  }
+  return -1;
+}
+
+void* ThreadCache::Alloc(size_t size) {
+  int size_class = SizeClass(size);
+
+  void* block_data = nullptr;
+  if (size_class < 0) {
+    block_data = allocator_->Alloc(size + kHeaderSize);
+  } else {
+    auto& list = lists_[size_class];
+    if (list.blocks.empty()) Refill(&list);
+    if (list.blocks.empty()) return nullptr;
+    block_data = list.blocks.back();
+    list.blocks.pop_back();
+    cached_size_ -= list.block_size;
+  }
+  if (block_data == nullptr) return nullptr;
+
+  void* ptr = DataOf(block_data);
+  HeaderOf(ptr)->size_class = size_class;
+  return ptr;
+}
+
+void ThreadCache::Free(void* ptr) {
+  int size_class = HeaderOf(ptr)->size_class;
+  void* block_data = HeaderOf(ptr);
+
+  if (size_class < 0) {
+    allocator_->Free(block_data);
+    return;
+  }
+
+  PADDLE_ASSERT(static_cast<size_t>(size_class) < lists_.size());
+  auto& list = lists_[size_class];
+  list.blocks.push_back(block_data);
+  cached_size_ += list.block_size;
+
+  if (list.blocks.size() >= 2 * list.batch) {
+    Drain(&list, list.batch);
+  }
+}
+
+void* ThreadCache::AllocUncached(BuddyAllocator* allocator, size_t size) {
+  void* block_data = allocator->Alloc(size + kHeaderSize);
+  if (block_data == nullptr) return nullptr;
+
+  void* ptr = DataOf(block_data);
+  HeaderOf(ptr)->size_class = -1;
+  return ptr;
+}
+
+void ThreadCache::FreeUncached(BuddyAllocator* allocator, void* ptr) {
+  // Cached blocks are whole buddy blocks too, whatever their class.
+  allocator->Free(HeaderOf(ptr));
+}
+
+void ThreadCache::Refill(FreeList* list) {
+  list->blocks.resize(list->batch);
+  size_t unaligned_size = list->block_size - sizeof(MemoryBlock::Desc);
+  size_t n = allocator_->AllocBatch(
+      unaligned_size, list->batch, list->blocks.data());
+  list->blocks.resize(n);
+  cached_size_ += n * list->block_size;
+
+  VLOG(10) << "Refill " << n << " blocks of size " << list->block_size;
+}
+
+void ThreadCache::Drain(FreeList* list, size_t n) {
+  if (n == 0) return;
+
+  // The oldest blocks sit at the front; the recently freed ones at the
+  // back are the most likely to still be in the CPU cache.
+  allocator_->FreeBatch(list->blocks.data(), n);
+  list->blocks.erase(list->blocks.begin(), list->blocks.begin() + n);
+  cached_size_ -= n * list->block_size;
+
+  VLOG(10) << "Drain " << n << " blocks of size " << list->block_size;
+}
+
+}  // namespace detail
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
@@ -0,0 +1,92 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <vector>
+
+#include "paddle/fluid/memory/detail/buddy_allocator.h"
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+namespace detail {
+
+/**
+ * \brief ThreadCache is a per-thread front-end of a BuddyAllocator.
+ *
+ * \note  Allocations are rounded up to power-of-two multiples of the
+ *        buddy allocator's minimum chunk size.  Each size class keeps a
+ *        free list owned by the calling thread, so an Alloc/Free pair
+ *        in steady state never takes BuddyAllocator::mutex_.  Empty
+ *        lists are refilled, and overfull lists are drained, in batches
+ *        through BuddyAllocator::AllocBatch/FreeBatch.
+ *
+ *        Every pointer returned by a ThreadCache is preceded by a small
+ *        header recording its size class, so it must be freed by a
+ *        ThreadCache (of any thread) sharing the same BuddyAllocator,
+ *        never by the BuddyAllocator directly.
+ */
+class ThreadCache {
+ public:
+  ThreadCache(BuddyAllocator* allocator, size_t max_cached_size);
+
+  // Return all cached blocks to the BuddyAllocator.
+  ~ThreadCache();
+
+  // Disable copy and assignment
+  ThreadCache(const ThreadCache&) = delete;
+  ThreadCache& operator=(const ThreadCache&) = delete;
+
+ public:
+  void* Alloc(size_t size);
+  void Free(void* ptr);
+
+  /*! \brief Total size of the free blocks kept by this cache */
+  size_t Cached() const { return cached_size_; }
+
+  /**
+   * \brief Alloc and Free bypassing the free lists, for a thread whose
+   *        cache is already destroyed.  The pointers are interchangeable
+   *        with those of any ThreadCache sharing allocator.
+   */
+  static void* AllocUncached(BuddyAllocator* allocator, size_t size);
+  static void FreeUncached(BuddyAllocator* allocator, void* ptr);
+
+ private:
+  struct FreeList {
+    size_t block_size;  // total size of each block in the buddy allocator
+    size_t batch;       // number of blocks moved per refill or drain
+    std::vector<void*> blocks;
+  };
+
+  /*! \brief Index of the smallest class holding size, or -1 if none */
+  int SizeClass(size_t size) const;
+
+  /*! \brief Fetch a batch of blocks from the BuddyAllocator */
+  void Refill(FreeList* list);
+
+  /*! \brief Give the oldest n blocks back to the BuddyAllocator */
+  void Drain(FreeList* list, size_t n);
+
+ private:
+  BuddyAllocator* allocator_;
+  std::vector<FreeList> lists_;
+  size_t cached_size_ = 0;
+};
+
+}  // namespace detail
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
@@ -0,0 +1,104 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Compares the Alloc/Free throughput of a BuddyAllocator used directly
+// and through per-thread ThreadCaches, for 1 to 8 threads.
+
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/memory/detail/thread_cache.h"
+#include "paddle/fluid/platform/cpu_info.h"
+
+DEFINE_int32(iterations, 100000, "Alloc/Free pairs per thread.");
+DECLARE_bool(use_pinned_memory);
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+namespace detail {
+
+// Each thread keeps a small window of live tensors of mixed sizes, the
+// way operators allocate outputs and temporaries, and reports the
+// aggregate Alloc/Free throughput.
+template <typename AllocFn, typename FreeFn>
+double AllocFreeThroughput(int num_threads,
+                           AllocFn alloc_fn,
+                           FreeFn free_fn) {
+  const int kWindow = 16;
+  const size_t kSizes[] = {256, 1000, 4096, 10000, 65536, 200000};
+
+  auto worker = [&](int thread_id) {
+    std::vector<void*> window(kWindow, nullptr);
+    for (int i = 0; i < FLAGS_iterations; ++i) {
+      int slot = (i * 7 + thread_id) % kWindow;
+      if (window[slot]) free_fn(window[slot]);
+      window[slot] = alloc_fn((i + thread_id) % 6 == 5
+                                  ? kSizes[5]
+                                  : kSizes[(i + thread_id) % 5]);
+    }
+    for (auto p : window) free_fn(p);
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) threads.emplace_back(worker, i);
+  for (auto& t : threads) t.join();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return num_threads * FLAGS_iterations / elapsed.count();
+}
+
+ThreadCache* LocalCache(BuddyAllocator* buddy) {
+  thread_local ThreadCache cache(buddy, 1 << 20);
+  return &cache;
+}
+
+void Run() {
+  FLAGS_use_pinned_memory = false;
+  std::unique_ptr<BuddyAllocator> buddy(
+      new BuddyAllocator(new CPUAllocator,
+                         platform::CpuMinChunkSize(),
+                         platform::CpuMaxChunkSize()));
+
+  std::cout << "threads\tbuddy (ops/s)\tthread cache (ops/s)\n";
+  for (int num_threads : {1, 2, 4, 8}) {
+    double direct = AllocFreeThroughput(
+        num_threads,
+        [&](size_t size) { return buddy->Alloc(size); },
+        [&](void* p) { buddy->Free(p); });
+
+    double cached = AllocFreeThroughput(
+        num_threads,
+        [&](size_t size) { return LocalCache(buddy.get())->Alloc(size); },
+        [&](void* p) { LocalCache(buddy.get())->Free(p); });
+
+    std::cout << num_threads << "\t" << direct << "\t" << cached << std::endl;
+  }
+}
+
+}  // namespace detail
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  paddle::fluid::memory::detail::Run();
+  return 0;
+}
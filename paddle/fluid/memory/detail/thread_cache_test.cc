@@ -0,0 +1,97 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/memory/detail/thread_cache.h"
+
+#include <cstring>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/cpu_info.h"
+
+DECLARE_bool(use_pinned_memory);
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+namespace detail {
+
+BuddyAllocator* NewCPUBuddyAllocator() {
+  FLAGS_use_pinned_memory = false;
+  return new BuddyAllocator(new CPUAllocator,
+                            platform::CpuMinChunkSize(),
+                            platform::CpuMaxChunkSize());
+}
+
+TEST(ThreadCache, AllocFree) {
+  std::unique_ptr<BuddyAllocator> buddy(NewCPUBuddyAllocator());
+  {
+    ThreadCache cache(buddy.get(), 1 << 20);
+    std::vector<void*> ps;
+    for (size_t size : {0, 1, 128, 4096, 65536, 1 << 20, 4 << 20}) {
+      void* p = cache.Alloc(size);
+      ASSERT_NE(p, nullptr);
+      EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 32, 0UL);
+      memset(p, 0xff, size);
+      ps.push_back(p);
+    }
+    for (auto p : ps) cache.Free(p);
+    EXPECT_GT(cache.Cached(), 0UL);
+
+    // A freed block is handed out again without touching the allocator.
+    size_t used = buddy->Used();
+    void* p = cache.Alloc(4096);
+    EXPECT_EQ(buddy->Used(), used);
+    cache.Free(p);
+  }
+  EXPECT_EQ(buddy->Used(), 0UL);
+}
+
+TEST(ThreadCache, CrossThreadFree) {
+  std::unique_ptr<BuddyAllocator> buddy(NewCPUBuddyAllocator());
+  std::vector<void*> ps;
+  std::thread producer([&] {
+    ThreadCache cache(buddy.get(), 1 << 20);
+    for (int i = 0; i < 1000; ++i) ps.push_back(cache.Alloc(i * 100));
+  });
+  producer.join();
+  std::thread consumer([&] {
+    ThreadCache cache(buddy.get(), 1 << 20);
+    for (auto p : ps) cache.Free(p);
+  });
+  consumer.join();
+  EXPECT_EQ(buddy->Used(), 0UL);
+}
+
+TEST(ThreadCache, Uncached) {
+  std::unique_ptr<BuddyAllocator> buddy(NewCPUBuddyAllocator());
+  {
+    ThreadCache cache(buddy.get(), 1 << 20);
+    void* cached = cache.Alloc(4096);
+    void* uncached = ThreadCache::AllocUncached(buddy.get(), 4096);
+    ASSERT_NE(uncached, nullptr);
+    memset(uncached, 0xff, 4096);
+    // Either kind of pointer is freed by either path.
+    ThreadCache::FreeUncached(buddy.get(), cached);
+    cache.Free(uncached);
+  }
+  EXPECT_EQ(buddy->Used(), 0UL);
+}
+
+}  // namespace detail
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
@@ -14,12 +14,46 @@ limitations under the License. */
 
 #include "paddle/fluid/memory/malloc.h"
 
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <memory>
+#include <vector>
+
+#include "gflags/gflags.h"
 #include "glog/logging.h"
 
+#include "paddle/fluid/memory/alloc_trace.h"
 #include "paddle/fluid/memory/detail/buddy_allocator.h"
 #include "paddle/fluid/memory/detail/system_allocator.h"
+#include "paddle/fluid/memory/detail/thread_cache.h"
+#include "paddle/fluid/platform/cpu_info.h"
 #include "paddle/fluid/platform/gpu_info.h"
 
+// The thread cache keeps freed CPU blocks in per-thread free lists, so
+// that steady-state Alloc/Free calls do not contend on the buddy
+// allocator's lock.  The flag is read once, at the first CPU
+// allocation, and changing it afterwards has no effect.
+DEFINE_bool(use_cpu_thread_cache,
+            false,
+            "If set, CPU allocations go through a per-thread cache.");
+DEFINE_uint64(cpu_thread_cache_max_size_in_kb,
+              1024,
+              "The largest block size kept in the per-thread CPU cache, in "
+              "KB unit. Larger allocations go to the buddy allocator.");
+// With NUMA, each node has its own CPU buddy allocator, and an
+// allocation goes to the node of the calling thread unless a node is
+// given explicitly.
+DEFINE_bool(use_numa_cpu_allocator,
+            false,
+            "If set, CPU memory is allocated from per-NUMA-node pools.");
+// The trace records every Alloc and Free call, to be replayed offline
+// against candidate allocators by alloc_trace_replay.  The flag is read
+// once, at the first allocation.
+DEFINE_string(alloc_trace_file,
+              "",
+              "If not empty, Alloc/Free calls are recorded to this file.");
+DECLARE_bool(use_huge_page_cpu_memory);
 DECLARE_double(fraction_of_gpu_memory_to_use);
 
 namespace paddle {
@@ -28,33 +62,202 @@ namespace memory {
 
 using BuddyAllocator = detail::BuddyAllocator;
 
-BuddyAllocator* GetCPUBuddyAllocator() {
-  static detail::BuddyAllocator* a = nullptr;
-  if (a == nullptr) {
-    a = new detail::BuddyAllocator(new detail::CPUAllocator,
-                                   platform::CpuMinChunkSize(),
-                                   platform::CpuMaxChunkSize());
+// Returns nullptr unless FLAGS_alloc_trace_file is set.  The writer is
+// never destroyed, as allocations may happen during static destruction,
+// and the events recorded until exit are flushed by an atexit handler.
+AllocTraceWriter* GetAllocTraceWriter() {
+  static AllocTraceWriter* writer = []() -> AllocTraceWriter* {
+    if (FLAGS_alloc_trace_file.empty()) return nullptr;
+    auto* writer = new AllocTraceWriter(FLAGS_alloc_trace_file);
+    atexit([] { GetAllocTraceWriter()->Flush(); });
+    return writer;
+  }();
+  return writer;
+}
+
+void TraceAlloc(const platform::Place& place, size_t size, void* p) {
+  auto* writer = GetAllocTraceWriter();
+  if (writer != nullptr) writer->RecordAlloc(place, size, p);
+}
+
+void TraceFree(const platform::Place& place, void* p) {
+  auto* writer = GetAllocTraceWriter();
+  if (writer != nullptr) writer->RecordFree(place, p);
+}
+
+bool UseNumaCPUAllocator() {
+  static bool use_numa = FLAGS_use_numa_cpu_allocator;
+  return use_numa;
+}
+
+// With NUMA, CPU pool i < NumaNodeCount() places its pages on node i
+// and the last pool interleaves them across all nodes.
+int CPUPoolCount() {
+  return UseNumaCPUAllocator() ? platform::NumaNodeCount() + 1 : 1;
+}
+
+detail::SystemAllocator* NewCPUSystemAllocator(int pool) {
+  if (UseNumaCPUAllocator()) {
+    int node = pool < platform::NumaNodeCount() ? pool : -1;
+    return new detail::NumaCPUAllocator(node);
+  }
+  if (FLAGS_use_huge_page_cpu_memory) {
+    return new detail::HugePageCPUAllocator;
+  }
+  return new detail::CPUAllocator;
+}
+
+BuddyAllocator* GetCPUBuddyAllocator(int pool = 0) {
+  static std::vector<BuddyAllocator*>* as = [] {
+    auto* as = new std::vector<BuddyAllocator*>;
+    for (int pool = 0; pool < CPUPoolCount(); ++pool) {
+      as->push_back(new BuddyAllocator(NewCPUSystemAllocator(pool),
+                                       platform::CpuMinChunkSize(),
+                                       platform::CpuMaxChunkSize()));
+    }
+    return as;
+  }();
+  return (*as)[pool];
+}
+
+bool UseCPUThreadCache() {
+  static bool use_cache = FLAGS_use_cpu_thread_cache;
+  return use_cache;
+}
+
+// The caches of a thread are owned through a pthread key rather than a
+// thread_local object, which may be destroyed before the destructors of
+// other thread_local objects that still free memory.  The key destructor
+// runs after all of them, flushes the caches to the buddy allocators,
+// and later calls of the exiting thread bypass the caches.
+using CPUThreadCaches = std::vector<std::unique_ptr<detail::ThreadCache>>;
+
+thread_local bool cpu_thread_caches_destroyed = false;
+
+void DestroyCPUThreadCaches(void* caches) {
+  cpu_thread_caches_destroyed = true;
+  delete static_cast<CPUThreadCaches*>(caches);
+}
+
+// Returns nullptr once the caches of the calling thread are destroyed.
+detail::ThreadCache* GetCPUThreadCache(int pool) {
+  static pthread_key_t key = [] {
+    pthread_key_t key;
+    PADDLE_ENFORCE_EQ(pthread_key_create(&key, DestroyCPUThreadCaches), 0);
+    return key;
+  }();
+  if (cpu_thread_caches_destroyed) return nullptr;
+
+  auto* caches = static_cast<CPUThreadCaches*>(pthread_getspecific(key));
+  if (caches == nullptr) {
+    caches = new CPUThreadCaches(CPUPoolCount());
+    PADDLE_ENFORCE_EQ(pthread_setspecific(key, caches), 0);
+  }
+  auto& cache = (*caches)[pool];
+  if (!cache) {
+    cache.reset(
+        new detail::ThreadCache(GetCPUBuddyAllocator(pool),
+                                FLAGS_cpu_thread_cache_max_size_in_kb << 10));
+  }
+  return cache.get();
+}
+
+void* AllocFromCPUPool(int pool, size_t size) {
+  if (!UseCPUThreadCache()) return GetCPUBuddyAllocator(pool)->Alloc(size);
+  auto* cache = GetCPUThreadCache(pool);
+  return cache != nullptr ? cache->Alloc(size)
+                          : detail::ThreadCache::AllocUncached(
+                                GetCPUBuddyAllocator(pool), size);
+}
+
+void FreeToCPUPool(int pool, void* p) {
+  if (!UseCPUThreadCache()) {
+    GetCPUBuddyAllocator(pool)->Free(p);
+    return;
+  }
+  auto* cache = GetCPUThreadCache(pool);
+  if (cache != nullptr) {
+    cache->Free(p);
+  } else {
+    detail::ThreadCache::FreeUncached(GetCPUBuddyAllocator(pool), p);
   }
-  return a;
 }
 
+// With NUMA, each CPU allocation is preceded by the index of its pool,
+// so that Free can find the pool.  32 bytes keep the alignment.
+constexpr size_t kNumaHeaderSize = 32;
+
 template <>
 void* Alloc<platform::CPUPlace>(platform::CPUPlace place, size_t size) {
+  if (UseNumaCPUAllocator()) {
+    return Alloc(place, size, platform::CurrentNumaNode());
+  }
   VLOG(10) << "Allocate " << size << " bytes on " << platform::Place(place);
-  void* p = GetCPUBuddyAllocator()->Alloc(size);
+  void* p = AllocFromCPUPool(0, size);
   VLOG(10) << "  pointer=" << p;
+  TraceAlloc(place, size, p);
   return p;
 }
 
+void* Alloc(platform::CPUPlace place, size_t size, int numa_node) {
+  if (!UseNumaCPUAllocator()) {
+    return Alloc(place, size);
+  }
+  VLOG(10) << "Allocate " << size << " bytes on " << platform::Place(place)
+           << " NUMA node " << numa_node;
+  int pool =
+      numa_node == kNumaInterleave ? platform::NumaNodeCount() : numa_node;
+  PADDLE_ENFORCE(pool >= 0 && pool < CPUPoolCount(),
+                 "NUMA node %d does not exist",
+                 numa_node);
+
+  auto* p =
+      static_cast<uint8_t*>(AllocFromCPUPool(pool, size + kNumaHeaderSize));
+  if (p == nullptr) {
+    TraceAlloc(place, size, nullptr);
+    return nullptr;
+  }
+  *reinterpret_cast<int*>(p) = pool;
+  VLOG(10) << "  pointer=" << p + kNumaHeaderSize;
+  TraceAlloc(place, size, p + kNumaHeaderSize);
+  return p + kNumaHeaderSize;
+}
+
 template <>
 void Free<platform::CPUPlace>(platform::CPUPlace place, void* p) {
   VLOG(10) << "Free pointer=" << p << " on " << platform::Place(place);
-  GetCPUBuddyAllocator()->Free(p);
+  TraceFree(place, p);
+  if (UseNumaCPUAllocator()) {
+    auto* header = static_cast<uint8_t*>(p) - kNumaHeaderSize;
+    FreeToCPUPool(*reinterpret_cast<int*>(header), header);
+  } else {
+    FreeToCPUPool(0, p);
+  }
 }
 
 template <>
 size_t Used<platform::CPUPlace>(platform::CPUPlace place) {
-  return GetCPUBuddyAllocator()->Used();
+  size_t used = 0;
+  for (int pool = 0; pool < CPUPoolCount(); ++pool) {
+    used += GetCPUBuddyAllocator(pool)->Used();
+  }
+  return used;
+}
+
+template <>
+MemoryStats Stats<platform::CPUPlace>(platform::CPUPlace place) {
+  MemoryStats stats;
+  for (int pool = 0; pool < CPUPoolCount(); ++pool) {
+    stats.Add(GetCPUBuddyAllocator(pool)->Stats());
+  }
+  return stats;
+}
+
+template <>
+void ResetStats<platform::CPUPlace>(platform::CPUPlace place) {
+  for (int pool = 0; pool < CPUPoolCount(); ++pool) {
+    GetCPUBuddyAllocator(pool)->ResetStats();
+  }
 }
 
 #ifdef PADDLE_WITH_CUDA
@@ -88,6 +291,16 @@ size_t Used<platform::CUDAPlace>(platform::CUDAPlace place) {
   return GetGPUBuddyAllocator(place.device)->Used();
 }
 
+template <>
+MemoryStats Stats<platform::CUDAPlace>(platform::CUDAPlace place) {
+  return GetGPUBuddyAllocator(place.device)->Stats();
+}
+
+template <>
+void ResetStats<platform::CUDAPlace>(platform::CUDAPlace place) {
+  GetGPUBuddyAllocator(place.device)->ResetStats();
+}
+
 template <>
 void* Alloc<platform::CUDAPlace>(platform::CUDAPlace place, size_t size) {
   auto* buddy_allocator = GetGPUBuddyAllocator(place.device);
@@ -105,11 +318,13 @@ void* Alloc<platform::CUDAPlace>(platform::CUDAPlace place, size_t size) {
     LOG(WARNING) << "GPU memory used: " << Used<platform::CUDAPlace>(place);
     platform::SetDeviceId(cur_dev);
   }
+  TraceAlloc(place, size, ptr);
   return ptr;
 }
 
 template <>
 void Free<platform::CUDAPlace>(platform::CUDAPlace place, void* p) {
+  TraceFree(place, p);
   GetGPUBuddyAllocator(place.device)->Free(p);
 }
 
@@ -128,6 +343,16 @@ size_t Used<platform::CUDAPinnedPlace>(platform::CUDAPinnedPlace place) {
   return GetCUDAPinnedBuddyAllocator()->Used();
 }
 
+template <>
+MemoryStats Stats<platform::CUDAPinnedPlace>(platform::CUDAPinnedPlace place) {
+  return GetCUDAPinnedBuddyAllocator()->Stats();
+}
+
+template <>
+void ResetStats<platform::CUDAPinnedPlace>(platform::CUDAPinnedPlace place) {
+  GetCUDAPinnedBuddyAllocator()->ResetStats();
+}
+
 template <>
 void* Alloc<platform::CUDAPinnedPlace>(platform::CUDAPinnedPlace place,
                                        size_t size) {
@@ -138,11 +363,13 @@ void* Alloc<platform::CUDAPinnedPlace>(platform::CUDAPinnedPlace place,
     LOG(WARNING) << "cudaMallocHost Cannot allocate " << size
                  << " bytes in CUDAPinnedPlace";
   }
+  TraceAlloc(place, size, ptr);
   return ptr;
 }
 
 template <>
 void Free<platform::CUDAPinnedPlace>(platform::CUDAPinnedPlace place, void* p) {
+  TraceFree(place, p);
   GetCUDAPinnedBuddyAllocator()->Free(p);
 }
 #endif
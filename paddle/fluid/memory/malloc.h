@@ -14,6 +14,7 @@ limitations under the License. */
 
 #pragma once
 
+#include "paddle/fluid/memory/memory_stats.h"
 #include "paddle/fluid/platform/place.h"
 
 namespace paddle {
@@ -36,6 +37,23 @@ namespace memory {
 template <typename Place>
 void* Alloc(Place place, size_t size);
 
+//! Interleave the pages of an allocation across all NUMA nodes.
+constexpr int kNumaInterleave = -1;
+
+/**
+ * \brief   Allocate CPU memory on one NUMA node.
+ *
+ * \param[in]  place      Allocation place.
+ * \param[in]  size       Allocation size.
+ * \param[in]  numa_node  NUMA node, or kNumaInterleave for large tensors
+ *                        shared by threads on all nodes, e.g., parameters.
+ *
+ * \note    Alloc(place, size) uses the node of the calling thread.  If
+ *          FLAGS_use_numa_cpu_allocator is not set, numa_node is ignored.
+ *          The memory is freed by Free(place, ptr) as usual.
+ */
+void* Alloc(platform::CPUPlace place, size_t size, int numa_node);
+
 /**
  * \brief   Free memory block in one place.
  *
@@ -55,6 +73,28 @@ void Free(Place place, void* ptr);
 template <typename Place>
 size_t Used(Place place);
 
+/**
+ * \brief   Statistics of the allocator in one place.
+ *
+ * \param[in]  place  Allocation place (CPU or GPU).
+ *
+ * \note    Counters are maintained while holding the allocator lock,
+ *          so they are cheap enough to leave on.  Blocks kept by the
+ *          per-thread CPU cache count as used.
+ */
+template <typename Place>
+MemoryStats Stats(Place place);
+
+/**
+ * \brief   Reset the counters, the histogram and the peak usage of the
+ *          allocator in one place, e.g., at the beginning of each
+ *          training step.
+ *
+ * \param[in]  place  Allocation place (CPU or GPU).
+ */
+template <typename Place>
+void ResetStats(Place place);
+
 struct Usage : public boost::static_visitor<size_t> {
   size_t operator()(const platform::CPUPlace& cpu) const;
   size_t operator()(const platform::CUDAPlace& gpu) const;
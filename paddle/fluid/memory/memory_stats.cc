@@ -0,0 +1,76 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/memory/memory_stats.h"
+
+#include <algorithm>
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+
+constexpr int MemoryStats::kNumSizeBuckets;
+
+void MemoryStats::Add(const MemoryStats& other) {
+  used += other.used;
+  huge_used += other.huge_used;
+  peak_used += other.peak_used;
+  reserved += other.reserved;
+  free += other.free;
+  largest_free_block = std::max(largest_free_block, other.largest_free_block);
+  num_chunks += other.num_chunks;
+  num_free_blocks += other.num_free_blocks;
+  num_allocs += other.num_allocs;
+  num_frees += other.num_frees;
+  num_splits += other.num_splits;
+  num_merges += other.num_merges;
+  num_huge_allocs += other.num_huge_allocs;
+  num_refills += other.num_refills;
+  num_lock_contentions += other.num_lock_contentions;
+  lock_wait_ns += other.lock_wait_ns;
+  for (int i = 0; i < kNumSizeBuckets; ++i) {
+    size_histogram[i] += other.size_histogram[i];
+  }
+}
+
+std::ostream& operator<<(std::ostream& os, const MemoryStats& stats) {
+  os << "used: " << stats.used << ", huge_used: " << stats.huge_used
+     << ", peak_used: " << stats.peak_used << ", reserved: " << stats.reserved
+     << ", free: " << stats.free
+     << ", largest_free_block: " << stats.largest_free_block
+     << ", fragmentation: " << stats.fragmentation()
+     << ", num_chunks: " << stats.num_chunks
+     << ", num_free_blocks: " << stats.num_free_blocks
+     << ", num_allocs: " << stats.num_allocs
+     << ", num_frees: " << stats.num_frees
+     << ", num_splits: " << stats.num_splits
+     << ", num_merges: " << stats.num_merges
+     << ", num_huge_allocs: " << stats.num_huge_allocs
+     << ", num_refills: " << stats.num_refills
+     << ", num_lock_contentions: " << stats.num_lock_contentions
+     << ", lock_wait_ns: " << stats.lock_wait_ns << ", size_histogram: {";
+  bool first = true;
+  for (int i = 0; i < MemoryStats::kNumSizeBuckets; ++i) {
+    if (stats.size_histogram[i] == 0) continue;
+    if (!first) os << ", ";
+    os << (1UL << i) << ": " << stats.size_histogram[i];
+    first = false;
+  }
+  os << "}";
+  return os;
+}
+
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
@@ -0,0 +1,75 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint64_t
+
+#include <ostream>
+
+namespace paddle {
+namespace fluid {
+namespace memory {
+
+/**
+ * \brief   Statistics of the allocator of one place.
+ *
+ * \note    Sizes are in bytes and include the rounding to chunk sizes.
+ *          Counters and the histogram cover the period since the last
+ *          ResetStats; the other fields are current values.
+ */
+struct MemoryStats {
+  // Bucket i counts requests of [2^i, 2^(i+1)) bytes; bucket 0 also
+  // counts empty requests, and the last bucket everything above.
+  static constexpr int kNumSizeBuckets = 40;
+
+  size_t used = 0;       // held by users, excluding huge allocations
+  size_t huge_used = 0;  // huge allocations sent to the system allocator
+  size_t peak_used = 0;  // peak of used + huge_used
+  size_t reserved = 0;   // held from the system allocator in the pool
+  size_t free = 0;       // reserved but not used
+  size_t largest_free_block = 0;
+
+  size_t num_chunks = 0;       // chunks held from the system allocator
+  size_t num_free_blocks = 0;  // blocks in the pool
+
+  size_t num_allocs = 0;
+  size_t num_frees = 0;
+  size_t num_splits = 0;
+  size_t num_merges = 0;
+  size_t num_huge_allocs = 0;  // requests too large for a chunk
+  size_t num_refills = 0;      // chunks requested from the system allocator
+
+  size_t num_lock_contentions = 0;  // acquisitions that had to wait
+  uint64_t lock_wait_ns = 0;        // total time spent waiting
+
+  size_t size_histogram[kNumSizeBuckets] = {0};
+
+  /*! \brief Accumulate the stats of another allocator; peak_used becomes
+   *         the sum of the peaks, an upper bound of the combined peak. */
+  void Add(const MemoryStats& other);
+
+  /*! \brief 0 if all free memory is one block, close to 1 if scattered */
+  double fragmentation() const {
+    return free == 0 ? 0.0 : 1.0 - static_cast<double>(largest_free_block) /
+                                       static_cast<double>(free);
+  }
+};
+
+std::ostream& operator<<(std::ostream& os, const MemoryStats& stats);
+
+}  // namespace memory
+}  // namespace fluid
+}  // namespace paddle
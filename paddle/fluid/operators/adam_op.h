@@ -285,8 +285,9 @@ class AdamOpKernel : public framework::OpKernel<T> {
           Ref(ctx.Input<framework::SelectedRows>("Grad"), "Must set Grad");
       // merge duplicated rows if any.
       scatter::MergeAdd<DeviceContext, T> merge_func;
-      auto grad_merge =
-          merge_func(ctx.template device_context<DeviceContext>(), grad);
+      auto grad_merge = merge_func(
+          ctx.template device_context<DeviceContext>(), grad,
+          ctx.scratch_arena());
       auto& grad_tensor = grad_merge.value();
       const T* grad_data = grad_tensor.template data<T>();
       int64_t* rows = nullptr;
@@ -16,6 +16,7 @@ limitations under the License. */
 #include <vector>
 
 #include "paddle/fluid/framework/math/math_function.h"
+#include "paddle/fluid/framework/tensor_view.h"
 #include "paddle/fluid/operators/math/selected_rows_functor.h"
 
 namespace paddle {
@@ -143,6 +144,14 @@ struct SelectedRowsAddTo<platform::CPUDeviceContext, T> {
                  in2_data + input2_offset,
                  boost::get<platform::CPUPlace>(in1_place), in1_data,
                  in1_value.numel() * sizeof(T));
+
+    if (in1_rows.size() > 0 && in1_value.numel() > 0) {
+      int64_t row_numel = in1_value.numel() / in1_rows.size();
+      int64_t begin = input2_offset / row_numel;
+      for (size_t i = 0; i < in1_rows.size(); ++i) {
+        input2->MarkDirty(begin + static_cast<int64_t>(i));
+      }
+    }
   }
 };
 
@@ -198,30 +207,37 @@ size_t FindPos(const std::vector<int64_t>& rows, int64_t value) {
 template <typename T>
 struct MergeAdd<platform::CPUDeviceContext, T> {
   framework::SelectedRows operator()(const platform::CPUDeviceContext& context,
-                                     const framework::SelectedRows& input) {
+                                     const framework::SelectedRows& input,
+                                     framework::ScratchArena* arena) {
     framework::SelectedRows out;
-    auto input_rows = input.rows();
+    auto& input_rows = input.rows();
     std::set<int64_t> row_set(input_rows.begin(), input_rows.end());
     std::vector<int64_t> merge_rows(row_set.begin(), row_set.end());
 
     auto input_width = input.value().dims()[1];
     out.set_rows(merge_rows);
     out.set_height(input.height());
-    out.mutable_value()->mutable_data<T>(
-        framework::make_ddim(
-            {static_cast<int64_t>(merge_rows.size()), input_width}),
-        context.GetPlace());
+    auto out_dims = framework::make_ddim(
+        {static_cast<int64_t>(merge_rows.size()), input_width});
+    if (arena != nullptr) {
+      arena->AllocTensor<T>(out_dims, out.mutable_value());
+    } else {
+      out.mutable_value()->mutable_data<T>(out_dims, context.GetPlace());
+    }
 
     framework::math::SetConstant<platform::CPUDeviceContext, T> constant_functor;
     constant_functor(context, out.mutable_value(), 0.0);
 
-    auto* out_data = out.mutable_value()->data<T>();
-    auto* input_data = input.value().data<T>();
+    framework::TensorView<T, 2> out_view(out.mutable_value());
+    framework::TensorView<const T, 2> input_view(input.value());
 
+    // The input may be a strided view, e.g., a transposed tensor.
+    int64_t input_stride = framework::get<1>(input_view.strides());
     for (size_t i = 0; i < input_rows.size(); i++) {
-      size_t out_i = FindPos(merge_rows, input_rows[i]);
+      T* out_row = out_view.row(FindPos(merge_rows, input_rows[i]));
+      const T* input_row = input_view.row(i);
       for (int64_t j = 0; j < input_width; j++) {
-        out_data[out_i * input_width + j] += input_data[i * input_width + j];
+        out_row[j] += input_row[j * input_stride];
       }
     }
     return out;
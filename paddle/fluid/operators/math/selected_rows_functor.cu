@@ -172,6 +172,14 @@ struct SelectedRowsAddTo<platform::CUDADeviceContext, T> {
                  in2_data + input2_offset,
                  boost::get<platform::CUDAPlace>(in1_place), in1_data,
                  in1_value.numel() * sizeof(T), context.stream());
+
+    if (in1_rows.size() > 0 && in1_value.numel() > 0) {
+      int64_t row_numel = in1_value.numel() / in1_rows.size();
+      int64_t begin = input2_offset / row_numel;
+      for (size_t i = 0; i < in1_rows.size(); ++i) {
+        input2->MarkDirty(begin + static_cast<int64_t>(i));
+      }
+    }
   }
 };
 
@@ -262,7 +270,8 @@ __global__ void MergeAddKernel(const T* input, const int64_t* input_rows,
 template <typename T>
 struct MergeAdd<platform::CUDADeviceContext, T> {
   framework::SelectedRows operator()(const platform::CUDADeviceContext& context,
-                                     const framework::SelectedRows& input) {
+                                     const framework::SelectedRows& input,
+                                     framework::ScratchArena* arena) {
     framework::SelectedRows out;
     framework::Vector<int64_t> input_rows(input.rows());
     std::set<int64_t> row_set(input_rows.begin(), input_rows.end());
@@ -272,10 +281,13 @@ struct MergeAdd<platform::CUDADeviceContext, T> {
 
     out.set_rows(merge_rows);
     out.set_height(input.height());
-    out.mutable_value()->mutable_data<T>(
-        framework::make_ddim(
-            {static_cast<int64_t>(merge_rows.size()), input_width}),
-        context.GetPlace());
+    auto out_dims = framework::make_ddim(
+        {static_cast<int64_t>(merge_rows.size()), input_width});
+    if (arena != nullptr) {
+      arena->AllocTensor<T>(out_dims, out.mutable_value());
+    } else {
+      out.mutable_value()->mutable_data<T>(out_dims, context.GetPlace());
+    }
 
     framework::math::SetConstant<platform::CUDADeviceContext, T> constant_functor;
     constant_functor(context, out.mutable_value(), 0.0);
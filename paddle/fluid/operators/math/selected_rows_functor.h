@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 #pragma once
 #include "paddle/fluid/framework/eigen.h"
+#include "paddle/fluid/framework/scratch_arena.h"
 #include "paddle/fluid/framework/selected_rows.h"
 #include "paddle/fluid/platform/device_context.h"
 
@@ -63,9 +64,12 @@ namespace scatter {
 template <typename DeviceContext, typename T>
 struct MergeAdd {
   // unary functor, merge by adding duplicated rows in
-  // the input SelectedRows object.
+  // the input SelectedRows object. If arena is not null, the value of
+  // the result is allocated from it, e.g., a kernel's scratch arena
+  // when the result is a temporary of the kernel.
   framework::SelectedRows operator()(const DeviceContext& context,
-                                     const framework::SelectedRows& input);
+                                     const framework::SelectedRows& input,
+                                     framework::ScratchArena* arena = nullptr);
 };
 
 template <typename DeviceContext, typename T>
@@ -219,3 +219,108 @@ TEST(selected_rows_functor, cpu_add_to) {
   // row9: 2.0 + 3.0
   EXPECT_EQ(tensor1_data[9 * row_numel + 6], 5.0);
 }
+
+TEST(selected_rows_functor, cpu_add_to_tensor_lazy_copy) {
+  paddle::fluid::platform::CPUPlace cpu_place;
+  paddle::fluid::platform::CPUDeviceContext ctx(cpu_place);
+  paddle::fluid::framework::math::SetConstant<paddle::fluid::platform::CPUDeviceContext,
+                                       float>
+      functor;
+  int64_t height = 10;
+  int64_t row_numel = 10;
+
+  std::vector<int64_t> rows{0, 4, 7};
+  paddle::fluid::framework::SelectedRows selected_rows(rows, height);
+  auto* value = selected_rows.mutable_value();
+  value->mutable_data<float>(
+      paddle::fluid::framework::make_ddim(
+          {static_cast<int64_t>(rows.size()), row_numel}),
+      cpu_place);
+  functor(ctx, value, 1.0);
+
+  paddle::fluid::framework::Tensor source;
+  source.mutable_data<float>(
+      paddle::fluid::framework::make_ddim({height, row_numel}), cpu_place);
+  functor(ctx, &source, 3.0);
+  const float* source_data = source.data<float>();
+
+  // The kernel writes the copy through data<T>(), which copies the block.
+  paddle::fluid::framework::Tensor copy;
+  copy.CopyOnWriteFrom(source);
+  paddle::fluid::operators::math::SelectedRowsAddToTensor<
+      paddle::fluid::platform::CPUDeviceContext, float>
+      add_to_tensor_functor;
+  add_to_tensor_functor(ctx, selected_rows, &copy);
+
+  const auto& const_copy = copy;
+  EXPECT_NE(const_copy.data<float>(), source_data);
+  EXPECT_EQ(const_copy.data<float>()[4 * row_numel + 6], 4.0);
+  EXPECT_EQ(const_copy.data<float>()[5 * row_numel + 6], 3.0);
+  EXPECT_EQ(source_data[4 * row_numel + 6], 3.0);
+}
+
+TEST(selected_rows_functor, cpu_merge_add_scratch) {
+  paddle::fluid::platform::CPUPlace cpu_place;
+  paddle::fluid::platform::CPUDeviceContext ctx(cpu_place);
+  paddle::fluid::framework::math::SetConstant<paddle::fluid::platform::CPUDeviceContext,
+                                       float>
+      functor;
+  int64_t height = 10;
+  int64_t row_numel = 10;
+
+  std::vector<int64_t> rows{0, 4, 0, 7};
+  paddle::fluid::framework::SelectedRows input(rows, height);
+  input.mutable_value()->mutable_data<float>(
+      paddle::fluid::framework::make_ddim(
+          {static_cast<int64_t>(rows.size()), row_numel}),
+      cpu_place);
+  functor(ctx, input.mutable_value(), 1.0);
+
+  auto* arena = paddle::fluid::framework::GetThreadScratchArena(cpu_place);
+  paddle::fluid::framework::ScratchArenaGuard guard(arena);
+  size_t used = arena->Used();
+  paddle::fluid::operators::math::scatter::MergeAdd<
+      paddle::fluid::platform::CPUDeviceContext, float>
+      merge_add_functor;
+  auto output = merge_add_functor(ctx, input, arena);
+  EXPECT_GE(arena->Used(), used + 3 * row_numel * sizeof(float));
+
+  EXPECT_EQ(output.rows().size(), 3UL);
+  auto* out_data = output.value().data<float>();
+  EXPECT_EQ(out_data[0 * row_numel + 5], 2.0);
+  EXPECT_EQ(out_data[1 * row_numel + 5], 1.0);
+  EXPECT_EQ(out_data[2 * row_numel + 5], 1.0);
+}
+
+TEST(selected_rows_functor, cpu_merge_add_strided) {
+  paddle::fluid::platform::CPUPlace cpu_place;
+  paddle::fluid::platform::CPUDeviceContext ctx(cpu_place);
+  int64_t height = 10;
+  int64_t row_numel = 10;
+
+  // The value is the transpose of a [row_numel, 4] tensor, so its
+  // elements along a row are 4 apart.
+  std::vector<int64_t> rows{0, 4, 0, 7};
+  paddle::fluid::framework::Tensor columns;
+  auto* columns_data = columns.mutable_data<float>(
+      paddle::fluid::framework::make_ddim({row_numel, 4}), cpu_place);
+  for (int64_t j = 0; j < row_numel; ++j) {
+    for (int64_t i = 0; i < 4; ++i) columns_data[j * 4 + i] = i + 1;
+  }
+  paddle::fluid::framework::SelectedRows input(rows, height);
+  *input.mutable_value() = columns.Transpose({1, 0});
+  ASSERT_FALSE(input.value().IsContiguous());
+
+  paddle::fluid::operators::math::scatter::MergeAdd<
+      paddle::fluid::platform::CPUDeviceContext, float>
+      merge_add_functor;
+  auto output = merge_add_functor(ctx, input, nullptr);
+
+  EXPECT_EQ(output.rows().size(), 3UL);
+  auto* out_data = output.value().data<float>();
+  for (int64_t j = 0; j < row_numel; ++j) {
+    EXPECT_EQ(out_data[0 * row_numel + j], 4.0);
+    EXPECT_EQ(out_data[1 * row_numel + j], 2.0);
+    EXPECT_EQ(out_data[2 * row_numel + j], 4.0);
+  }
+}
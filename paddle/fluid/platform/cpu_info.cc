@@ -18,10 +18,15 @@ limitations under the License. */
 #include <sys/sysctl.h>
 #include <sys/types.h>
 #else
+#include <sched.h>
 #include <unistd.h>
 #endif
 
 #include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "gflags/gflags.h"
 
 DEFINE_double(fraction_of_cpu_memory_to_use,
@@ -95,6 +100,74 @@ size_t CUDAPinnedMaxChunkSize() {
   return CUDAPinnedMaxAllocSize() / 256;
 }
 
+namespace {
+
+// Parses a sysfs list like "0-3,8-11".
+std::vector<int> ParseSysfsList(std::istream& is) {
+  std::vector<int> items;
+  std::string range;
+  while (std::getline(is, range, ',')) {
+    std::istringstream range_is(range);
+    int first = 0, last = 0;
+    char dash = 0;
+    if (!(range_is >> first)) continue;
+    if (!(range_is >> dash >> last)) last = first;
+    for (int item = first; item <= last; ++item) items.push_back(item);
+  }
+  return items;
+}
+
+// The NUMA node of each CPU, read once from sysfs.
+struct NumaTopology {
+  int num_nodes = 1;
+  std::vector<int> node_of_cpu;
+
+  NumaTopology() {
+#ifdef __linux__
+    // Node ids may have holes, e.g., after memory hot-remove, so they
+    // are listed rather than probed until the first missing one.
+    std::ifstream nodelist("/sys/devices/system/node/online");
+    if (!nodelist) nodelist.open("/sys/devices/system/node/possible");
+    if (!nodelist) return;
+    for (int node : ParseSysfsList(nodelist)) {
+      num_nodes = std::max(num_nodes, node + 1);
+
+      std::ifstream cpulist("/sys/devices/system/node/node" +
+                            std::to_string(node) + "/cpulist");
+      for (int cpu : ParseSysfsList(cpulist)) {
+        if (static_cast<int>(node_of_cpu.size()) <= cpu) {
+          node_of_cpu.resize(cpu + 1, 0);
+        }
+        node_of_cpu[cpu] = node;
+      }
+    }
+#endif
+  }
+};
+
+const NumaTopology& GetNumaTopology() {
+  static NumaTopology topology;
+  return topology;
+}
+
+}  // namespace
+
+int NumaNodeCount() { return GetNumaTopology().num_nodes; }
+
+int NumaNodeOfCpu(int cpu) {
+  auto& node_of_cpu = GetNumaTopology().node_of_cpu;
+  if (cpu < 0 || cpu >= static_cast<int>(node_of_cpu.size())) return 0;
+  return node_of_cpu[cpu];
+}
+
+int CurrentNumaNode() {
+#ifdef __linux__
+  return NumaNodeOfCpu(sched_getcpu());
+#else
+  return 0;
+#endif
+}
+
 }  // namespace platform
 }  // namespace fluid
 }  // namespace paddle
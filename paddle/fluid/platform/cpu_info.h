@@ -38,6 +38,15 @@ size_t CUDAPinnedMinChunkSize();
 //! Get the maximum chunk size for buddy allocator.
 size_t CUDAPinnedMaxChunkSize();
 
+//! Get one more than the largest online NUMA node id, or 1 without NUMA.
+int NumaNodeCount();
+
+//! Get the NUMA node of a CPU.
+int NumaNodeOfCpu(int cpu);
+
+//! Get the NUMA node of the CPU the calling thread is running on.
+int CurrentNumaNode();
+
 }  // namespace platform
 }  // namespace fluid
 }  // namespace paddle
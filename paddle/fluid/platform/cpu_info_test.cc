@@ -35,3 +35,14 @@ TEST(CpuMemoryUsage, Print) {
                    memory_size)
             << std::endl;
 }
+
+TEST(CpuInfo, NumaTopology) {
+  int num_nodes = paddle::fluid::platform::NumaNodeCount();
+  EXPECT_GE(num_nodes, 1);
+
+  int node = paddle::fluid::platform::CurrentNumaNode();
+  EXPECT_GE(node, 0);
+  EXPECT_LT(node, num_nodes);
+  std::cout << "NUMA nodes: " << num_nodes << ", current node: " << node
+            << std::endl;
+}
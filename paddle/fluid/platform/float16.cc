@@ -0,0 +1,235 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/float16.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PADDLE_FLOAT16_WITH_X86_KERNELS
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace paddle {
+namespace fluid {
+namespace platform {
+
+static_assert(sizeof(float16) == 2 && std::is_pod<float16>::value,
+              "float16 must be a 2-byte POD");
+static_assert(sizeof(bfloat16) == 2 && std::is_pod<bfloat16>::value,
+              "bfloat16 must be a 2-byte POD");
+
+namespace {
+
+// The scalar conversions finish the tails of the vector kernels, so
+// every element of a tensor rounds the same way.
+void FloatToHalfScalar(const float* in, float16* out, size_t n) {
+  for (size_t i = 0; i < n; ++i) out[i] = float16(in[i]);
+}
+
+void HalfToFloatScalar(const float16* in, float* out, size_t n) {
+  for (size_t i = 0; i < n; ++i) out[i] = static_cast<float>(in[i]);
+}
+
+void FloatToBFloat16Scalar(const float* in, bfloat16* out, size_t n) {
+  for (size_t i = 0; i < n; ++i) out[i] = bfloat16(in[i]);
+}
+
+void BFloat16ToFloatScalar(const bfloat16* in, float* out, size_t n) {
+  for (size_t i = 0; i < n; ++i) out[i] = static_cast<float>(in[i]);
+}
+
+#ifdef PADDLE_FLOAT16_WITH_X86_KERNELS
+
+// The kernels are compiled for their instruction sets whatever the
+// compiler flags are, and picked by the CPU at runtime.
+
+__attribute__((target("avx,f16c"))) void FloatToHalfF16C(const float* in,
+                                                         float16* out,
+                                                         size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 v = _mm256_loadu_ps(in + i);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+  }
+  FloatToHalfScalar(in + i, out + i, n - i);
+}
+
+__attribute__((target("avx,f16c"))) void HalfToFloatF16C(const float16* in,
+                                                         float* out,
+                                                         size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    _mm256_storeu_ps(out + i, _mm256_cvtph_ps(v));
+  }
+  HalfToFloatScalar(in + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void FloatToHalfAVX512(const float* in,
+                                                          float16* out,
+                                                          size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 v = _mm512_loadu_ps(in + i);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+  }
+  FloatToHalfScalar(in + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void HalfToFloatAVX512(const float16* in,
+                                                          float* out,
+                                                          size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    _mm512_storeu_ps(out + i, _mm512_cvtph_ps(v));
+  }
+  HalfToFloatScalar(in + i, out + i, n - i);
+}
+
+// bits + 0x7fff + lsb rounds to nearest even; NaNs are quieted instead.
+__attribute__((target("avx2"))) void FloatToBFloat16AVX2(const float* in,
+                                                         bfloat16* out,
+                                                         size_t n) {
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i bias = _mm256_set1_epi32(0x7fff);
+  const __m256i quiet = _mm256_set1_epi32(0x40);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 v = _mm256_loadu_ps(in + i);
+    __m256i bits = _mm256_castps_si256(v);
+    __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16), one);
+    __m256i rounded = _mm256_srli_epi32(
+        _mm256_add_epi32(bits, _mm256_add_epi32(bias, lsb)), 16);
+    __m256i nan = _mm256_or_si256(_mm256_srli_epi32(bits, 16), quiet);
+    __m256i is_nan = _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+    __m256i result = _mm256_blendv_epi8(rounded, nan, is_nan);
+    // Pack the low halves of the 32-bit lanes into 8 16-bit elements.
+    __m256i packed = _mm256_permute4x64_epi64(
+        _mm256_packus_epi32(result, result), 0xd8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm256_castsi256_si128(packed));
+  }
+  FloatToBFloat16Scalar(in + i, out + i, n - i);
+}
+
+__attribute__((target("avx2"))) void BFloat16ToFloatAVX2(const bfloat16* in,
+                                                         float* out,
+                                                         size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m256i bits = _mm256_slli_epi32(_mm256_cvtepu16_epi32(v), 16);
+    _mm256_storeu_ps(out + i, _mm256_castsi256_ps(bits));
+  }
+  BFloat16ToFloatScalar(in + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void FloatToBFloat16AVX512(const float* in,
+                                                             bfloat16* out,
+                                                             size_t n) {
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i bias = _mm512_set1_epi32(0x7fff);
+  const __m512i quiet = _mm512_set1_epi32(0x40);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 v = _mm512_loadu_ps(in + i);
+    __m512i bits = _mm512_castps_si512(v);
+    __m512i lsb = _mm512_and_si512(_mm512_srli_epi32(bits, 16), one);
+    __m512i rounded = _mm512_srli_epi32(
+        _mm512_add_epi32(bits, _mm512_add_epi32(bias, lsb)), 16);
+    __mmask16 is_nan = _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q);
+    __m512i result = _mm512_mask_or_epi32(
+        rounded, is_nan, _mm512_srli_epi32(bits, 16), quiet);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                        _mm512_cvtepi32_epi16(result));
+  }
+  FloatToBFloat16Scalar(in + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f"))) void BFloat16ToFloatAVX512(
+    const bfloat16* in, float* out, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    __m512i bits = _mm512_slli_epi32(_mm512_cvtepu16_epi32(v), 16);
+    _mm512_storeu_ps(out + i, _mm512_castsi512_ps(bits));
+  }
+  BFloat16ToFloatScalar(in + i, out + i, n - i);
+}
+
+#endif  // PADDLE_FLOAT16_WITH_X86_KERNELS
+
+template <typename In, typename Out>
+using Kernel = void (*)(const In*, Out*, size_t);
+
+struct Kernels {
+  Kernel<float, float16> float_to_half = FloatToHalfScalar;
+  Kernel<float16, float> half_to_float = HalfToFloatScalar;
+  Kernel<float, bfloat16> float_to_bfloat16 = FloatToBFloat16Scalar;
+  Kernel<bfloat16, float> bfloat16_to_float = BFloat16ToFloatScalar;
+
+  Kernels() {
+#ifdef PADDLE_FLOAT16_WITH_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+      float_to_half = FloatToHalfAVX512;
+      half_to_float = HalfToFloatAVX512;
+      float_to_bfloat16 = FloatToBFloat16AVX512;
+      bfloat16_to_float = BFloat16ToFloatAVX512;
+      return;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+      float_to_bfloat16 = FloatToBFloat16AVX2;
+      bfloat16_to_float = BFloat16ToFloatAVX2;
+    }
+    // F16C is not a feature __builtin_cpu_supports knows.
+    unsigned eax, ebx, ecx, edx;
+    if (__builtin_cpu_supports("avx") && __get_cpuid(1, &eax, &ebx, &ecx, &edx) &&
+        (ecx & bit_F16C)) {
+      float_to_half = FloatToHalfF16C;
+      half_to_float = HalfToFloatF16C;
+    }
+#endif
+  }
+};
+
+const Kernels& GetKernels() {
+  static Kernels kernels;
+  return kernels;
+}
+
+}  // namespace
+
+void FloatToHalf(const float* in, float16* out, size_t n) {
+  GetKernels().float_to_half(in, out, n);
+}
+
+void HalfToFloat(const float16* in, float* out, size_t n) {
+  GetKernels().half_to_float(in, out, n);
+}
+
+void FloatToBFloat16(const float* in, bfloat16* out, size_t n) {
+  GetKernels().float_to_bfloat16(in, out, n);
+}
+
+void BFloat16ToFloat(const bfloat16* in, float* out, size_t n) {
+  GetKernels().bfloat16_to_float(in, out, n);
+}
+
+}  // namespace platform
+}  // namespace fluid
+}  // namespace paddle
@@ -0,0 +1,241 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <type_traits>
+
+#include "paddle/fluid/platform/hostdevice.h"
+
+namespace paddle {
+namespace fluid {
+namespace platform {
+
+namespace details {
+
+HOSTDEVICE inline uint32_t FloatToBits(float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  return bits;
+}
+
+HOSTDEVICE inline float BitsToFloat(uint32_t bits) {
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+// Rounds to nearest even, as F16C does.  NaNs are quieted and keep the
+// high bits of their payload.
+HOSTDEVICE inline uint16_t FloatToHalfBits(float f) {
+  uint32_t bits = FloatToBits(f);
+  uint32_t sign = (bits >> 16) & 0x8000;
+  uint32_t abs = bits & 0x7fffffff;
+  if (abs > 0x7f800000) {  // NaN
+    return static_cast<uint16_t>(sign | 0x7e00 | ((abs >> 13) & 0x3ff));
+  }
+  if (abs >= 0x477ff000) {  // rounds to infinity, 65520 included
+    return static_cast<uint16_t>(sign | 0x7c00);
+  }
+  if (abs >= 0x38800000) {  // a normal half
+    uint32_t odd = (abs >> 13) & 1;
+    // Rebias the exponent from 127 to 15, and round the 13 dropped bits.
+    abs = abs - 0x38000000 + 0xfff + odd;
+    return static_cast<uint16_t>(sign | (abs >> 13));
+  }
+  // A subnormal half, in units of 2^-24.
+  int shift = 126 - static_cast<int>(abs >> 23);
+  if (shift > 24) return static_cast<uint16_t>(sign);
+  uint32_t mantissa = (abs & 0x7fffff) | 0x800000;
+  uint32_t half = mantissa >> shift;
+  uint32_t rest = mantissa & ((1u << shift) - 1);
+  uint32_t tie = 1u << (shift - 1);
+  if (rest > tie || (rest == tie && (half & 1))) ++half;
+  return static_cast<uint16_t>(sign | half);
+}
+
+// Exact.  Signaling NaNs are quieted, as F16C does.
+HOSTDEVICE inline float HalfBitsToFloat(uint16_t h) {
+  uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+  uint32_t exponent = (h >> 10) & 0x1f;
+  uint32_t mantissa = h & 0x3ff;
+  if (exponent == 0x1f) {
+    return BitsToFloat(sign | 0x7f800000 | (mantissa << 13) |
+                       (mantissa != 0 ? 0x400000 : 0));
+  }
+  if (exponent == 0) {
+    if (mantissa == 0) return BitsToFloat(sign);
+    // Normalize the subnormal.
+    int e = 1;
+    while ((mantissa & 0x400) == 0) {
+      mantissa <<= 1;
+      --e;
+    }
+    return BitsToFloat(sign | static_cast<uint32_t>(e + 112) << 23 |
+                       (mantissa & 0x3ff) << 13);
+  }
+  return BitsToFloat(sign | (exponent + 112) << 23 | mantissa << 13);
+}
+
+// Rounds to nearest even.  NaNs are quieted and keep the high bits of
+// their payload.
+HOSTDEVICE inline uint16_t FloatToBFloat16Bits(float f) {
+  uint32_t bits = FloatToBits(f);
+  if ((bits & 0x7fffffff) > 0x7f800000) {
+    return static_cast<uint16_t>((bits >> 16) | 0x40);
+  }
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return static_cast<uint16_t>(bits >> 16);
+}
+
+HOSTDEVICE inline float BFloat16BitsToFloat(uint16_t b) {
+  return BitsToFloat(static_cast<uint32_t>(b) << 16);
+}
+
+}  // namespace details
+
+/**
+ * @brief   float16 is the IEEE 754 half precision storage type.
+ *
+ * @note    It only converts to and from the builtin types, through float,
+ *          rounding to nearest even.  Kernels compute in float.
+ */
+struct float16 {
+  uint16_t x;
+
+  float16() = default;
+
+  HOSTDEVICE explicit float16(float f) : x(details::FloatToHalfBits(f)) {}
+
+  template <typename T,
+            typename = typename std::enable_if<
+                std::is_arithmetic<T>::value &&
+                !std::is_same<T, float>::value>::type>
+  HOSTDEVICE explicit float16(T v) : float16(static_cast<float>(v)) {}
+
+  HOSTDEVICE static float16 FromBits(uint16_t bits) {
+    float16 h;
+    h.x = bits;
+    return h;
+  }
+
+  HOSTDEVICE explicit operator float() const {
+    return details::HalfBitsToFloat(x);
+  }
+  HOSTDEVICE explicit operator double() const {
+    return static_cast<double>(static_cast<float>(*this));
+  }
+  HOSTDEVICE explicit operator bool() const { return (x & 0x7fff) != 0; }
+  HOSTDEVICE explicit operator int8_t() const {
+    return static_cast<int8_t>(static_cast<float>(*this));
+  }
+  HOSTDEVICE explicit operator uint8_t() const {
+    return static_cast<uint8_t>(static_cast<float>(*this));
+  }
+  HOSTDEVICE explicit operator int16_t() const {
+    return static_cast<int16_t>(static_cast<float>(*this));
+  }
+  HOSTDEVICE explicit operator int() const {
+    return static_cast<int>(static_cast<float>(*this));
+  }
+  HOSTDEVICE explicit operator int64_t() const {
+    return static_cast<int64_t>(static_cast<float>(*this));
+  }
+};
+
+/**
+ * @brief   bfloat16 is the upper half of an IEEE 754 float.
+ *
+ * @note    It has the range of float with 8 bits of precision, and
+ *          converts like float16.
+ */
+struct bfloat16 {
+  uint16_t x;
+
+  bfloat16() = default;
+
+  HOSTDEVICE explicit bfloat16(float f) : x(details::FloatToBFloat16Bits(f)) {}
+
+  template <typename T,
+            typename = typename std::enable_if<
+                std::is_arithmetic<T>::value &&
+                !std::is_same<T, float>::value>::type>
+  HOSTDEVICE explicit bfloat16(T v) : bfloat16(static_cast<float>(v)) {}
+
+  HOSTDEVICE explicit bfloat16(float16 h)
+      : bfloat16(static_cast<float>(h)) {}
+
+  HOSTDEVICE static bfloat16 FromBits(uint16_t bits) {
+    bfloat16 b;
+    b.x = bits;
+    return b;
+  }
+
+  HOSTDEVICE explicit operator float() const {
+    return details::BFloat16BitsToFloat(x);
+  }
+  HOSTDEVICE explicit operator double() const {
+    return static_cast<double>(static_cast<float>(*this));
+  }
+  HOSTDEVICE explicit operator bool() const { return (x & 0x7fff) != 0; }
+  HOSTDEVICE explicit operator int8_t() const {
+    return static_cast<int8_t>(static_cast<float>(*this));
+  }
+  HOSTDEVICE explicit operator uint8_t() const {
+    return static_cast<uint8_t>(static_cast<float>(*this));
+  }
+  HOSTDEVICE explicit operator int16_t() const {
+    return static_cast<int16_t>(static_cast<float>(*this));
+  }
+  HOSTDEVICE explicit operator int() const {
+    return static_cast<int>(static_cast<float>(*this));
+  }
+  HOSTDEVICE explicit operator int64_t() const {
+    return static_cast<int64_t>(static_cast<float>(*this));
+  }
+  HOSTDEVICE explicit operator float16() const {
+    return float16(static_cast<float>(*this));
+  }
+};
+
+HOSTDEVICE inline bool isnan(float16 h) { return (h.x & 0x7fff) > 0x7c00; }
+HOSTDEVICE inline bool isinf(float16 h) { return (h.x & 0x7fff) == 0x7c00; }
+HOSTDEVICE inline bool isfinite(float16 h) {
+  return (h.x & 0x7c00) != 0x7c00;
+}
+
+HOSTDEVICE inline bool isnan(bfloat16 b) { return (b.x & 0x7fff) > 0x7f80; }
+HOSTDEVICE inline bool isinf(bfloat16 b) { return (b.x & 0x7fff) == 0x7f80; }
+HOSTDEVICE inline bool isfinite(bfloat16 b) {
+  return (b.x & 0x7f80) != 0x7f80;
+}
+
+/**
+ * @brief   Bulk conversions on the host.
+ *
+ * @note    They use AVX-512, AVX2 and F16C when the CPU has them, and give
+ *          the same bits as the scalar conversions above.
+ */
+void FloatToHalf(const float* in, float16* out, size_t n);
+void HalfToFloat(const float16* in, float* out, size_t n);
+void FloatToBFloat16(const float* in, bfloat16* out, size_t n);
+void BFloat16ToFloat(const bfloat16* in, float* out, size_t n);
+
+}  // namespace platform
+}  // namespace fluid
+}  // namespace paddle
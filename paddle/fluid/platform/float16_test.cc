@@ -0,0 +1,125 @@
+//  Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "paddle/fluid/platform/float16.h"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+using paddle::fluid::platform::bfloat16;
+using paddle::fluid::platform::float16;
+using paddle::fluid::platform::details::BitsToFloat;
+using paddle::fluid::platform::details::FloatToBits;
+
+TEST(Float16, Convert) {
+  EXPECT_EQ(float16(1.0f).x, 0x3c00);
+  EXPECT_EQ(float16(-2.0f).x, 0xc000);
+  EXPECT_EQ(float16(0.0f).x, 0x0000);
+  EXPECT_EQ(float16(-0.0f).x, 0x8000);
+  EXPECT_EQ(float16(65504.0f).x, 0x7bff);
+  EXPECT_EQ(float16(65520.0f).x, 0x7c00);
+  EXPECT_EQ(float16(1e10f).x, 0x7c00);
+  EXPECT_EQ(float16(std::ldexp(1.0f, -14)).x, 0x0400);
+  EXPECT_EQ(float16(std::ldexp(1.0f, -24)).x, 0x0001);
+  EXPECT_EQ(float16(std::ldexp(1.0f, -25)).x, 0x0000);
+  EXPECT_EQ(float16(std::ldexp(1.5f, -25)).x, 0x0001);
+  EXPECT_EQ(float16(3).x, 0x4200);
+  EXPECT_EQ(static_cast<int>(float16(-3.0f)), -3);
+  EXPECT_TRUE(isinf(float16(std::numeric_limits<float>::infinity())));
+  EXPECT_TRUE(isnan(float16(std::nanf(""))));
+  EXPECT_TRUE(std::isnan(static_cast<float>(float16(std::nanf("")))));
+}
+
+TEST(Float16, RoundTrip) {
+  for (uint32_t bits = 0; bits <= 0xffff; ++bits) {
+    float16 h = float16::FromBits(static_cast<uint16_t>(bits));
+    float16 back(static_cast<float>(h));
+    if (isnan(h)) {
+      EXPECT_TRUE(isnan(back));
+    } else {
+      EXPECT_EQ(back.x, h.x);
+    }
+  }
+}
+
+// The midpoint of two consecutive halves rounds to the even one, and
+// any float beside it to the nearer one.
+TEST(Float16, RoundToNearestEven) {
+  for (uint16_t bits = 0; bits < 0x7bff; ++bits) {
+    float lo = static_cast<float>(float16::FromBits(bits));
+    float hi = static_cast<float>(float16::FromBits(bits + 1));
+    float mid = lo + (hi - lo) / 2;  // exact in float
+    uint16_t even = (bits & 1) ? bits + 1 : bits;
+    EXPECT_EQ(float16(mid).x, even);
+    EXPECT_EQ(float16(std::nextafter(mid, lo)).x, bits);
+    EXPECT_EQ(float16(std::nextafter(mid, hi)).x, bits + 1);
+  }
+}
+
+TEST(BFloat16, Convert) {
+  EXPECT_EQ(bfloat16(1.0f).x, 0x3f80);
+  EXPECT_EQ(bfloat16(-2.0f).x, 0xc000);
+  EXPECT_EQ(bfloat16(1.0f + std::ldexp(1.0f, -8)).x, 0x3f80);
+  EXPECT_EQ(bfloat16(1.0f + std::ldexp(3.0f, -8)).x, 0x3f82);
+  EXPECT_EQ(bfloat16(std::numeric_limits<float>::max()).x, 0x7f80);
+  EXPECT_EQ(static_cast<float>(bfloat16(3.0f)), 3.0f);
+  EXPECT_EQ(static_cast<float>(bfloat16(float16(0.5f))), 0.5f);
+  EXPECT_TRUE(isinf(bfloat16(std::numeric_limits<float>::infinity())));
+  // A NaN with only low payload bits must not become infinity.
+  EXPECT_TRUE(isnan(bfloat16(BitsToFloat(0x7f800001))));
+}
+
+TEST(Float16, BulkConvert) {
+  // Not a multiple of any vector width, to cover the tails.
+  const size_t n = 4099;
+  std::mt19937 rng(0);
+  std::vector<float> in(n);
+  for (size_t i = 0; i < n; ++i) in[i] = BitsToFloat(rng());
+  in[0] = std::numeric_limits<float>::infinity();
+  in[1] = BitsToFloat(0x7f800001);
+  in[2] = BitsToFloat(0xffc00000);
+  in[3] = 65520.0f;
+  in[4] = std::ldexp(1.5f, -25);
+  // Values in the range of float16, where rounding matters most.
+  for (size_t i = 5; i < n / 2; ++i) {
+    in[i] = std::ldexp(static_cast<float>(rng()) / rng.max() - 0.5f,
+                       static_cast<int>(rng() % 40) - 25);
+  }
+
+  std::vector<float16> halves(n);
+  paddle::fluid::platform::FloatToHalf(in.data(), halves.data(), n);
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(halves[i].x, float16(in[i]).x) << in[i];
+  }
+  std::vector<float> floats(n);
+  paddle::fluid::platform::HalfToFloat(halves.data(), floats.data(), n);
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(FloatToBits(floats[i]),
+              FloatToBits(static_cast<float>(halves[i])));
+  }
+
+  std::vector<bfloat16> bhalves(n);
+  paddle::fluid::platform::FloatToBFloat16(in.data(), bhalves.data(), n);
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(bhalves[i].x, bfloat16(in[i]).x) << in[i];
+  }
+  paddle::fluid::platform::BFloat16ToFloat(bhalves.data(), floats.data(), n);
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(FloatToBits(floats[i]),
+              FloatToBits(static_cast<float>(bhalves[i])));
+  }
+}
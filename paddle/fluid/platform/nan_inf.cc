@@ -0,0 +1,179 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/nan_inf.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PADDLE_NAN_INF_WITH_AVX2
+#include <immintrin.h>
+#endif
+
+namespace paddle {
+namespace fluid {
+namespace platform {
+
+namespace {
+
+// An element is NaN or Inf iff all the bits of its exponent are set.
+constexpr uint16_t kHalfExponent = 0x7c00;
+constexpr uint16_t kBFloat16Exponent = 0x7f80;
+constexpr uint32_t kFloatExponent = 0x7f800000;
+constexpr uint64_t kDoubleExponent = 0x7ff0000000000000;
+
+// Arrays shorter than this are scanned by the calling thread.
+constexpr size_t kMinBytesPerThread = 4 << 20;
+// Each thread looks for the hits of the others after this many bytes.
+constexpr size_t kBlockBytes = 256 << 10;
+
+template <typename U>
+bool ExponentAllOnesScalar(const U* bits, size_t n, U mask) {
+  // No branch per element, so that the compiler may vectorize the loop.
+  constexpr size_t kStep = 256;
+  for (size_t i = 0; i < n; i += kStep) {
+    U hit = 0;
+    for (size_t j = i; j < std::min(n, i + kStep); ++j) {
+      hit |= static_cast<U>((bits[j] & mask) == mask);
+    }
+    if (hit != 0) return true;
+  }
+  return false;
+}
+
+#ifdef PADDLE_NAN_INF_WITH_AVX2
+
+__attribute__((target("avx2"))) inline __m256i Set1(uint16_t v) {
+  return _mm256_set1_epi16(static_cast<int16_t>(v));
+}
+__attribute__((target("avx2"))) inline __m256i Set1(uint32_t v) {
+  return _mm256_set1_epi32(static_cast<int32_t>(v));
+}
+__attribute__((target("avx2"))) inline __m256i Set1(uint64_t v) {
+  return _mm256_set1_epi64x(static_cast<int64_t>(v));
+}
+
+__attribute__((target("avx2"))) inline __m256i CmpEq(__m256i a,
+                                                     __m256i b,
+                                                     uint16_t) {
+  return _mm256_cmpeq_epi16(a, b);
+}
+__attribute__((target("avx2"))) inline __m256i CmpEq(__m256i a,
+                                                     __m256i b,
+                                                     uint32_t) {
+  return _mm256_cmpeq_epi32(a, b);
+}
+__attribute__((target("avx2"))) inline __m256i CmpEq(__m256i a,
+                                                     __m256i b,
+                                                     uint64_t) {
+  return _mm256_cmpeq_epi64(a, b);
+}
+
+template <typename U>
+__attribute__((target("avx2"))) bool ExponentAllOnesAVX2(const U* bits,
+                                                         size_t n,
+                                                         U mask) {
+  constexpr size_t kStep = 4 * sizeof(__m256i) / sizeof(U);
+  const __m256i m = Set1(mask);
+  size_t i = 0;
+  for (; i + kStep <= n; i += kStep) {
+    auto* p = reinterpret_cast<const __m256i*>(bits + i);
+    __m256i hit = _mm256_setzero_si256();
+    for (int j = 0; j < 4; ++j) {
+      __m256i v = _mm256_and_si256(_mm256_loadu_si256(p + j), m);
+      hit = _mm256_or_si256(hit, CmpEq(v, m, mask));
+    }
+    if (!_mm256_testz_si256(hit, hit)) return true;
+  }
+  return ExponentAllOnesScalar(bits + i, n - i, mask);
+}
+
+#endif  // PADDLE_NAN_INF_WITH_AVX2
+
+bool HasAVX2() {
+#ifdef PADDLE_NAN_INF_WITH_AVX2
+  static bool has_avx2 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+  }();
+  return has_avx2;
+#else
+  return false;
+#endif
+}
+
+template <typename U>
+bool ExponentAllOnes(const U* bits, size_t n, U mask) {
+#ifdef PADDLE_NAN_INF_WITH_AVX2
+  if (HasAVX2()) return ExponentAllOnesAVX2(bits, n, mask);
+#endif
+  return ExponentAllOnesScalar(bits, n, mask);
+}
+
+template <typename U>
+bool ParallelExponentAllOnes(const U* bits, size_t n, U mask) {
+  size_t threads = std::min<size_t>(std::thread::hardware_concurrency(),
+                                    n * sizeof(U) / kMinBytesPerThread);
+  if (threads <= 1) return ExponentAllOnes(bits, n, mask);
+
+  std::atomic<bool> found(false);
+  auto scan = [&](size_t begin, size_t end) {
+    const size_t block = kBlockBytes / sizeof(U);
+    for (size_t i = begin; i < end && !found.load(std::memory_order_relaxed);
+         i += block) {
+      if (ExponentAllOnes(bits + i, std::min(block, end - i), mask)) {
+        found.store(true, std::memory_order_relaxed);
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  size_t chunk = (n + threads - 1) / threads;
+  for (size_t t = 1; t < threads; ++t) {
+    workers.emplace_back(scan, t * chunk, std::min(n, (t + 1) * chunk));
+  }
+  scan(0, chunk);
+  for (auto& worker : workers) worker.join();
+  return found.load();
+}
+
+}  // namespace
+
+bool ContainsNanOrInf(const float* data, size_t n) {
+  return ParallelExponentAllOnes(
+      reinterpret_cast<const uint32_t*>(data), n, kFloatExponent);
+}
+
+bool ContainsNanOrInf(const double* data, size_t n) {
+  return ParallelExponentAllOnes(
+      reinterpret_cast<const uint64_t*>(data), n, kDoubleExponent);
+}
+
+bool ContainsNanOrInf(const float16* data, size_t n) {
+  return ParallelExponentAllOnes(
+      reinterpret_cast<const uint16_t*>(data), n, kHalfExponent);
+}
+
+bool ContainsNanOrInf(const bfloat16* data, size_t n) {
+  return ParallelExponentAllOnes(
+      reinterpret_cast<const uint16_t*>(data), n, kBFloat16Exponent);
+}
+
+}  // namespace platform
+}  // namespace fluid
+}  // namespace paddle
@@ -0,0 +1,39 @@
+/* Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "paddle/fluid/platform/float16.h"
+
+namespace paddle {
+namespace fluid {
+namespace platform {
+
+/**
+ * @brief   Whether any of the n elements at data on the host is NaN or Inf.
+ *
+ * @note    NaN and Inf are both checked in one pass over the exponent bits,
+ *          with AVX2 when the CPU has it.  Large arrays are split among
+ *          threads.  The scan stops soon after the first hit.
+ */
+bool ContainsNanOrInf(const float* data, size_t n);
+bool ContainsNanOrInf(const double* data, size_t n);
+bool ContainsNanOrInf(const float16* data, size_t n);
+bool ContainsNanOrInf(const bfloat16* data, size_t n);
+
+}  // namespace platform
+}  // namespace fluid
+}  // namespace paddle
@@ -0,0 +1,62 @@
+//  Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "paddle/fluid/platform/nan_inf.h"
+
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace platform = paddle::fluid::platform;
+
+template <typename T>
+void CheckEveryPosition() {
+  const T nan(std::numeric_limits<float>::quiet_NaN());
+  const T inf(-std::numeric_limits<float>::infinity());
+  // Long enough for the vector loop and a tail, for any element size.
+  const size_t n = 200;
+  std::vector<T> data(n, T(1e30f));
+  EXPECT_FALSE(platform::ContainsNanOrInf(data.data(), n));
+  for (size_t i = 0; i < n; ++i) {
+    data[i] = i % 2 ? nan : inf;
+    EXPECT_TRUE(platform::ContainsNanOrInf(data.data(), n)) << i;
+    EXPECT_FALSE(platform::ContainsNanOrInf(data.data(), i)) << i;
+    data[i] = T(1e30f);
+  }
+}
+
+TEST(ContainsNanOrInf, Float) { CheckEveryPosition<float>(); }
+
+TEST(ContainsNanOrInf, Double) { CheckEveryPosition<double>(); }
+
+TEST(ContainsNanOrInf, Float16) {
+  // 1e30 overflows float16, so use the largest finite value.
+  std::vector<platform::float16> data(100, platform::float16(65504.0f));
+  EXPECT_FALSE(platform::ContainsNanOrInf(data.data(), data.size()));
+  data[77] = platform::float16(std::numeric_limits<float>::quiet_NaN());
+  EXPECT_TRUE(platform::ContainsNanOrInf(data.data(), data.size()));
+}
+
+TEST(ContainsNanOrInf, BFloat16) { CheckEveryPosition<platform::bfloat16>(); }
+
+TEST(ContainsNanOrInf, Parallel) {
+  // Large enough to be split among threads.
+  std::vector<float> data(16 << 20, 1.0f);
+  EXPECT_FALSE(platform::ContainsNanOrInf(data.data(), data.size()));
+  data[data.size() - 1] = std::numeric_limits<float>::infinity();
+  EXPECT_TRUE(platform::ContainsNanOrInf(data.data(), data.size()));
+  data[data.size() - 1] = 1.0f;
+  data[data.size() / 3] = std::numeric_limits<float>::quiet_NaN();
+  EXPECT_TRUE(platform::ContainsNanOrInf(data.data(), data.size()));
+}
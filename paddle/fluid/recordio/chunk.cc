@@ -16,8 +16,9 @@
 
 #include <zlib.h>
 #include <algorithm>
+#include <cstring>
 #include <memory>
-#include <sstream>
+#include <streambuf>
 
 #include "paddle/fluid/platform/enforce.h"
 #include "snappystream.hpp"
@@ -26,6 +27,10 @@ namespace paddle {
 namespace fluid {
 namespace recordio {
 constexpr size_t kMaxBufSize = 1024;
+// The checksum of a chunk is updated once this many bytes of records are
+// added, which costs less than a call per small record while the bytes are
+// still in cache.
+constexpr size_t kCrcBlockSize = 64 * 1024;
 
 /**
  * Read Stream by a fixed sized buffer.
@@ -57,14 +62,6 @@ static void ReadStreamByBuf(std::istream& in, size_t limit, Callback callback) {
   in.clear();  // unset eof state
 }
 
-/**
- * Copy stream in to another stream
- */
-static void PipeStream(std::istream& in, std::ostream& os) {
-  ReadStreamByBuf(
-      in, 0, [&os](const char* buf, size_t len) { os.write(buf, len); });
-}
-
 /**
  * Calculate CRC32 from an input stream.
  */
@@ -77,45 +74,109 @@ static uint32_t Crc32Stream(std::istream& in, size_t limit = 0) {
   return crc;
 }
 
-bool Chunk::Write(std::ostream& os, Compressor ct) const {
+/**
+ * A stream buffer appending to a string, so that a compressor writes its
+ * output straight into a reused buffer.
+ */
+class StringSink : public std::streambuf {
+ public:
+  explicit StringSink(std::string* buf) : buf_(buf) {}
+
+ protected:
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    buf_->append(s, static_cast<size_t>(n));
+    return n;
+  }
+
+  int_type overflow(int_type c) override {
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      buf_->push_back(traits_type::to_char_type(c));
+    }
+    return traits_type::not_eof(c);
+  }
+
+ private:
+  std::string* buf_;
+};
+
+static uint32_t Crc32(uint32_t crc, const char* data, size_t size) {
+  return static_cast<uint32_t>(crc32(
+      crc, reinterpret_cast<const Bytef*>(data), static_cast<uInt>(size)));
+}
+
+void Chunk::Add(const char* data, size_t size) {
+  Append(data, size);
+  if (crc_on_add_ && buf_.size() - crc_size_ >= kCrcBlockSize) UpdateCrc();
+}
+
+void Chunk::Append(const char* data, size_t size) {
+  size_t offset = buf_.size();
+  uint32_t sz = static_cast<uint32_t>(size);
+  buf_.resize(offset + sizeof(sz) + size);
+  std::memcpy(&buf_[offset], &sz, sizeof(sz));
+  std::memcpy(&buf_[offset + sizeof(sz)], data, size);
+  offsets_.push_back(offset);
+  num_bytes_ += size;
+}
+
+void Chunk::UpdateCrc() {
+  crc_ = Crc32(crc_, buf_.data() + crc_size_, buf_.size() - crc_size_);
+  crc_size_ = buf_.size();
+}
+
+void Chunk::Clear() {
+  buf_.resize(kHeaderSize);
+  offsets_.clear();
+  crc_ = Crc32(0, nullptr, 0);
+  crc_size_ = kHeaderSize;
+  num_bytes_ = 0;
+}
+
+std::string Chunk::Record(int i) const {
+  size_t offset = offsets_[i];
+  uint32_t sz;
+  std::memcpy(&sz, &buf_[offset], sizeof(sz));
+  return buf_.substr(offset + sizeof(sz), sz);
+}
+
+bool Chunk::Write(std::ostream& os, Compressor ct) {
   // NOTE(dzhwinter): don't check records.numBytes instead, because
   // empty records are allowed.
-  if (records_.empty()) {
+  if (offsets_.empty()) {
     return false;
   }
-  std::stringstream sout;
-  std::unique_ptr<std::ostream> compressed_stream;
+  // The payload follows the space of the header in out, so that both go
+  // out in a single write.
+  std::string* out = &buf_;
+  uint32_t crc;
   switch (ct) {
     case Compressor::kNoCompress:
+      UpdateCrc();
+      crc = crc_;
       break;
-    case Compressor::kSnappy:
-      compressed_stream.reset(new snappy::oSnappyStream(sout));
+    case Compressor::kSnappy: {
+      compressed_.resize(kHeaderSize);
+      {
+        StringSink sink(&compressed_);
+        std::ostream sink_stream(&sink);
+        snappy::oSnappyStream compressed_stream(sink_stream);
+        compressed_stream.write(buf_.data() + kHeaderSize,
+                                buf_.size() - kHeaderSize);
+      }
+      out = &compressed_;
+      crc = Crc32(Crc32(0, nullptr, 0),
+                  compressed_.data() + kHeaderSize,
+                  compressed_.size() - kHeaderSize);
       break;
+    }
     default:
       PADDLE_THROW("Not implemented");
   }
 
-  std::ostream& buf_stream = compressed_stream ? *compressed_stream : sout;
-
-  for (auto& record : records_) {
-    size_t sz = record.size();
-    buf_stream.write(reinterpret_cast<const char*>(&sz), sizeof(uint32_t))
-        .write(record.data(), record.size());
-  }
-
-  if (compressed_stream) {
-    compressed_stream.reset();
-  }
-
-  sout.seekg(0, std::ios::end);
-  uint32_t len = static_cast<uint32_t>(sout.tellg());
-  sout.seekg(0, std::ios::beg);
-  uint32_t crc = Crc32Stream(sout);
-  Header hdr(static_cast<uint32_t>(records_.size()), crc, ct, len);
-  hdr.Write(os);
-  sout.seekg(0, std::ios::beg);
-  sout.clear();
-  PipeStream(sout, os);
+  uint32_t len = static_cast<uint32_t>(out->size() - kHeaderSize);
+  Header hdr(static_cast<uint32_t>(offsets_.size()), crc, ct, len);
+  hdr.Write(&(*out)[0]);
+  os.write(out->data(), out->size());
   return true;
 }
 
@@ -125,8 +186,11 @@ bool Chunk::Parse(std::istream& sin) {
     return false;
   }
   Clear();
+  // The checksum was checked by the parser, and is only computed again if
+  // the chunk is written.
   while (parser.HasNext()) {
-    Add(parser.Next());
+    std::string record = parser.Next();
+    Append(record.data(), record.size());
   }
   return true;
 }
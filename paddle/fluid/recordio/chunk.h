@@ -25,31 +25,52 @@ namespace fluid {
 namespace recordio {
 
 // A Chunk contains the Header and optionally compressed records.
+//
+// The records are appended into one contiguous buffer, laid out as the
+// uncompressed payload of the chunk behind the space of its header, and
+// their checksum is updated in blocks as they are added.  The buffer is
+// kept across Clear, so that writing a chunk copies each record once and
+// does not allocate.
 class Chunk {
  public:
-  Chunk() : num_bytes_(0) {}
-  void Add(const std::string& buf) {
-    num_bytes_ += buf.size();
-    records_.emplace_back(buf);
+  // A chunk to be compressed is checked by the checksum of the compressed
+  // bytes, so that of its records is not kept as they are added.
+  explicit Chunk(Compressor compressor = Compressor::kNoCompress)
+      : crc_on_add_(compressor == Compressor::kNoCompress) {
+    Clear();
   }
+  void Add(const std::string& buf) { Add(buf.data(), buf.size()); }
+  void Add(const char* data, size_t size);
   // dump the chunk into w, and clears the chunk and makes it ready for
   // the next add invocation.
-  bool Write(std::ostream& fo, Compressor ct) const;
-  void Clear() {
-    records_.clear();
-    num_bytes_ = 0;
-  }
+  bool Write(std::ostream& fo, Compressor ct);
+  void Clear();
 
   // returns true if ok, false if eof
   bool Parse(std::istream& sin);
   size_t NumBytes() const { return num_bytes_; }
-  size_t NumRecords() const { return records_.size(); }
-  const std::string& Record(int i) const { return records_[i]; }
+  size_t NumRecords() const { return offsets_.size(); }
+  std::string Record(int i) const;
 
-  bool Empty() const { return records_.empty(); }
+  bool Empty() const { return offsets_.empty(); }
 
  private:
-  std::vector<std::string> records_;
+  // appends a record to buf_, leaving crc_ behind.
+  void Append(const char* data, size_t size);
+  // folds the records appended since the last call into crc_.
+  void UpdateCrc();
+
+  // kHeaderSize bytes for the header, then the uint32_t length and the
+  // bytes of each record.
+  std::string buf_;
+  // the offsets of the records in buf_.
+  std::vector<size_t> offsets_;
+  // the CRC32 of the first crc_size_ bytes of records in buf_.
+  uint32_t crc_;
+  size_t crc_size_;
+  bool crc_on_add_;
+  // the compressed payload behind the space of its header.
+  std::string compressed_;
   // sum of record lengths in bytes.
   size_t num_bytes_;
   DISABLE_COPY_AND_ASSIGN(Chunk);
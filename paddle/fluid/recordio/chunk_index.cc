@@ -0,0 +1,148 @@
+//   Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/recordio/chunk_index.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace fluid {
+namespace recordio {
+
+// The offset of the index and the magic number closing it.
+constexpr size_t kIndexTrailerSize = sizeof(uint64_t) + sizeof(uint32_t);
+// The offset and the number of records of a chunk.
+constexpr size_t kIndexEntrySize = sizeof(uint64_t) + sizeof(uint32_t);
+// An index of no chunks: the magic number, the number of chunks and the
+// trailer.
+constexpr size_t kMinIndexSize = 2 * sizeof(uint32_t) + kIndexTrailerSize;
+
+template <typename T>
+static void WriteValue(std::ostream& os, T value) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+static T ReadValue(std::istream& is) {
+  T value;
+  is.read(reinterpret_cast<char*>(&value), sizeof(value));
+  PADDLE_ENFORCE_EQ(static_cast<size_t>(is.gcount()),
+                    sizeof(value),
+                    "The chunk index is truncated.");
+  return value;
+}
+
+void ChunkIndex::Add(uint64_t offset, uint32_t num_records) {
+  offsets_.push_back(offset);
+  first_records_.push_back(first_records_.back() + num_records);
+}
+
+size_t ChunkIndex::ChunkOf(uint64_t record) const {
+  PADDLE_ENFORCE_LT(record, NumRecords(), "The record is out of the file.");
+  auto it =
+      std::upper_bound(first_records_.begin(), first_records_.end(), record);
+  return static_cast<size_t>(it - first_records_.begin()) - 1;
+}
+
+std::vector<std::pair<size_t, size_t>> ChunkIndex::Split(size_t n) const {
+  PADDLE_ENFORCE_GT(n, 0UL, "Cannot split into no ranges.");
+  std::vector<std::pair<size_t, size_t>> ranges;
+  size_t begin = 0;
+  for (size_t i = 1; i <= n; ++i) {
+    size_t end = NumChunks();
+    if (i < n) {
+      // the first chunk starting at or after the i-th n-th of the records.
+      uint64_t record = NumRecords() * i / n;
+      end = std::lower_bound(
+                first_records_.begin(), first_records_.end() - 1, record) -
+            first_records_.begin();
+      end = std::max(begin, end);
+    }
+    ranges.emplace_back(begin, end);
+    begin = end;
+  }
+  return ranges;
+}
+
+void ChunkIndex::Write(std::ostream& os, uint64_t offset) const {
+  WriteValue(os, kIndexMagicNumber);
+  WriteValue(os, static_cast<uint32_t>(NumChunks()));
+  for (size_t i = 0; i < NumChunks(); ++i) {
+    WriteValue(os, offsets_[i]);
+    uint64_t num_records = first_records_[i + 1] - first_records_[i];
+    WriteValue(os, static_cast<uint32_t>(num_records));
+  }
+  WriteValue(os, offset);
+  WriteValue(os, kIndexMagicNumber);
+}
+
+bool ChunkIndex::Read(std::istream& is) {
+  is.clear();
+  is.seekg(0, std::ios::end);
+  auto end = static_cast<int64_t>(is.tellg());
+  if (end < static_cast<int64_t>(kMinIndexSize)) {
+    return false;
+  }
+  auto size = static_cast<uint64_t>(end);
+  is.seekg(size - kIndexTrailerSize, std::ios::beg);
+  auto offset = ReadValue<uint64_t>(is);
+  if (ReadValue<uint32_t>(is) != kIndexMagicNumber ||
+      offset > size - kMinIndexSize) {
+    return false;
+  }
+  // The records of a file without an index may end in bytes that look like
+  // a trailer, so the index must also begin with the magic number and end
+  // right at the trailer.
+  is.seekg(offset, std::ios::beg);
+  if (ReadValue<uint32_t>(is) != kIndexMagicNumber) {
+    return false;
+  }
+  auto num_chunks = ReadValue<uint32_t>(is);
+  if (offset + kMinIndexSize + num_chunks * kIndexEntrySize != size) {
+    return false;
+  }
+  ChunkIndex index;
+  for (uint32_t i = 0; i < num_chunks; ++i) {
+    auto chunk_offset = ReadValue<uint64_t>(is);
+    if (chunk_offset >= offset) {
+      return false;
+    }
+    index.Add(chunk_offset, ReadValue<uint32_t>(is));
+  }
+  *this = std::move(index);
+  return true;
+}
+
+void ChunkIndex::Build(std::istream& is) {
+  *this = ChunkIndex();
+  is.clear();
+  is.seekg(0, std::ios::beg);
+  Header header;
+  while (true) {
+    auto offset = static_cast<uint64_t>(is.tellg());
+    if (!header.Parse(is)) {
+      break;
+    }
+    Add(offset, header.NumRecords());
+    is.seekg(header.CompressSize(), std::ios::cur);
+  }
+  is.clear();
+}
+
+}  // namespace recordio
+}  // namespace fluid
+}  // namespace paddle
@@ -0,0 +1,78 @@
+//   Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/recordio/header.h"
+
+namespace paddle {
+namespace fluid {
+namespace recordio {
+
+// ChunkIndex maps the chunks of a RecordIO file to their offsets and the
+// records they hold, so that a reader can seek to a chunk or a record.
+//
+// Written at the end of a file, the index is laid out as
+//
+//   uint32_t kIndexMagicNumber, uint32_t number of chunks,
+//   for each chunk its uint64_t offset and uint32_t number of records,
+//   uint64_t offset of the index, uint32_t kIndexMagicNumber
+//
+// A reader of the chunks stops at the first magic number, and a reader of
+// the index finds it from the last twelve bytes, and takes it only if it
+// ends right there.
+class ChunkIndex {
+ public:
+  ChunkIndex() : first_records_(1, 0) {}
+
+  void Add(uint64_t offset, uint32_t num_records);
+
+  size_t NumChunks() const { return offsets_.size(); }
+  uint64_t NumRecords() const { return first_records_.back(); }
+  uint64_t Offset(size_t chunk) const { return offsets_[chunk]; }
+  // the number of records before the chunk, or all of them for NumChunks.
+  uint64_t FirstRecord(size_t chunk) const { return first_records_[chunk]; }
+  // the chunk holding the record.
+  size_t ChunkOf(uint64_t record) const;
+
+  // splits the chunks into n successive ranges [begin, end) with about the
+  // same number of records; some are empty if there are fewer chunks.
+  std::vector<std::pair<size_t, size_t>> Split(size_t n) const;
+
+  // writes the index at offset of the stream.
+  void Write(std::ostream& os, uint64_t offset) const;
+
+  // reads the index at the end of a stream, and returns false if there is
+  // none, including when the last records only look like a trailer.
+  bool Read(std::istream& is);
+
+  // indexes a stream without an index by reading the header of each chunk
+  // and seeking over its payload.
+  void Build(std::istream& is);
+
+ private:
+  std::vector<uint64_t> offsets_;
+  // the prefix sums of the numbers of records of the chunks.
+  std::vector<uint64_t> first_records_;
+};
+
+}  // namespace recordio
+}  // namespace fluid
+}  // namespace paddle
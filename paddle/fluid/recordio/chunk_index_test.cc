@@ -0,0 +1,76 @@
+//   Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/recordio/chunk_index.h"
+
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+using paddle::fluid::recordio::ChunkIndex;
+
+TEST(ChunkIndex, Lookup) {
+  ChunkIndex index;
+  index.Add(0, 3);
+  index.Add(100, 5);
+  index.Add(200, 2);
+  EXPECT_EQ(index.NumChunks(), 3UL);
+  EXPECT_EQ(index.NumRecords(), 10UL);
+  EXPECT_EQ(index.FirstRecord(2), 8UL);
+  EXPECT_EQ(index.ChunkOf(0), 0UL);
+  EXPECT_EQ(index.ChunkOf(3), 1UL);
+  EXPECT_EQ(index.ChunkOf(9), 2UL);
+
+  auto ranges = index.Split(2);
+  ASSERT_EQ(ranges.size(), 2UL);
+  // The second range starts at the first chunk after half of the records.
+  EXPECT_EQ(ranges[0].first, 0UL);
+  EXPECT_EQ(ranges[0].second, 2UL);
+  EXPECT_EQ(ranges[1].first, 2UL);
+  EXPECT_EQ(ranges[1].second, 3UL);
+  ranges = index.Split(5);
+  EXPECT_EQ(ranges.front().first, 0UL);
+  EXPECT_EQ(ranges.back().second, 3UL);
+  for (size_t i = 1; i < ranges.size(); ++i) {
+    EXPECT_EQ(ranges[i - 1].second, ranges[i].first);
+  }
+}
+
+TEST(ChunkIndex, WriteRead) {
+  ChunkIndex index;
+  index.Add(0, 3);
+  index.Add(64, 4);
+  std::stringstream ss;
+  ss << std::string(128, 'x');
+  index.Write(ss, 128);
+
+  ChunkIndex read;
+  ASSERT_TRUE(read.Read(ss));
+  EXPECT_EQ(read.NumChunks(), 2UL);
+  EXPECT_EQ(read.Offset(1), 64UL);
+  EXPECT_EQ(read.NumRecords(), 7UL);
+
+  std::stringstream empty("no index");
+  EXPECT_FALSE(read.Read(empty));
+
+  // The bytes of a trailer alone are not an index.
+  std::stringstream fake;
+  fake << std::string(128, 'x');
+  uint64_t offset = 16;
+  uint32_t magic = paddle::fluid::recordio::kIndexMagicNumber;
+  fake.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+  fake.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+  EXPECT_FALSE(read.Read(fake));
+  EXPECT_EQ(read.NumChunks(), 2UL);
+}
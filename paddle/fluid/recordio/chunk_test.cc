@@ -45,3 +45,30 @@ TEST(Chunk, Compressor) {
   ch.Parse(ss);
   ASSERT_EQ(ch.NumBytes(), 18ul);
 }
+
+TEST(Chunk, Reuse) {
+  // A chunk made for compression leaves the checksum to Write.
+  for (auto compressor : {paddle::fluid::recordio::Compressor::kNoCompress,
+                          paddle::fluid::recordio::Compressor::kSnappy}) {
+    paddle::fluid::recordio::Chunk ch(compressor);
+    std::string record(1000, 'a');
+    for (int round = 0; round < 2; ++round) {
+      // More bytes than the checksum is updated for at a time.
+      for (int i = 0; i < 100; ++i) {
+        record[0] = static_cast<char>(i);
+        ch.Add(record);
+      }
+      EXPECT_EQ(ch.Record(42)[0], 42);
+      std::stringstream ss;
+      ch.Write(ss, paddle::fluid::recordio::Compressor::kNoCompress);
+      ch.Clear();
+      ASSERT_TRUE(ch.Empty());
+
+      ss.seekg(0);
+      ASSERT_TRUE(ch.Parse(ss));
+      ASSERT_EQ(ch.NumRecords(), 100UL);
+      EXPECT_EQ(ch.Record(99), ch.Record(98).replace(0, 1, 1, 99));
+      ch.Clear();
+    }
+  }
+}
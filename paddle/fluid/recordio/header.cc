@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/recordio/header.h"
 
+#include <cstring>
 #include <string>
 
 #include "paddle/fluid/platform/enforce.h"
@@ -38,6 +39,10 @@ bool Header::Parse(std::istream& is) {
   if (read_size < sizeof(uint32_t)) {
     return false;
   }
+  if (magic == kIndexMagicNumber) {
+    is.setstate(std::ios::eofbit);
+    return false;
+  }
   PADDLE_ENFORCE_EQ(magic, kMagicNumber);
 
   is.read(reinterpret_cast<char*>(&num_records_), sizeof(uint32_t))
@@ -55,6 +60,16 @@ void Header::Write(std::ostream& os) const {
       .write(reinterpret_cast<const char*>(&compress_size_), sizeof(uint32_t));
 }
 
+void Header::Write(char* buf) const {
+  const uint32_t fields[] = {kMagicNumber,
+                             num_records_,
+                             checksum_,
+                             static_cast<uint32_t>(compressor_),
+                             compress_size_};
+  static_assert(sizeof(fields) == kHeaderSize, "The header has 5 fields.");
+  std::memcpy(buf, fields, kHeaderSize);
+}
+
 std::ostream& operator<<(std::ostream& os, Header h) {
   os << "Header: " << h.NumRecords() << ", " << h.Checksum() << ", "
      << static_cast<uint32_t>(h.CompressType()) << ", " << h.CompressSize();
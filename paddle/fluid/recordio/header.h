@@ -22,6 +22,10 @@ namespace recordio {
 
 // MagicNumber for memory checking
 constexpr uint32_t kMagicNumber = 0x01020304;
+// Begins and ends the ChunkIndex written after the chunks of a file.
+constexpr uint32_t kIndexMagicNumber = 0x01020305;
+// The magic number and the four fields of a Header.
+constexpr size_t kHeaderSize = 5 * sizeof(uint32_t);
 
 enum class Compressor : uint32_t {
   // NoCompression means writing raw chunk data into files.
@@ -43,8 +47,11 @@ class Header {
   Header(uint32_t num, uint32_t sum, Compressor ct, uint32_t cs);
 
   void Write(std::ostream& os) const;
+  // writes the kHeaderSize bytes of the header into buf.
+  void Write(char* buf) const;
 
-  // returns true if OK, false if eof
+  // returns true if OK, false if eof or at the chunk index, which ends the
+  // chunks of a file.
   bool Parse(std::istream& is);
 
   uint32_t NumRecords() const { return num_records_; }
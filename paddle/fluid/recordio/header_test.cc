@@ -28,3 +28,13 @@ TEST(Recordio, ChunkHead) {
   hdr2.Parse(ss);
   EXPECT_TRUE(hdr == hdr2);
 }
+
+TEST(Recordio, ChunkHeadToBuffer) {
+  paddle::fluid::recordio::Header hdr(
+      7, 42, paddle::fluid::recordio::Compressor::kSnappy, 9);
+  std::stringstream ss;
+  hdr.Write(ss);
+  char buf[paddle::fluid::recordio::kHeaderSize];
+  hdr.Write(buf);
+  EXPECT_EQ(ss.str(), std::string(buf, sizeof(buf)));
+}
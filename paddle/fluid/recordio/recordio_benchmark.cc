@@ -0,0 +1,70 @@
+//   Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Times writing records into a stream that discards them, e.g.,
+//
+//   recordio_benchmark --record_size=1000 --snappy
+
+#include <chrono>
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/recordio/writer.h"
+
+DEFINE_int32(record_size, 1000, "The size of a record in bytes.");
+DEFINE_int32(megabytes, 256, "The megabytes of records to write.");
+DEFINE_int32(records_per_chunk, 1000, "The number of records in a chunk.");
+DEFINE_bool(snappy, false, "Compress the chunks with snappy.");
+
+namespace {
+
+class NullBuf : public std::streambuf {
+ protected:
+  std::streamsize xsputn(const char*, std::streamsize n) override {
+    return n;
+  }
+  int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  namespace recordio = paddle::fluid::recordio;
+  std::string record(FLAGS_record_size, '\0');
+  for (size_t i = 0; i < record.size(); ++i) {
+    record[i] = static_cast<char>(i * 7);
+  }
+  size_t bytes = static_cast<size_t>(FLAGS_megabytes) << 20;
+  size_t num_records = bytes / record.size();
+
+  NullBuf null;
+  std::ostream os(&null);
+  auto begin = std::chrono::steady_clock::now();
+  {
+    recordio::Writer writer(&os,
+                            FLAGS_snappy ? recordio::Compressor::kSnappy
+                                         : recordio::Compressor::kNoCompress,
+                            FLAGS_records_per_chunk);
+    for (size_t i = 0; i < num_records; ++i) writer.Write(record);
+    writer.Flush();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - begin;
+  std::cout << num_records * record.size() / elapsed.count() / (1 << 20)
+            << " MB/s" << std::endl;
+  return 0;
+}
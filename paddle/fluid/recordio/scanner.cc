@@ -14,7 +14,17 @@
 
 #include "paddle/fluid/recordio/scanner.h"
 
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <mutex>  // NOLINT
+#include <streambuf>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "paddle/fluid/platform/enforce.h"
 
@@ -22,6 +32,197 @@ namespace paddle {
 namespace fluid {
 namespace recordio {
 
+namespace {
+
+// A seekable input stream buffer over the bytes of a chunk in memory.
+class ArrayBuf : public std::streambuf {
+ public:
+  ArrayBuf(char* data, size_t size) { setg(data, data, data + size); }
+
+ protected:
+  pos_type seekoff(off_type off,
+                   std::ios_base::seekdir dir,
+                   std::ios_base::openmode which) override {
+    char* base = dir == std::ios_base::beg
+                     ? eback()
+                     : dir == std::ios_base::cur ? gptr() : egptr();
+    if (off < eback() - base || off > egptr() - base) {
+      return pos_type(off_type(-1));
+    }
+    setg(eback(), base + off, egptr());
+    return pos_type(gptr() - eback());
+  }
+
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+  }
+};
+
+// Reads the header and the payload of the next chunk into raw, and
+// returns false at the end of the stream.
+bool ReadChunk(std::istream* in, std::string* raw) {
+  Header header;
+  if (!header.Parse(*in)) {
+    return false;
+  }
+  raw->resize(kHeaderSize + header.CompressSize());
+  header.Write(&(*raw)[0]);
+  in->read(&(*raw)[kHeaderSize], header.CompressSize());
+  PADDLE_ENFORCE_EQ(static_cast<uint32_t>(in->gcount()),
+                    header.CompressSize(),
+                    "The chunk is truncated.");
+  return true;
+}
+
+}  // namespace
+
+// The workers take turns reading a chunk from the stream, and parse it
+// apart; the caller takes the parsed chunks from ready_.  The number of
+// chunks read and not yet taken is bounded by max_chunks.
+class Scanner::Prefetcher {
+ public:
+  // reads at most limit chunks.
+  Prefetcher(std::istream* stream,
+             int num_threads,
+             bool keep_order,
+             size_t max_chunks,
+             uint64_t limit)
+      : stream_(stream),
+        keep_order_(keep_order),
+        max_chunks_(max_chunks),
+        limit_(limit) {
+    for (int i = 0; i < num_threads; ++i) {
+      workers_.emplace_back([this] { Work(); });
+    }
+  }
+
+  ~Prefetcher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) worker.join();
+  }
+
+  bool HasNext() {
+    if (current_ != nullptr && pos_ < current_->NumRecords()) {
+      return true;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      auto it = keep_order_ ? ready_.find(taken_) : ready_.begin();
+      // the chunks after a failed one are not handed out.
+      if (it != ready_.end() && it->first < error_seq_) {
+        current_ = std::move(it->second);
+        ready_.erase(it);
+        pos_ = 0;
+        ++taken_;
+        --in_flight_;
+        cv_.notify_all();
+        if (current_->NumRecords() > 0) return true;
+        continue;
+      }
+      // the error is raised once the chunks before it are taken.
+      if (busy_ == 0 && error_) std::rethrow_exception(error_);
+      if (busy_ == 0 && taken_ == num_chunks_) {
+        return false;
+      }
+      cv_.wait(lock);
+    }
+  }
+
+  std::string Next() { return HasNext() ? current_->Record(pos_++) : ""; }
+
+  // held by whoever moves the stream.
+  std::mutex& read_mutex() { return read_mutex_; }
+
+ private:
+  void Work() {
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] {
+          return stop_ || done_ || in_flight_ < max_chunks_;
+        });
+        if (stop_ || done_) return;
+        ++in_flight_;
+        ++busy_;
+      }
+      std::string raw;
+      uint64_t seq = 0;
+      std::unique_ptr<Chunk> chunk;
+      try {
+        bool ok;
+        {
+          std::lock_guard<std::mutex> lock(read_mutex_);
+          seq = num_read_;
+          ok = num_read_ < limit_ && ReadChunk(stream_, &raw);
+          if (ok) ++num_read_;
+        }
+        if (!ok) {
+          std::lock_guard<std::mutex> lock(mutex_);
+          --in_flight_;
+          --busy_;
+          done_ = true;
+          num_chunks_ = seq;
+          cv_.notify_all();
+          return;
+        }
+        ArrayBuf buf(&raw[0], raw.size());
+        std::istream in(&buf);
+        chunk.reset(new Chunk);
+        chunk->Parse(in);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (seq < error_seq_) {
+          error_ = std::current_exception();
+          error_seq_ = seq;
+        }
+        --busy_;
+        done_ = true;
+        cv_.notify_all();
+        return;
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      ready_[seq] = std::move(chunk);
+      --busy_;
+      cv_.notify_all();
+    }
+  }
+
+  std::istream* stream_;
+  bool keep_order_;
+  size_t max_chunks_;
+  uint64_t limit_;
+  std::vector<std::thread> workers_;
+
+  // guards stream_ and num_read_.
+  std::mutex read_mutex_;
+  uint64_t num_read_{0};
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  // the parsed chunks by their order in the file.
+  std::map<uint64_t, std::unique_ptr<Chunk>> ready_;
+  // the chunks read and not yet taken by the caller.
+  size_t in_flight_{0};
+  uint64_t taken_{0};
+  // the number of chunks in the file, known once the end is read.
+  uint64_t num_chunks_{UINT64_MAX};
+  // the workers between reading a chunk and handing it over.
+  int busy_{0};
+  bool done_{false};
+  bool stop_{false};
+  // the error of the first chunk failed, by its order in the file.
+  std::exception_ptr error_;
+  uint64_t error_seq_{UINT64_MAX};
+
+  // the chunk whose records the caller is taking, and the next of them.
+  std::unique_ptr<Chunk> current_;
+  size_t pos_{0};
+};
+
 Scanner::Scanner(std::unique_ptr<std::istream> &&stream)
     : stream_(std::move(stream)), parser_(*stream_) {
   Reset();
@@ -32,25 +233,146 @@ Scanner::Scanner(const std::string &filename)
   Reset();
 }
 
-void Scanner::Reset() {
+Scanner::Scanner(std::unique_ptr<std::istream> &&stream,
+                 int num_threads,
+                 bool keep_order,
+                 size_t max_chunks)
+    : stream_(std::move(stream)),
+      parser_(*stream_),
+      num_threads_(num_threads),
+      keep_order_(keep_order),
+      max_chunks_(max_chunks > 0 ? max_chunks : 2 * num_threads) {
+  PADDLE_ENFORCE_GT(num_threads, 0, "The scanner needs a thread.");
+  Reset();
+}
+
+Scanner::Scanner(const std::string &filename,
+                 int num_threads,
+                 bool keep_order,
+                 size_t max_chunks)
+    : Scanner(std::unique_ptr<std::istream>(new std::ifstream(filename)),
+              num_threads,
+              keep_order,
+              max_chunks) {}
+
+Scanner::~Scanner() {}
+
+void Scanner::Reset() { Restart(begin_chunk_); }
+
+void Scanner::Restart(size_t chunk) {
+  prefetcher_.reset();
   stream_->clear();
-  stream_->seekg(0, std::ios::beg);
-  parser_.Init();
+  if (chunk == 0) {
+    stream_->seekg(0, std::ios::beg);
+  } else {
+    if (index_ == nullptr) {
+      LoadIndex();
+    }
+    PADDLE_ENFORCE_LE(
+        chunk, index_->NumChunks(), "The chunk is out of the file.");
+    if (chunk < index_->NumChunks()) {
+      stream_->seekg(index_->Offset(chunk), std::ios::beg);
+    } else {
+      stream_->seekg(0, std::ios::end);
+    }
+  }
+  chunk_ = chunk;
+  if (num_threads_ > 0) {
+    uint64_t limit = end_chunk_ == SIZE_MAX
+                         ? UINT64_MAX
+                         : end_chunk_ - std::min(chunk, end_chunk_);
+    prefetcher_.reset(new Prefetcher(
+        stream_.get(), num_threads_, keep_order_, max_chunks_, limit));
+    return;
+  }
+  if (chunk_ < end_chunk_) {
+    parser_.Init();
+  }
+}
+
+void Scanner::LoadIndex() {
+  // the stream is put back where it was, so that the chunks being read,
+  // ahead or not, go on from there.
+  std::unique_lock<std::mutex> lock;
+  if (prefetcher_ != nullptr) {
+    lock = std::unique_lock<std::mutex>(prefetcher_->read_mutex());
+  }
+  auto state = stream_->rdstate();
+  stream_->clear();
+  auto pos = stream_->tellg();
+  index_.reset(new ChunkIndex);
+  if (!index_->Read(*stream_)) {
+    index_->Build(*stream_);
+  }
+  stream_->clear();
+  stream_->seekg(pos);
+  stream_->setstate(state);
+}
+
+const ChunkIndex &Scanner::Index() {
+  if (index_ == nullptr) {
+    LoadIndex();
+  }
+  return *index_;
+}
+
+void Scanner::SetChunkRange(size_t begin, size_t end) {
+  if (index_ == nullptr) {
+    LoadIndex();
+  }
+  PADDLE_ENFORCE(begin <= end && end <= index_->NumChunks(),
+                 "The chunk range is out of the file.");
+  begin_chunk_ = begin;
+  end_chunk_ = end;
+  Reset();
+}
+
+void Scanner::SetShard(size_t shard, size_t num_shards) {
+  PADDLE_ENFORCE_LT(shard, num_shards, "The shard is out of range.");
+  if (index_ == nullptr) {
+    LoadIndex();
+  }
+  auto range = index_->Split(num_shards)[shard];
+  SetChunkRange(range.first, range.second);
+}
+
+void Scanner::SeekToChunk(size_t chunk) { Restart(chunk); }
+
+void Scanner::SeekToRecord(uint64_t record) {
+  if (index_ == nullptr) {
+    LoadIndex();
+  }
+  size_t chunk = index_->ChunkOf(record);
+  Restart(chunk);
+  for (uint64_t i = index_->FirstRecord(chunk); i < record; ++i) {
+    Next();
+  }
 }
 
 std::string Scanner::Next() {
-  if (stream_->eof()) {
+  if (prefetcher_ != nullptr) {
+    return prefetcher_->Next();
+  }
+  if (!HasNext()) {
     return "";
   }
 
   auto res = parser_.Next();
-  if (!parser_.HasNext() && HasNext()) {
-    parser_.Init();
+  if (!parser_.HasNext()) {
+    ++chunk_;
+    if (HasNext()) {
+      parser_.Init();
+    }
   }
   return res;
 }
 
-bool Scanner::HasNext() const { return !stream_->eof(); }
+bool Scanner::HasNext() const {
+  if (prefetcher_ != nullptr) {
+    return prefetcher_->HasNext();
+  }
+  return !stream_->eof() && chunk_ < end_chunk_;
+}
 }  // namespace recordio
 }  // namespace fluid
 }  // namespace paddle
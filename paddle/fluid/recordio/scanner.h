@@ -14,11 +14,13 @@
 
 #pragma once
 
+#include <cstdint>
 #include <fstream>
 #include <memory>
 #include <string>
 
 #include "paddle/fluid/recordio/chunk.h"
+#include "paddle/fluid/recordio/chunk_index.h"
 
 namespace paddle {
 namespace fluid {
@@ -30,15 +32,64 @@ class Scanner {
 
   explicit Scanner(const std::string& filename);
 
+  // Reads, checks and decompresses whole chunks ahead of the caller on
+  // num_threads threads, holding at most max_chunks chunks, or twice
+  // num_threads if it is 0.  The records come in the order of the file, or
+  // if keep_order is false, in the order their chunks are ready.
+  Scanner(std::unique_ptr<std::istream>&& stream,
+          int num_threads,
+          bool keep_order = true,
+          size_t max_chunks = 0);
+
+  Scanner(const std::string& filename,
+          int num_threads,
+          bool keep_order = true,
+          size_t max_chunks = 0);
+
+  ~Scanner();
+
+  // moves to the first chunk of the range set by SetChunkRange.
   void Reset();
 
   std::string Next();
 
+  // blocks until the next chunk is ready when reading ahead.
   bool HasNext() const;
 
+  // the index of the file, read from its end, or else built by seeking
+  // from chunk header to chunk header.  The scanner keeps its position.
+  const ChunkIndex& Index();
+
+  // limits the scanner to the chunks [begin, end), and resets it.
+  void SetChunkRange(size_t begin, size_t end);
+
+  // limits the scanner to the shard-th of num_shards disjoint ranges of
+  // chunks, which hold about the same number of records.
+  void SetShard(size_t shard, size_t num_shards);
+
+  // moves to the first record of a chunk, or to a record, counted from the
+  // start of the file.  The end of the chunk range is kept.
+  void SeekToChunk(size_t chunk);
+  void SeekToRecord(uint64_t record);
+
  private:
+  class Prefetcher;
+
+  void LoadIndex();
+  // positions the stream at a chunk and starts reading from there.
+  void Restart(size_t chunk);
+
   std::unique_ptr<std::istream> stream_;
   ChunkParser parser_;
+  std::unique_ptr<ChunkIndex> index_;
+  size_t begin_chunk_{0};
+  size_t end_chunk_{SIZE_MAX};
+  // the chunk being read, when not reading ahead.
+  size_t chunk_{0};
+  int num_threads_{0};
+  bool keep_order_{true};
+  size_t max_chunks_{0};
+  std::unique_ptr<Prefetcher> prefetcher_;
 };
 }  // namespace recordio
 }  // namespace fluid
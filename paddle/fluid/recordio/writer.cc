@@ -13,6 +13,7 @@
 // limitations under the License.
 #include "paddle/fluid/recordio/writer.h"
 
+#include <glog/logging.h>
 #include <string>
 
 #include "paddle/fluid/platform/enforce.h"
@@ -22,6 +23,7 @@ namespace fluid {
 namespace recordio {
 
 void Writer::Write(const std::string& record) {
+  PADDLE_ENFORCE(!closed_, "Cannot write to a closed writer.");
   cur_chunk_.Add(record);
   if (cur_chunk_.NumRecords() >= max_num_records_in_chunk_) {
     Flush();
@@ -29,12 +31,38 @@ void Writer::Write(const std::string& record) {
 }
 
 void Writer::Flush() {
+  if (write_index_ && !cur_chunk_.Empty()) {
+    auto offset = static_cast<int64_t>(stream_.tellp());
+    PADDLE_ENFORCE_GE(offset, 0, "An indexed stream must tell its position.");
+    index_.Add(static_cast<uint64_t>(offset),
+               static_cast<uint32_t>(cur_chunk_.NumRecords()));
+  }
   cur_chunk_.Write(stream_, compressor_);
   cur_chunk_.Clear();
 }
 
+void Writer::Close() {
+  if (closed_) {
+    return;
+  }
+  Flush();
+  if (write_index_) {
+    index_.Write(stream_, static_cast<uint64_t>(stream_.tellp()));
+  }
+  closed_ = true;
+}
+
 Writer::~Writer() {
   PADDLE_ENFORCE(cur_chunk_.Empty(), "Writer must be flushed when destroy.");
+  if (write_index_) {
+    // a destructor must not throw, so an error is only logged; call Close
+    // to have it raised.
+    try {
+      Close();
+    } catch (std::exception& e) {
+      LOG(ERROR) << "Cannot write the index of the chunks: " << e.what();
+    }
+  }
 }
 
 }  // namespace recordio
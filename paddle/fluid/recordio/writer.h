@@ -16,23 +16,33 @@
 #include <string>
 
 #include "paddle/fluid/recordio/chunk.h"
+#include "paddle/fluid/recordio/chunk_index.h"
 namespace paddle {
 namespace fluid {
 namespace recordio {
 
 class Writer {
  public:
+  // If write_index is set, a ChunkIndex of the chunks is written after
+  // them when the writer is closed or destroyed.
   Writer(std::ostream* sout,
          Compressor compressor,
-         size_t max_num_records_in_chunk = 1000)
+         size_t max_num_records_in_chunk = 1000,
+         bool write_index = false)
       : stream_(*sout),
         max_num_records_in_chunk_(max_num_records_in_chunk),
-        compressor_(compressor) {}
+        cur_chunk_(compressor),
+        compressor_(compressor),
+        write_index_(write_index) {}
 
   void Write(const std::string& record);
 
   void Flush();
 
+  // flushes the records and writes the index; nothing can be written after.
+  // The destructor closes an indexed writer too, but only logs its errors.
+  void Close();
+
   ~Writer();
 
  private:
@@ -40,6 +50,9 @@ class Writer {
   size_t max_num_records_in_chunk_;
   Chunk cur_chunk_;
   Compressor compressor_;
+  bool write_index_;
+  bool closed_{false};
+  ChunkIndex index_;
 };
 
 }  // namespace recordio
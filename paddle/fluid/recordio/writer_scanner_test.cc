@@ -12,10 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstring>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/recordio/scanner.h"
 #include "paddle/fluid/recordio/writer.h"
 
@@ -70,3 +73,140 @@ TEST(WriterScanner, TinyChunk) {
     ASSERT_FALSE(scanner.HasNext());
   }
 }
+
+TEST(WriterScanner, Prefetch) {
+  std::string data;
+  {
+    std::stringstream stream;
+    paddle::fluid::recordio::Writer writer(
+        &stream, paddle::fluid::recordio::Compressor::kSnappy, 7);
+    for (int i = 0; i < 1000; ++i) writer.Write(std::to_string(i));
+    writer.Flush();
+    data = stream.str();
+  }
+
+  for (bool keep_order : {true, false}) {
+    std::unique_ptr<std::istream> stream_ptr(new std::stringstream(data));
+    paddle::fluid::recordio::Scanner scanner(
+        std::move(stream_ptr), 4, keep_order, 3);
+    for (int round = 0; round < 2; ++round) {
+      std::vector<bool> seen(1000, false);
+      for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(scanner.HasNext());
+        int record = std::stoi(scanner.Next());
+        if (keep_order) {
+          ASSERT_EQ(record, i);
+        }
+        ASSERT_FALSE(seen[record]);
+        seen[record] = true;
+      }
+      ASSERT_FALSE(scanner.HasNext());
+      ASSERT_EQ(scanner.Next(), "");
+      scanner.Reset();
+    }
+  }
+
+  // A corrupted chunk is reported by the caller's HasNext, once the
+  // records of the chunks before it are taken.
+  data[data.size() - 1] ^= 1;
+  std::unique_ptr<std::istream> stream_ptr(new std::stringstream(data));
+  paddle::fluid::recordio::Scanner scanner(std::move(stream_ptr), 2);
+  int count = 0;
+  auto scan = [&scanner, &count] {
+    while (scanner.HasNext()) {
+      ASSERT_EQ(scanner.Next(), std::to_string(count++));
+    }
+  };
+  ASSERT_THROW(scan(), paddle::fluid::platform::EnforceNotMet);
+  ASSERT_EQ(count, 994);
+}
+
+TEST(WriterScanner, Index) {
+  auto write = [](bool write_index) {
+    std::stringstream stream;
+    paddle::fluid::recordio::Writer writer(
+        &stream, paddle::fluid::recordio::Compressor::kSnappy, 7, write_index);
+    for (int i = 0; i < 100; ++i) writer.Write(std::to_string(i));
+    writer.Close();
+    return stream.str();
+  };
+
+  for (int num_threads : {0, 3}) {
+    // Without an index, it is built from the chunk headers.
+    for (bool indexed : {true, false}) {
+      std::unique_ptr<std::istream> stream_ptr(
+          new std::stringstream(write(indexed)));
+      std::unique_ptr<paddle::fluid::recordio::Scanner> scanner(
+          num_threads > 0
+              ? new paddle::fluid::recordio::Scanner(std::move(stream_ptr),
+                                                     num_threads)
+              : new paddle::fluid::recordio::Scanner(std::move(stream_ptr)));
+
+      // Reading the index keeps the position.
+      ASSERT_EQ(scanner->Next(), "0");
+      ASSERT_EQ(scanner->Next(), "1");
+      EXPECT_EQ(scanner->Index().NumChunks(), 15UL);
+      ASSERT_EQ(scanner->Next(), "2");
+
+      // The index ends the chunks.
+      int count = 3;
+      while (scanner->HasNext()) {
+        ASSERT_EQ(scanner->Next(), std::to_string(count++));
+      }
+      ASSERT_EQ(count, 100);
+
+      EXPECT_EQ(scanner->Index().NumChunks(), 15UL);
+      EXPECT_EQ(scanner->Index().NumRecords(), 100UL);
+      scanner->SeekToRecord(50);
+      ASSERT_EQ(scanner->Next(), "50");
+      scanner->SeekToChunk(3);
+      ASSERT_EQ(scanner->Next(), "21");
+
+      std::vector<int> seen(100, 0);
+      for (size_t shard = 0; shard < 4; ++shard) {
+        scanner->SetShard(shard, 4);
+        int shard_count = 0;
+        while (scanner->HasNext()) {
+          ++seen[std::stoi(scanner->Next())];
+          ++shard_count;
+        }
+        EXPECT_GE(shard_count, 21);
+        EXPECT_LE(shard_count, 28);
+      }
+      ASSERT_EQ(std::vector<int>(100, 1), seen);
+
+      scanner->SetChunkRange(14, 15);
+      ASSERT_EQ(scanner->Next(), "98");
+      scanner->Reset();
+      ASSERT_EQ(scanner->Next(), "98");
+      ASSERT_EQ(scanner->Next(), "99");
+      ASSERT_FALSE(scanner->HasNext());
+    }
+  }
+}
+
+TEST(WriterScanner, IndexLookalike) {
+  // An unindexed file whose last record ends like an index trailer.
+  std::string last(12, '\0');
+  uint32_t magic = paddle::fluid::recordio::kIndexMagicNumber;
+  std::memcpy(&last[8], &magic, sizeof(magic));
+  std::stringstream* stream = new std::stringstream();
+  {
+    paddle::fluid::recordio::Writer writer(
+        stream, paddle::fluid::recordio::Compressor::kNoCompress, 2);
+    writer.Write("A");
+    writer.Write("B");
+    writer.Write("C");
+    writer.Write(last);
+    writer.Flush();
+  }
+
+  std::unique_ptr<std::istream> stream_ptr(stream);
+  paddle::fluid::recordio::Scanner scanner(std::move(stream_ptr));
+  EXPECT_EQ(scanner.Index().NumChunks(), 2UL);
+  EXPECT_EQ(scanner.Index().NumRecords(), 4UL);
+  scanner.SeekToRecord(2);
+  ASSERT_EQ(scanner.Next(), "C");
+  ASSERT_EQ(scanner.Next(), last);
+  ASSERT_FALSE(scanner.HasNext());
+}
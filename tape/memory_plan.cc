@@ -0,0 +1,183 @@
+// Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/memory_plan.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/memory/memory.h"
+#include "paddle/fluid/platform/place.h"
+#include "src/tape.h"
+
+namespace paddle {
+namespace tape {
+
+namespace {
+
+constexpr size_t kAlignment = 64;
+constexpr size_t kNotDefined = std::numeric_limits<size_t>::max();
+
+size_t AlignUp(size_t size) {
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+// Returns 0 if the size is not known before running.
+size_t TensorBytes(const framework::VarDesc &desc) {
+  if (desc.GetType() != framework::proto::VarType::LOD_TENSOR) return 0;
+  int64_t numel = 1;
+  for (auto dim : desc.GetShape()) {
+    if (dim < 0) return 0;
+    numel *= dim;
+  }
+  return numel *
+         framework::SizeOfType(framework::ToTypeIndex(desc.GetDataType()));
+}
+
+// The buffer of the last plan is kept after its tape is destroyed, so
+// that a training loop recording the same program in every iteration
+// does not allocate.
+std::shared_ptr<uint8_t> AcquireBuffer(size_t size) {
+  static std::shared_ptr<uint8_t> cached;
+  static size_t cached_size = 0;
+  if (cached && cached.use_count() == 1 && cached_size >= size) {
+    return cached;
+  }
+
+  platform::CPUPlace place;
+  std::shared_ptr<uint8_t> buffer(
+      static_cast<uint8_t *>(memory::Alloc(place, size)),
+      memory::PODDeleter<uint8_t, platform::CPUPlace>(place));
+  PADDLE_ENFORCE_NOT_NULL(buffer, "Insufficient memory for the memory plan");
+  if (size >= cached_size) {
+    cached = buffer;
+    cached_size = size;
+  }
+  return buffer;
+}
+
+struct Lifetime {
+  size_t def = kNotDefined;  // the op writing the tensor first
+  size_t last_use = 0;
+  bool read_before_def = false;
+  bool read_after_def = false;
+  int64_t tape_refs = 0;  // handles held by the ops
+  int64_t use_count = 0;
+};
+
+}  // namespace
+
+MemoryPlan::MemoryPlan(const std::vector<const OpHandle *> &ops) {
+  std::unordered_map<Variable *, Lifetime> lifetimes;
+  for (size_t i = 0; i < ops.size(); ++i) {
+    for (auto &param2vars : ops[i]->inputs_) {
+      for (auto &var : param2vars.second) {
+        Lifetime &lifetime = lifetimes[var.get()];
+        if (lifetime.def == kNotDefined) {
+          lifetime.read_before_def = true;
+        } else {
+          lifetime.read_after_def = true;
+        }
+        lifetime.last_use = i;
+        lifetime.tape_refs++;
+        lifetime.use_count = var.use_count();
+      }
+    }
+    for (auto &param2vars : ops[i]->outputs_) {
+      for (auto &var : param2vars.second) {
+        Lifetime &lifetime = lifetimes[var.get()];
+        if (lifetime.def == kNotDefined) lifetime.def = i;
+        lifetime.last_use = i;
+        lifetime.tape_refs++;
+        lifetime.use_count = var.use_count();
+      }
+    }
+  }
+
+  struct Candidate {
+    Variable *var;
+    size_t size;
+    size_t def;
+    size_t last_use;
+  };
+  std::vector<Candidate> candidates;
+  for (auto &pair : lifetimes) {
+    const Lifetime &lifetime = pair.second;
+    // Someone outside the tape may read the tensor after it is reused.
+    if (lifetime.use_count != lifetime.tape_refs) continue;
+    if (lifetime.read_before_def || !lifetime.read_after_def) continue;
+    size_t size = TensorBytes(pair.first->Desc());
+    if (size == 0) continue;
+    candidates.push_back(
+        Candidate{pair.first, AlignUp(size), lifetime.def, lifetime.last_use});
+  }
+
+  // Greedy by size: place the largest tensors first, each at the lowest
+  // offset not used by a placed tensor alive at the same time.
+  std::sort(candidates.begin(),
+            candidates.end(),
+            [](const Candidate &a, const Candidate &b) {
+              return a.size != b.size ? a.size > b.size : a.def < b.def;
+            });
+  std::vector<Candidate> placed;
+  std::vector<std::pair<size_t, size_t>> conflicts;  // (offset, size)
+  for (auto &candidate : candidates) {
+    conflicts.clear();
+    for (auto &other : placed) {
+      if (other.def <= candidate.last_use && candidate.def <= other.last_use) {
+        conflicts.emplace_back(slots_[other.var].offset, other.size);
+      }
+    }
+    std::sort(conflicts.begin(), conflicts.end());
+
+    size_t offset = 0;
+    for (auto &conflict : conflicts) {
+      if (offset + candidate.size <= conflict.first) break;
+      offset = std::max(offset, conflict.first + conflict.second);
+    }
+    slots_[candidate.var] = Slot{offset, candidate.size, false};
+    placed.push_back(candidate);
+    planned_bytes_ = std::max(planned_bytes_, offset + candidate.size);
+    naive_bytes_ += candidate.size;
+  }
+
+  if (planned_bytes_ > 0) buffer_ = AcquireBuffer(planned_bytes_);
+}
+
+bool MemoryPlan::Bind(Variable *var) {
+  auto it = slots_.find(var);
+  if (it == slots_.end() || it->second.bound) return false;
+  it->second.bound = true;
+
+  // If the kernel finds the tensor larger than planned at runtime,
+  // mutable_data allocates it on its own.  The tensor keeps the buffer
+  // alive, as it may be shared with a tensor outliving the tape.
+  auto &desc = var->Desc();
+  auto *tensor = var->MutableVar()->GetMutable<framework::LoDTensor>();
+  auto buffer = buffer_;
+  tensor->Resize(framework::make_ddim(desc.GetShape()));
+  tensor->ShareExternalData(buffer_.get() + it->second.offset,
+                            it->second.size,
+                            platform::CPUPlace(),
+                            framework::ToTypeIndex(desc.GetDataType()),
+                            [buffer](void *) {});
+  return true;
+}
+
+}  // namespace tape
+}  // namespace paddle
@@ -0,0 +1,70 @@
+// Copyright (c) 2018 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "src/variable.h"
+
+namespace paddle {
+namespace tape {
+
+struct OpHandle;
+
+/*
+ * MemoryPlan places the intermediate LoDTensors of a recorded program in
+ * one buffer.  Tensors whose lifetimes, from the op writing them to
+ * their last consumer, do not overlap share memory.
+ *
+ * Only tensors with a fully known shape that are written before they
+ * are read, read afterwards, and referenced by nobody but the tape are
+ * planned.  Anything else, e.g., the loss or parameter gradients, is
+ * allocated as before.
+ */
+class MemoryPlan {
+ public:
+  // ops are the forward and backward ops in execution order.
+  explicit MemoryPlan(const std::vector<const OpHandle *> &ops);
+
+  // Point the tensor of var into the buffer when it is first written.
+  // Returns false if var is not planned or already bound.
+  bool Bind(Variable *var);
+
+  size_t NumTensors() const { return slots_.size(); }
+
+  // The size of the buffer, i.e., the planned peak.
+  size_t PlannedBytes() const { return planned_bytes_; }
+
+  // The sum of the tensor sizes, i.e., the peak when each tensor is
+  // allocated on its own and freed with the tape.
+  size_t NaiveBytes() const { return naive_bytes_; }
+
+ private:
+  struct Slot {
+    size_t offset;
+    size_t size;
+    bool bound;
+  };
+
+  std::unordered_map<Variable *, Slot> slots_;
+  size_t planned_bytes_ = 0;
+  size_t naive_bytes_ = 0;
+  std::shared_ptr<uint8_t> buffer_;
+};
+
+}  // namespace tape
+}  // namespace paddle
@@ -167,6 +167,7 @@ void Tape::Forward() {
     for (auto &param2var : op.outputs_) {
       for (auto &var : param2var.second) {
         var->InitializeVariable();
+        if (memory_plan_) memory_plan_->Bind(var.get());
       }
     }
 
@@ -180,10 +181,24 @@ void Tape::Forward() {
   LOG(INFO) << "Finishing forward -------------------------";
 }
 
+void Tape::PlanMemory() {
+  std::vector<const OpHandle *> ops;
+  for (auto &op : tape_) ops.push_back(&op);
+  for (auto &op : backward_tape_->tape_) ops.push_back(&op);
+  memory_plan_.reset(new MemoryPlan(ops));
+  backward_tape_->memory_plan_ = memory_plan_;
+  LOG(INFO) << "Planned " << memory_plan_->NumTensors() << " tensors in "
+            << memory_plan_->PlannedBytes() << " bytes, "
+            << memory_plan_->NaiveBytes() << " bytes without the plan";
+}
+
 void Tape::Backward(VariableHandle target) {
   PADDLE_ENFORCE(!has_been_backwarded_);
 
-  Forward();
+  // The backward tape is recorded before running the forward one, so
+  // that the memory of the whole program can be planned.  If Forward()
+  // has run already, the tensors it wrote cannot be moved.
+  bool plan_memory = current_position_ == 0;
 
   // TODO(tonyyang-svail): check output of last op is target
   backward_tape_.reset(new Tape());
@@ -251,6 +266,8 @@ void Tape::Backward(VariableHandle target) {
     // TODO(tonyyang-svail): Sum var grad is necessary
   }
 
+  if (plan_memory) PlanMemory();
+  Forward();
   backward_tape_->Forward();
   has_been_backwarded_ = true;
 }
@@ -260,6 +277,9 @@ Tape &get_global_tape() {
   return T;
 }
 
-void reset_global_tape() { get_global_tape() = Tape(); }
+void reset_global_tape() {
+  get_global_tape() = Tape();
+  framework::IncreaseGlobalStep();
+}
 }  // namespace tape
 }  // namespace paddle
@@ -18,6 +18,7 @@
 #include <string>
 #include <vector>
 
+#include "src/memory_plan.h"
 #include "src/variable.h"
 
 namespace paddle {
@@ -49,16 +50,25 @@ class Tape {
 
   bool HasBeenBackwarded() { return has_been_backwarded_; }
 
+  // The plan of the intermediate tensors of the forward and backward
+  // tapes, or nullptr if Forward() has run before Backward().
+  const MemoryPlan *GetMemoryPlan() const { return memory_plan_.get(); }
+
  private:
+  void PlanMemory();
+
   bool has_been_backwarded_ = false;
   size_t current_position_ = 0;
 
   std::vector<OpHandle> tape_;
   std::shared_ptr<Tape> backward_tape_;
+  // Shared with backward_tape_
+  std::shared_ptr<MemoryPlan> memory_plan_;
 };
 
 Tape &get_global_tape();
 
+// Starts a new iteration, which also advances framework::GetGlobalStep.
 void reset_global_tape();
 }  // namespace tape
 }  // namespace paddle
@@ -59,6 +59,30 @@ TEST(Tape, TestMLP) {
   }
 }
 
+TEST(Tape, TestMemoryPlan) {
+  Linear linear1(3, 3, "relu");
+  Linear linear2(3, 3, "relu");
+  Mean mean;
+
+  paddle::framework::AttributeMap attrs;
+  attrs["dtype"] = paddle::framework::proto::VarType::Type::VarType_Type_FP32;
+  attrs["shape"] = std::vector<int>{3, 3};
+  attrs["value"] = 1.0f;
+  Fill filler("fill_constant", attrs);
+
+  reset_global_tape();
+  VariableHandle input(new Variable("input"));
+  filler(input);
+  auto loss = mean(linear2(linear1(input)));
+  get_global_tape().Backward(loss);
+
+  // The activations and their gradients share the planned buffer.
+  auto *plan = get_global_tape().GetMemoryPlan();
+  ASSERT_NE(plan, nullptr);
+  EXPECT_GT(plan->NumTensors(), 0UL);
+  EXPECT_LT(plan->PlannedBytes(), plan->NaiveBytes());
+}
+
 int main(int argc, char **argv) {
   std::vector<paddle::platform::Place> places;
   places.emplace_back(paddle::platform::CPUPlace());